@@ -0,0 +1,55 @@
+'use strict';
+
+// Call overhead with the smallest possible java work: static, instance and constructor calls, sync
+// and async.
+
+var java = require('../testHelpers').java;
+
+var test;
+
+module.exports = {
+  staticSync: {
+    fn: function() {
+      java.callStaticMethodSync('Test', 'staticMethod', 1);
+    }
+  },
+
+  staticAsync: {
+    async: true,
+    fn: function(callback) {
+      java.callStaticMethod('Test', 'staticMethod', 1, callback);
+    }
+  },
+
+  instanceSync: {
+    setup: function() {
+      test = java.newInstanceSync('Test', 5);
+    },
+    fn: function() {
+      test.getIntSync();
+    }
+  },
+
+  instanceAsync: {
+    async: true,
+    setup: function() {
+      test = java.newInstanceSync('Test', 5);
+    },
+    fn: function(callback) {
+      test.getInt(callback);
+    }
+  },
+
+  constructorSync: {
+    fn: function() {
+      java.newInstanceSync('Test', 5);
+    }
+  },
+
+  constructorAsync: {
+    async: true,
+    fn: function(callback) {
+      java.newInstance('Test', 5, callback);
+    }
+  }
+};
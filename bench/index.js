@@ -0,0 +1,204 @@
+'use strict';
+
+// Runs the bridge benchmarks and prints the results as JSON.
+//
+//   node bench [--filter <regexp>] [--out <file>] [--compare <baseline.json>] [--threshold <percent>]
+//
+// Each suite is a *-bench.js file in this directory exporting benchmarks by name. A benchmark is
+// either { fn: function() {} } for synchronous work or { async: true, fn: function(callback) {} },
+// with an optional setup function that runs once before timing and iterations to override the
+// number of calls per sample.
+
+var fs = require('fs');
+var path = require('path');
+var os = require('os');
+var java = require('../testHelpers').java;
+
+var WARMUP_SAMPLES = 3;
+var SAMPLES = 15;
+var DEFAULT_ITERATIONS = 1000;
+
+function parseArgs(argv) {
+  var options = { filter: null, out: null, compare: null, threshold: 20 };
+  for (var i = 0; i < argv.length; i++) {
+    switch (argv[i]) {
+      case '--filter': options.filter = new RegExp(argv[++i]); break;
+      case '--out': options.out = argv[++i]; break;
+      case '--compare': options.compare = argv[++i]; break;
+      case '--threshold': options.threshold = parseFloat(argv[++i]); break;
+      default: throw new Error("Unknown argument " + argv[i]);
+    }
+  }
+  return options;
+}
+
+function nowNs() {
+  var t = process.hrtime();
+  return t[0] * 1e9 + t[1];
+}
+
+function percentile(sorted, p) {
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+function liveRefs() {
+  return java.refStats().globalRefs.totalLive;
+}
+
+// times one sample of iterations calls, calling callback with the elapsed nanoseconds
+function runSample(bench, iterations, callback) {
+  var start = nowNs();
+  if (!bench.async) {
+    for (var i = 0; i < iterations; i++) {
+      bench.fn();
+    }
+    return callback(null, nowNs() - start);
+  }
+
+  var remaining = iterations;
+  function next(err) {
+    if (err) {
+      return callback(err);
+    }
+    if (remaining-- === 0) {
+      return callback(null, nowNs() - start);
+    }
+    bench.fn(next);
+  }
+  next();
+}
+
+function runBench(name, bench, callback) {
+  var iterations = bench.iterations || DEFAULT_ITERATIONS;
+  var samples = [];
+  var sampleCount = 0;
+  var refsBefore;
+
+  if (bench.setup) {
+    bench.setup();
+  }
+
+  function next() {
+    runSample(bench, iterations, function(err, elapsedNs) {
+      if (err) {
+        return callback(err);
+      }
+      sampleCount++;
+      if (sampleCount === WARMUP_SAMPLES) {
+        refsBefore = liveRefs();
+      } else if (sampleCount > WARMUP_SAMPLES) {
+        samples.push(elapsedNs / iterations);
+      }
+      if (sampleCount < WARMUP_SAMPLES + SAMPLES) {
+        return setImmediate(next);
+      }
+
+      var sorted = samples.slice().sort(function(a, b) { return a - b; });
+      var total = samples.reduce(function(sum, ns) { return sum + ns; }, 0);
+      var meanNs = total / samples.length;
+      callback(null, {
+        name: name,
+        iterations: iterations,
+        samples: samples.length,
+        opsPerSec: Math.round(1e9 / meanNs),
+        meanUs: meanNs / 1000,
+        // spread of the per-sample means, individual calls are not timed
+        medianSampleMeanUs: percentile(sorted, 0.5) / 1000,
+        maxSampleMeanUs: sorted[sorted.length - 1] / 1000,
+        minSampleMeanUs: sorted[0] / 1000,
+        liveRefsDelta: liveRefs() - refsBefore
+      });
+    });
+  }
+  next();
+}
+
+function loadSuites(filter) {
+  var benches = [];
+  fs.readdirSync(__dirname).sort().forEach(function(file) {
+    if (!/-bench\.js$/.test(file)) {
+      return;
+    }
+    var suiteName = file.replace(/-bench\.js$/, '');
+    var suite = require(path.join(__dirname, file));
+    Object.keys(suite).forEach(function(benchName) {
+      var name = suiteName + '.' + benchName;
+      if (!filter || filter.test(name)) {
+        benches.push({ name: name, bench: suite[benchName] });
+      }
+    });
+  });
+  return benches;
+}
+
+// a benchmark regressed when its mean time grew by more than threshold percent
+function compare(results, baseline, threshold) {
+  var baselineByName = {};
+  baseline.results.forEach(function(result) {
+    baselineByName[result.name] = result;
+  });
+  return results.filter(function(result) {
+    var base = baselineByName[result.name];
+    if (!base) {
+      return false;
+    }
+    result.baselineMeanUs = base.meanUs;
+    result.changePercent = (result.meanUs - base.meanUs) / base.meanUs * 100;
+    return result.changePercent > threshold;
+  });
+}
+
+function main() {
+  var options = parseArgs(process.argv.slice(2));
+  var benches = loadSuites(options.filter);
+  var results = [];
+
+  function next(i) {
+    if (i === benches.length) {
+      return done();
+    }
+    process.stderr.write(benches[i].name + '... ');
+    runBench(benches[i].name, benches[i].bench, function(err, result) {
+      if (err) {
+        process.stderr.write('failed\n');
+        throw err;
+      }
+      process.stderr.write(result.meanUs.toFixed(2) + 'us\n');
+      results.push(result);
+      next(i + 1);
+    });
+  }
+
+  function done() {
+    var report = {
+      node: process.version,
+      platform: process.platform,
+      arch: process.arch,
+      cpus: os.cpus().length,
+      date: new Date().toISOString(),
+      results: results
+    };
+    var regressions = [];
+    if (options.compare) {
+      regressions = compare(results, JSON.parse(fs.readFileSync(options.compare, 'utf8')), options.threshold);
+      report.regressions = regressions.map(function(result) { return result.name; });
+    }
+
+    var json = JSON.stringify(report, null, 2);
+    if (options.out) {
+      fs.writeFileSync(options.out, json);
+    } else {
+      console.log(json);
+    }
+
+    regressions.forEach(function(result) {
+      process.stderr.write('REGRESSION ' + result.name + ': ' + result.baselineMeanUs.toFixed(2) + 'us -> '
+        + result.meanUs.toFixed(2) + 'us (+' + result.changePercent.toFixed(1) + '%)\n');
+    });
+    process.exit(regressions.length > 0 ? 1 : 0);
+  }
+
+  next(0);
+}
+
+main();
@@ -0,0 +1,92 @@
+'use strict';
+
+// Argument and return value conversion per type. Each call does almost no java work, so the time is
+// dominated by converting the values in src/utils.cpp.
+
+var java = require('../testHelpers').java;
+
+var ARRAY_LENGTH = 100;
+
+var stringArray;
+var byteArray;
+var numbers;
+var buffer;
+
+function fill(length, value) {
+  var result = [];
+  for (var i = 0; i < length; i++) {
+    result.push(value);
+  }
+  return result;
+}
+
+module.exports = {
+  int: {
+    fn: function() {
+      java.callStaticMethodSync('java.lang.Math', 'abs', -42);
+    }
+  },
+
+  double: {
+    fn: function() {
+      java.callStaticMethodSync('java.lang.Math', 'abs', -42.5);
+    }
+  },
+
+  string: {
+    fn: function() {
+      java.callStaticMethodSync('java.lang.String', 'valueOf', 'a short string argument');
+    }
+  },
+
+  jsArrayArgument: {
+    setup: function() {
+      numbers = fill(ARRAY_LENGTH, 42);
+    },
+    fn: function() {
+      java.callStaticMethodSync('java.util.Arrays', 'hashCode', numbers);
+    }
+  },
+
+  stringArrayReturn: {
+    iterations: 200,
+    setup: function() {
+      stringArray = java.newArray('java.lang.String', fill(ARRAY_LENGTH, 'item'));
+    },
+    fn: function() {
+      java.callStaticMethodSync('java.util.Arrays', 'copyOf', stringArray, ARRAY_LENGTH);
+    }
+  },
+
+  byteArrayFromArray: {
+    iterations: 200,
+    setup: function() {
+      numbers = fill(4096, 7);
+    },
+    fn: function() {
+      java.newArray('byte', numbers);
+    }
+  },
+
+  byteArrayFromBuffer: {
+    iterations: 200,
+    setup: function() {
+      buffer = new Buffer(4096);
+      buffer.fill(7);
+    },
+    fn: function() {
+      java.newArray('byte', buffer);
+    }
+  },
+
+  byteArrayArgument: {
+    setup: function() {
+      buffer = new Buffer(4096);
+      buffer.fill(7);
+      byteArray = java.newArray('byte', buffer);
+    },
+    fn: function() {
+      java.callStaticMethodSync('java.util.Arrays', 'hashCode', byteArray);
+    }
+  }
+};
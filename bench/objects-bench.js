@@ -0,0 +1,85 @@
+'use strict';
+
+// Wrapper creation, field access and exceptions. Wrapping a java object reflects over all of its
+// methods, so classes with many methods are measured separately.
+
+var java = require('../testHelpers').java;
+
+var test;
+
+module.exports = {
+  wrapSmallClass: {
+    fn: function() {
+      java.newInstanceSync('Test');
+    }
+  },
+
+  wrapManyMethods: {
+    iterations: 200,
+    fn: function() {
+      java.newInstanceSync('java.lang.StringBuilder');
+    }
+  },
+
+  wrapReturnedObject: {
+    iterations: 200,
+    setup: function() {
+      test = java.newInstanceSync('java.util.ArrayList');
+      test.addSync('item');
+    },
+    fn: function() {
+      test.iteratorSync();
+    }
+  },
+
+  fieldGet: {
+    setup: function() {
+      test = java.newInstanceSync('Test');
+    },
+    fn: function() {
+      return test.nonstaticInt;
+    }
+  },
+
+  fieldSet: {
+    setup: function() {
+      test = java.newInstanceSync('Test');
+    },
+    fn: function() {
+      test.nonstaticInt = 42;
+    }
+  },
+
+  staticFieldGet: {
+    fn: function() {
+      java.getStaticFieldValue('Test', 'staticFieldInt');
+    }
+  },
+
+  exceptionSync: {
+    iterations: 100,
+    setup: function() {
+      test = java.newInstanceSync('java.lang.Exception', 'bench');
+    },
+    fn: function() {
+      try {
+        java.callStaticMethodSync('Test', 'staticMethodThrows', test);
+      } catch (e) {
+        // expected
+      }
+    }
+  },
+
+  exceptionAsync: {
+    async: true,
+    iterations: 100,
+    setup: function() {
+      test = java.newInstanceSync('java.lang.Exception', 'bench');
+    },
+    fn: function(callback) {
+      java.callStaticMethod('Test', 'staticMethodThrows', test, function() {
+        callback();
+      });
+    }
+  }
+};
@@ -0,0 +1,43 @@
+'use strict';
+
+// Proxy round trips: java calling back into javascript, both from the v8 thread and from a java
+// thread that has to hand the call to the event loop and wait for it.
+
+var java = require('../testHelpers').java;
+
+var runInterface;
+var proxy;
+var executor;
+var callable;
+
+module.exports = {
+  fromV8Thread: {
+    setup: function() {
+      runInterface = java.newInstanceSync('RunInterface');
+      proxy = java.newProxy('RunInterface$InterfaceWithReturn', {
+        run: function(i) {
+          return i + 1;
+        }
+      });
+    },
+    fn: function() {
+      runInterface.runWithReturnSync(proxy);
+    }
+  },
+
+  fromJavaThread: {
+    async: true,
+    iterations: 50,
+    setup: function() {
+      executor = java.callStaticMethodSync('java.util.concurrent.Executors', 'newSingleThreadExecutor');
+      callable = java.newProxy('java.util.concurrent.Callable', {
+        call: function() {
+          return 42;
+        }
+      });
+    },
+    fn: function(callback) {
+      executor.submitSync(callable).get(callback);
+    }
+  }
+};
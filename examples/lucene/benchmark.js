@@ -0,0 +1,276 @@
+#!/usr/bin/env node
+
+// Indexes a generated corpus into a RAMDirectory and runs a mix of queries against it, once with the
+// Sync methods and once with callbacks, reporting throughput, latency and how much of the time the
+// bridge spent converting arguments and results.
+//
+//   node benchmark.js [--docs 5000] [--queries 2000] [--concurrency 4] [--seed 1] [--out results.json]
+
+var fs = require("fs");
+var java = require("../../");
+java.classpath.push(__dirname + "/lucene-core-3.5.0.jar");
+
+var WORDS = ("freedom progress critic importance achievement welfare ignorance factor brother error " +
+  "man work end case individual recognition universal concern many depend nothing take away save " +
+  "other free worth having connote err theodore friedrich ayn mohandas remember secondary " +
+  "accomplished things rests largely inevitable great").split(" ");
+
+var QUERY_TEMPLATES = [
+  function(r) { return pick(r); },
+  function(r) { return pick(r) + " OR " + pick(r); },
+  function(r) { return pick(r) + " AND " + pick(r); },
+  function(r) { return "\"" + pick(r) + " " + pick(r) + "\""; },
+  function(r) { return pick(r).substr(0, 3) + "*"; },
+  function(r) { return "title:" + pick(r) + " " + pick(r); }
+];
+
+var options = parseArgs(process.argv.slice(2));
+var random = createRandom(options.seed);
+
+var version = java.getStaticFieldValue("org.apache.lucene.util.Version", "LUCENE_CURRENT");
+var analyzer = java.newInstanceSync("org.apache.lucene.analysis.standard.StandardAnalyzer", version);
+var queryParser = java.newInstanceSync("org.apache.lucene.queryParser.QueryParser", version, "content", analyzer);
+var fieldStoreYes = java.callStaticMethodSync("org.apache.lucene.document.Field$Store", "valueOf", "YES");
+var fieldIndexAnalyzed = java.callStaticMethodSync("org.apache.lucene.document.Field$Index", "valueOf", "ANALYZED");
+
+var corpus = [];
+for (var i = 0; i < options.docs; i++) {
+  corpus.push({ title: sentence(random, 3), content: sentence(random, 40) });
+}
+var queries = [];
+for (i = 0; i < options.queries; i++) {
+  queries.push(QUERY_TEMPLATES[i % QUERY_TEMPLATES.length](random));
+}
+
+java.setStatsEnabled(true);
+
+var report = {
+  docs: options.docs,
+  queries: options.queries,
+  concurrency: options.concurrency,
+  node: process.version,
+  results: {}
+};
+
+runPhase("indexSync", corpus.length, function(done) {
+  var writer = createWriter();
+  var latencies = corpus.map(function(doc) {
+    var start = nowNs();
+    writer.index.addDocumentSync(createDocumentSync(doc));
+    return nowNs() - start;
+  });
+  writer.index.closeSync();
+  done(latencies, writer.directory);
+}, function(syncDirectory) {
+  runPhase("indexAsync", corpus.length, function(done) {
+    var writer = createWriter();
+    runConcurrently(corpus, options.concurrency, indexAsync.bind(null, writer.index), function(latencies) {
+      writer.index.closeSync();
+      done(latencies, writer.directory);
+    });
+  }, function() {
+    var searcher = java.newInstanceSync("org.apache.lucene.search.IndexSearcher", syncDirectory);
+
+    runPhase("searchSync", queries.length, function(done) {
+      var latencies = queries.map(function(queryString) {
+        var start = nowNs();
+        searchSync(searcher, queryString);
+        return nowNs() - start;
+      });
+      done(latencies);
+    }, function() {
+      runPhase("searchAsync", queries.length, function(done) {
+        runConcurrently(queries, options.concurrency, searchAsync.bind(null, searcher), done);
+      }, function() {
+        searcher.closeSync();
+        var json = JSON.stringify(report, null, 2);
+        if (options.out) {
+          fs.writeFileSync(options.out, json);
+        } else {
+          console.log(json);
+        }
+      });
+    });
+  });
+});
+
+function createWriter() {
+  var directory = java.newInstanceSync("org.apache.lucene.store.RAMDirectory");
+  var writerConfig = java.newInstanceSync("org.apache.lucene.index.IndexWriterConfig", version, analyzer);
+  return {
+    directory: directory,
+    index: java.newInstanceSync("org.apache.lucene.index.IndexWriter", directory, writerConfig)
+  };
+}
+
+function createDocumentSync(doc) {
+  var document = java.newInstanceSync("org.apache.lucene.document.Document");
+  document.addSync(java.newInstanceSync("org.apache.lucene.document.Field", "title", doc.title, fieldStoreYes, fieldIndexAnalyzed));
+  document.addSync(java.newInstanceSync("org.apache.lucene.document.Field", "content", doc.content, fieldStoreYes, fieldIndexAnalyzed));
+  return document;
+}
+
+function indexAsync(writer, doc, callback) {
+  java.newInstance("org.apache.lucene.document.Document", function(err, document) {
+    if (err) { return callback(err); }
+    java.newInstance("org.apache.lucene.document.Field", "title", doc.title, fieldStoreYes, fieldIndexAnalyzed, function(err, title) {
+      if (err) { return callback(err); }
+      java.newInstance("org.apache.lucene.document.Field", "content", doc.content, fieldStoreYes, fieldIndexAnalyzed, function(err, content) {
+        if (err) { return callback(err); }
+        document.add(title, function(err) {
+          if (err) { return callback(err); }
+          document.add(content, function(err) {
+            if (err) { return callback(err); }
+            writer.addDocument(document, callback);
+          });
+        });
+      });
+    });
+  });
+}
+
+function searchSync(searcher, queryString) {
+  var query = queryParser.parseSync(queryString);
+  var topDocs = searcher.searchSync(query, 10);
+  var scoreDocs = topDocs.scoreDocs;
+  var titles = [];
+  for (var i = 0; i < scoreDocs.length; i++) {
+    titles.push(searcher.docSync(scoreDocs[i].doc).getSync("title"));
+  }
+  return titles;
+}
+
+function searchAsync(searcher, queryString, callback) {
+  // QueryParser is not thread safe, so only parsing stays synchronous
+  var query = queryParser.parseSync(queryString);
+  searcher.search(query, 10, function(err, topDocs) {
+    if (err) { return callback(err); }
+    var scoreDocs = topDocs.scoreDocs;
+    var titles = [];
+    (function next(i) {
+      if (i === scoreDocs.length) {
+        return callback(null, titles);
+      }
+      searcher.doc(scoreDocs[i].doc, function(err, doc) {
+        if (err) { return callback(err); }
+        doc.get("title", function(err, title) {
+          if (err) { return callback(err); }
+          titles.push(title);
+          next(i + 1);
+        });
+      });
+    })(0);
+  });
+}
+
+// runs fn over items with up to concurrency calls in flight, collecting the latency of each
+function runConcurrently(items, concurrency, fn, callback) {
+  var latencies = [];
+  var nextItem = 0;
+  var running = 0;
+  var finished = false;
+
+  function startNext() {
+    if (nextItem === items.length) {
+      if (running === 0 && !finished) {
+        finished = true;
+        callback(latencies);
+      }
+      return;
+    }
+    var item = items[nextItem++];
+    var start = nowNs();
+    running++;
+    fn(item, function(err) {
+      if (err) {
+        throw err;
+      }
+      latencies.push(nowNs() - start);
+      running--;
+      startNext();
+    });
+  }
+
+  for (var i = 0; i < concurrency; i++) {
+    startNext();
+  }
+}
+
+function runPhase(name, count, fn, next) {
+  process.stderr.write(name + "... ");
+  java.resetStats();
+  var start = nowNs();
+  fn(function(latencies, value) {
+    var elapsedNs = nowNs() - start;
+    var sorted = latencies.slice().sort(function(a, b) { return a - b; });
+    var result = {
+      opsPerSec: Math.round(count / (elapsedNs / 1e9)),
+      elapsedMs: elapsedNs / 1e6,
+      p50Ms: percentile(sorted, 0.5) / 1e6,
+      p99Ms: percentile(sorted, 0.99) / 1e6
+    };
+    var bridge = bridgeTime(java.stats());
+    result.bridgeCalls = bridge.calls;
+    result.conversionMs = bridge.conversionMs;
+    result.conversionShare = bridge.conversionMs / bridge.totalMs;
+    result.resolveShare = bridge.resolveMs / bridge.totalMs;
+    report.results[name] = result;
+    process.stderr.write(result.opsPerSec + (name.indexOf("index") === 0 ? " docs/sec\n" : " queries/sec\n"));
+    next(value);
+  });
+}
+
+// sums the time of every call phase except waiting in the queue, which is not work done by the bridge
+function bridgeTime(stats) {
+  var result = { calls: 0, conversionMs: 0, resolveMs: 0, totalMs: 0 };
+  Object.keys(stats).forEach(function(key) {
+    var method = stats[key];
+    result.calls += method.calls;
+    result.conversionMs += method.args.totalMs + method.results.totalMs;
+    result.resolveMs += method.resolve.totalMs;
+    result.totalMs += method.args.totalMs + method.results.totalMs + method.resolve.totalMs + method.execute.totalMs;
+  });
+  return result;
+}
+
+function parseArgs(argv) {
+  var result = { docs: 5000, queries: 2000, concurrency: 4, seed: 1, out: null };
+  for (var i = 0; i < argv.length; i += 2) {
+    var name = argv[i].replace(/^--/, "");
+    if (!(name in result)) {
+      throw new Error("Unknown argument " + argv[i]);
+    }
+    result[name] = name === "out" ? argv[i + 1] : parseInt(argv[i + 1], 10);
+  }
+  return result;
+}
+
+// a small deterministic generator so every run indexes the same corpus
+function createRandom(seed) {
+  var state = seed || 1;
+  return function() {
+    state = (state * 1103515245 + 12345) & 0x7fffffff;
+    return state / 0x7fffffff;
+  };
+}
+
+function pick(random) {
+  return WORDS[Math.floor(random() * WORDS.length)];
+}
+
+function sentence(random, wordCount) {
+  var words = [];
+  for (var i = 0; i < wordCount; i++) {
+    words.push(pick(random));
+  }
+  return words.join(" ");
+}
+
+function percentile(sorted, p) {
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+function nowNs() {
+  var t = process.hrtime();
+  return t[0] * 1e9 + t[1];
+}
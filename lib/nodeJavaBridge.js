@@ -1,6 +1,7 @@
 'use strict';
 
 var path = require('path');
+var stream = require('stream');
 var binaryPath = path.resolve(path.join(__dirname, "../build/Release/nodejavabridge_bindings.node"));
 var bindings = require(binaryPath);
 
@@ -51,3 +52,293 @@ java.import = function (name) {
 
   return result;
 };
+
+function PipelineStep(pipeline, index) {
+  this.pipeline = pipeline;
+  this.index = index;
+}
+
+function Pipeline() {
+  this.steps = [];
+}
+
+Pipeline.prototype._add = function (step, args) {
+  var argRefs = [];
+  step.args = [];
+  for (var i = 0; i < args.length; i++) {
+    if (args[i] instanceof PipelineStep) {
+      if (args[i].pipeline !== this) {
+        throw new Error("Argument " + i + " is a step of another pipeline");
+      }
+      argRefs.push(i, args[i].index);
+      step.args.push(null);
+    } else {
+      step.args.push(args[i]);
+    }
+  }
+  step.argRefs = argRefs;
+  this.steps.push(step);
+  return new PipelineStep(this, this.steps.length - 1);
+};
+
+Pipeline.prototype.newInstance = function (className) {
+  return this._add({ type: 'new', className: className }, Array.prototype.slice.call(arguments, 1));
+};
+
+Pipeline.prototype.callStaticMethod = function (className, methodName) {
+  return this._add({ type: 'static', className: className, methodName: methodName }, Array.prototype.slice.call(arguments, 2));
+};
+
+// target is a java object or a step of this pipeline
+Pipeline.prototype.callMethod = function (target, methodName) {
+  var step = { type: 'method', methodName: methodName };
+  if (target instanceof PipelineStep) {
+    if (target.pipeline !== this) {
+      throw new Error("Target is a step of another pipeline");
+    }
+    step.targetStep = target.index;
+  } else {
+    step.target = target;
+  }
+  return this._add(step, Array.prototype.slice.call(arguments, 2));
+};
+
+// run([steps], [callOptions], callback): calls back with the last result, or an array of the results of steps
+Pipeline.prototype.run = function () {
+  var args = [this.steps];
+  var callback = arguments[arguments.length - 1];
+  var wanted = arguments[0];
+  if (Array.isArray(wanted)) {
+    var self = this;
+    args.push(wanted.map(function (step) {
+      if (!(step instanceof PipelineStep) || step.pipeline !== self) {
+        throw new Error("Pipeline results must name steps of the pipeline");
+      }
+      return step.index;
+    }));
+  }
+  var callOptions = arguments.length > 1 ? arguments[arguments.length - 2] : null;
+  if (callOptions && !Array.isArray(callOptions)) {
+    args.push(callOptions);
+  }
+  args.push(callback);
+  return java.runPipeline.apply(java, args);
+};
+
+java.pipeline = function () {
+  return new Pipeline();
+};
+
+// Entries are class names or { className, initialize, warmup, args, iterations } objects.
+java.preload = function (classNames, options, callback) {
+  if (typeof options === 'function') {
+    callback = options;
+    options = {};
+  }
+  options = options || {};
+  var concurrency = options.concurrency || 4;
+  var startTime = Date.now();
+  var classes = {};
+  var failures = [];
+  var next = 0;
+  var running = 0;
+  var finished = false;
+
+  function done() {
+    if (finished) {
+      return;
+    }
+    finished = true;
+    var result = { classes: classes, elapsedMs: Date.now() - startTime };
+    if (failures.length > 0) {
+      var err = new Error("Could not preload " + failures.map(function (failure) { return failure.className; }).join(", "));
+      err.failures = failures;
+      return callback(err, result);
+    }
+    callback(null, result);
+  }
+
+  function startNext() {
+    if (next >= classNames.length) {
+      if (running === 0) {
+        done();
+      }
+      return;
+    }
+    var entry = classNames[next++];
+    if (typeof entry === 'string') {
+      entry = { className: entry };
+    }
+    var preloadOptions = {
+      initialize: entry.initialize !== undefined ? entry.initialize : options.initialize,
+      warmup: entry.warmup,
+      args: entry.args,
+      iterations: entry.iterations
+    };
+    var args = [entry.className, preloadOptions];
+    if (options.callOptions) {
+      args.push(options.callOptions);
+    }
+    args.push(function (err, loaded) {
+      running--;
+      if (err) {
+        failures.push({ className: entry.className, error: err });
+      } else {
+        classes[entry.className] = loaded;
+      }
+      startNext();
+    });
+    running++;
+    java.preloadClass.apply(java, args);
+  }
+
+  if (classNames.length === 0) {
+    return process.nextTick(done);
+  }
+
+  for (var i = 0; i < concurrency; i++) {
+    startNext();
+  }
+};
+
+// target is a class name for a static method or a java object. Each entry of argsArray holds the
+// arguments of one call; entries that are not arrays are passed as the only argument.
+java.parallelMap = function (target, methodName, argsArray, options, callback) {
+  if (typeof options === 'function') {
+    callback = options;
+    options = {};
+  }
+  options = options || {};
+  var concurrency = options.concurrency || 4;
+  var chunkSize = options.chunkSize || Math.max(1, Math.ceil(argsArray.length / (concurrency * 4)));
+  var results = new Array(argsArray.length);
+  var next = 0;
+  var running = 0;
+  var finished = false;
+
+  if (argsArray.length === 0) {
+    return process.nextTick(function () {
+      callback(null, results);
+    });
+  }
+
+  function startNext() {
+    if (finished) {
+      return;
+    }
+    if (next >= argsArray.length) {
+      if (running === 0) {
+        finished = true;
+        callback(null, results);
+      }
+      return;
+    }
+    var offset = next;
+    var items = argsArray.slice(offset, offset + chunkSize).map(function (item) {
+      return Array.isArray(item) ? item : [item];
+    });
+    next += items.length;
+    var args = [target, methodName, items];
+    if (options.callOptions) {
+      args.push(options.callOptions);
+    }
+    args.push(function (err, chunkResults) {
+      running--;
+      if (finished) {
+        return;
+      }
+      if (err) {
+        finished = true;
+        if (err.item !== undefined) {
+          err.item += offset;
+        }
+        return callback(err);
+      }
+      for (var i = 0; i < chunkResults.length; i++) {
+        results[offset + i] = chunkResults[i];
+      }
+      startNext();
+    });
+    running++;
+    java.mapChunk.apply(java, args);
+  }
+
+  for (var i = 0; i < concurrency; i++) {
+    startNext();
+  }
+};
+
+java.createReadStream = function (javaObject, options) {
+  options = options || {};
+  if (!stream.Readable) {
+    throw new Error("createReadStream requires stream.Readable (node 0.10 or later)");
+  }
+  var isIterator = (typeof javaObject.hasNextSync === 'function') && (typeof javaObject.readSync !== 'function');
+  var chunkSize = options.chunkSize || (isIterator ? 1000 : 64 * 1024);
+  var result = new stream.Readable({
+    highWaterMark: options.highWaterMark,
+    encoding: options.encoding,
+    objectMode: isIterator
+  });
+
+  // Readable only calls _read again after the previous chunk was pushed so there is at most one read in flight.
+  result._read = function () {
+    var args = [javaObject, chunkSize];
+    if (options.callOptions) {
+      args.push(options.callOptions);
+    }
+    args.push(function (err, chunk) {
+      if (err) {
+        result.emit('error', err);
+        return;
+      }
+      result.push(chunk);
+    });
+    java.streamRead.apply(java, args);
+  };
+
+  return result;
+};
+
+java.createWriteStream = function (javaOutputStream, options) {
+  options = options || {};
+  if (!stream.Writable) {
+    throw new Error("createWriteStream requires stream.Writable (node 0.10 or later)");
+  }
+  var result = new stream.Writable({ highWaterMark: options.highWaterMark });
+
+  function writeChunks(chunks, callback) {
+    var args = [javaOutputStream, chunks];
+    if (options.callOptions) {
+      args.push(options.callOptions);
+    }
+    args.push(function (err) {
+      callback(err);
+    });
+    java.streamWrite.apply(java, args);
+  }
+
+  result._write = function (chunk, encoding, callback) {
+    writeChunks([chunk], callback);
+  };
+
+  // chunks written while a write is running are handed over together and copied to java in one batch
+  result._writev = function (chunks, callback) {
+    writeChunks(chunks.map(function (item) { return item.chunk; }), callback);
+  };
+
+  result.on('finish', function () {
+    if (options.close === false) {
+      return;
+    }
+    javaOutputStream.close(function (err) {
+      if (err) {
+        result.emit('error', err);
+        return;
+      }
+      result.emit('close');
+    });
+  });
+
+  return result;
+};
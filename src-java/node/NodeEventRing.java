@@ -0,0 +1,44 @@
+package node;
+
+public class NodeEventRing
+{
+  private native boolean appendRecords(long ptr, byte[] records, int offset, int count);
+  private long ptr;
+  private final int recordSize;
+
+  public NodeEventRing(String path, long ptr, int recordSize) {
+    try{
+      Runtime.getRuntime().load(path);
+    }catch(Exception e){
+      System.out.println(e.toString());
+    }
+    this.ptr = ptr;
+    this.recordSize = recordSize;
+  }
+
+  public int getRecordSize() {
+    return this.recordSize;
+  }
+
+  public boolean append(byte[] record) {
+    return append(record, 0, 1);
+  }
+
+  /**
+   * Appends count records of recordSize bytes starting at offset. Returns false if the ring was
+   * closed or some of the records did not fit and were dropped.
+   */
+  public synchronized boolean append(byte[] records, int offset, int count) {
+    if(this.ptr == 0) {
+      return false;
+    }
+    if(offset < 0 || count < 0 || offset + count * this.recordSize > records.length) {
+      throw new IndexOutOfBoundsException();
+    }
+    return appendRecords(this.ptr, records, offset, count);
+  }
+
+  public synchronized void close() {
+    this.ptr = 0;
+  }
+}
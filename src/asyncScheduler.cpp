@@ -0,0 +1,161 @@
+#include "asyncScheduler.h"
+#include "methodCallBaton.h"
+#include <string.h>
+
+AsyncScheduler::AsyncScheduler() {
+  m_maxInFlight = 0;
+  m_maxQueueDepth = 0;
+  m_queueFullPolicy = QUEUE_FULL_REJECT;
+  m_needDrain = false;
+  m_inFlight = 0;
+  m_queued = 0;
+  m_dispatchedCount = 0;
+  m_rejectedCount = 0;
+  m_totalWaitNs = 0;
+  m_maxWaitNs = 0;
+}
+
+AsyncScheduler::~AsyncScheduler() {
+  if(!m_drainCallback.IsEmpty()) {
+    m_drainCallback.Dispose();
+  }
+}
+
+schedulerSubmitResult AsyncScheduler::submit(MethodCallBaton* baton, int priority) {
+  bool queueFull = m_maxQueueDepth > 0 && m_queued >= m_maxQueueDepth;
+  if(queueFull && m_queueFullPolicy == QUEUE_FULL_REJECT) {
+    m_rejectedCount++;
+    return SUBMIT_REJECTED;
+  }
+
+  baton->setQueuedTime(uv_hrtime());
+  m_queues[priority].push_back(baton);
+  m_queued++;
+  dispatch();
+
+  if(m_maxQueueDepth > 0 && m_queued >= m_maxQueueDepth) {
+    m_needDrain = true;
+    return SUBMIT_BACKPRESSURE;
+  }
+  return SUBMIT_OK;
+}
+
+void AsyncScheduler::completed(MethodCallBaton* baton) {
+  m_inFlight--;
+  dispatch();
+
+  if(m_needDrain && m_queued <= m_maxQueueDepth / 2) {
+    m_needDrain = false;
+    if(!m_drainCallback.IsEmpty()) {
+      v8::HandleScope scope;
+      m_drainCallback->Call(v8::Context::GetCurrent()->Global(), 0, NULL);
+    }
+  }
+}
+
+void AsyncScheduler::cancel(MethodCallBaton* baton) {
+  for(int priority=0; priority<CALL_PRIORITY_COUNT; priority++) {
+    std::list<MethodCallBaton*>& queue = m_queues[priority];
+    for(std::list<MethodCallBaton*>::iterator it = queue.begin(); it != queue.end(); it++) {
+      if(*it == baton) {
+        queue.erase(it);
+        m_queued--;
+        return;
+      }
+    }
+  }
+}
+
+void AsyncScheduler::dispatch() {
+  for(int priority=0; priority<CALL_PRIORITY_COUNT; priority++) {
+    std::list<MethodCallBaton*>& queue = m_queues[priority];
+    while(!queue.empty()) {
+      if(m_maxInFlight > 0 && m_inFlight >= m_maxInFlight) {
+        return;
+      }
+      MethodCallBaton* baton = queue.front();
+      queue.pop_front();
+      m_queued--;
+      m_inFlight++;
+
+      uint64_t waitNs = uv_hrtime() - baton->getQueuedTime();
+      m_totalWaitNs += waitNs;
+      if(waitNs > m_maxWaitNs) {
+        m_maxWaitNs = waitNs;
+      }
+      m_dispatchedCount++;
+
+      baton->queueWork();
+    }
+  }
+}
+
+v8::Handle<v8::Value> AsyncScheduler::setOptions(v8::Handle<v8::Object> options) {
+  v8::Local<v8::Value> maxInFlight = options->Get(v8::String::New("maxInFlight"));
+  if(!maxInFlight->IsUndefined()) {
+    if(!maxInFlight->IsNumber() || maxInFlight->NumberValue() < 0) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("maxInFlight must be a positive number")));
+    }
+    m_maxInFlight = maxInFlight->Int32Value();
+  }
+
+  v8::Local<v8::Value> maxQueueDepth = options->Get(v8::String::New("maxQueueDepth"));
+  if(!maxQueueDepth->IsUndefined()) {
+    if(!maxQueueDepth->IsNumber() || maxQueueDepth->NumberValue() < 0) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("maxQueueDepth must be a positive number")));
+    }
+    m_maxQueueDepth = maxQueueDepth->Int32Value();
+  }
+
+  v8::Local<v8::Value> onQueueFull = options->Get(v8::String::New("onQueueFull"));
+  if(!onQueueFull->IsUndefined()) {
+    v8::String::AsciiValue onQueueFullStr(onQueueFull);
+    if(strcmp(*onQueueFullStr, "reject") == 0) {
+      m_queueFullPolicy = QUEUE_FULL_REJECT;
+    } else if(strcmp(*onQueueFullStr, "backpressure") == 0) {
+      m_queueFullPolicy = QUEUE_FULL_BACKPRESSURE;
+    } else {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("onQueueFull must be either \"reject\" or \"backpressure\"")));
+    }
+  }
+
+  v8::Local<v8::Value> drain = options->Get(v8::String::New("drain"));
+  if(!drain->IsUndefined()) {
+    if(!drain->IsFunction() && !drain->IsNull()) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("drain must be a function")));
+    }
+    if(!m_drainCallback.IsEmpty()) {
+      m_drainCallback.Dispose();
+      m_drainCallback.Clear();
+    }
+    if(drain->IsFunction()) {
+      m_drainCallback = v8::Persistent<v8::Function>::New(v8::Local<v8::Function>::Cast(drain));
+    }
+  }
+
+  // a raised limit may let queued calls start right away
+  dispatch();
+
+  return v8::Undefined();
+}
+
+v8::Handle<v8::Object> AsyncScheduler::getStats() {
+  v8::HandleScope scope;
+
+  v8::Local<v8::Object> queuedByPriority = v8::Object::New();
+  queuedByPriority->Set(v8::String::New("interactive"), v8::Integer::New(m_queues[CALL_PRIORITY_INTERACTIVE].size()));
+  queuedByPriority->Set(v8::String::New("normal"), v8::Integer::New(m_queues[CALL_PRIORITY_NORMAL].size()));
+  queuedByPriority->Set(v8::String::New("bulk"), v8::Integer::New(m_queues[CALL_PRIORITY_BULK].size()));
+
+  v8::Local<v8::Object> result = v8::Object::New();
+  result->Set(v8::String::New("inFlight"), v8::Integer::New(m_inFlight));
+  result->Set(v8::String::New("queued"), v8::Integer::New(m_queued));
+  result->Set(v8::String::New("queuedByPriority"), queuedByPriority);
+  result->Set(v8::String::New("dispatched"), v8::Number::New((double)m_dispatchedCount));
+  result->Set(v8::String::New("rejected"), v8::Number::New((double)m_rejectedCount));
+  double averageWaitMs = m_dispatchedCount == 0 ? 0 : ((double)m_totalWaitNs / m_dispatchedCount) / 1e6;
+  result->Set(v8::String::New("averageWaitMs"), v8::Number::New(averageWaitMs));
+  result->Set(v8::String::New("maxWaitMs"), v8::Number::New((double)m_maxWaitNs / 1e6));
+
+  return scope.Close(result);
+}
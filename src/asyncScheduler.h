@@ -0,0 +1,56 @@
+#ifndef _asyncscheduler_h_
+#define _asyncscheduler_h_
+
+#include <v8.h>
+#include <uv.h>
+#include <list>
+#include "callOptions.h"
+
+class MethodCallBaton;
+
+typedef enum _schedulerSubmitResult {
+  SUBMIT_OK           = 1,
+  SUBMIT_BACKPRESSURE = 2,
+  SUBMIT_REJECTED     = 3
+} schedulerSubmitResult;
+
+typedef enum _queueFullPolicy {
+  QUEUE_FULL_REJECT       = 1,
+  QUEUE_FULL_BACKPRESSURE = 2
+} queueFullPolicy;
+
+/*
+ * Admission control in front of the thread pool. All methods are called on the v8 thread so no
+ * locking is needed. A limit of 0 means unlimited.
+ */
+class AsyncScheduler {
+public:
+  AsyncScheduler();
+  ~AsyncScheduler();
+
+  schedulerSubmitResult submit(MethodCallBaton* baton, int priority);
+  void completed(MethodCallBaton* baton);
+  void cancel(MethodCallBaton* baton);
+
+  v8::Handle<v8::Value> setOptions(v8::Handle<v8::Object> options);
+  v8::Handle<v8::Object> getStats();
+
+private:
+  void dispatch();
+
+  std::list<MethodCallBaton*> m_queues[CALL_PRIORITY_COUNT];
+  int m_maxInFlight;
+  int m_maxQueueDepth;
+  queueFullPolicy m_queueFullPolicy;
+  v8::Persistent<v8::Function> m_drainCallback;
+  bool m_needDrain;
+
+  int m_inFlight;
+  int m_queued;
+  uint64_t m_dispatchedCount;
+  uint64_t m_rejectedCount;
+  uint64_t m_totalWaitNs;
+  uint64_t m_maxWaitNs;
+};
+
+#endif
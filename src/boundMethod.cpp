@@ -0,0 +1,634 @@
+#include "boundMethod.h"
+#include "java.h"
+#include "javaObject.h"
+#include "utils.h"
+#include "typedValue.h"
+#include <string.h>
+#include <sstream>
+
+#define MODIFIER_STATIC_ONLY 8
+
+/*static*/ v8::Persistent<v8::FunctionTemplate> BoundMethod::s_ct;
+
+/*static*/ void BoundMethod::Init(v8::Handle<v8::Object> target) {
+  v8::HandleScope scope;
+
+  v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New();
+  s_ct = v8::Persistent<v8::FunctionTemplate>::New(t);
+  s_ct->InstanceTemplate()->SetInternalFieldCount(1);
+  s_ct->SetClassName(v8::String::NewSymbol("BoundMethod"));
+}
+
+static boundType boundTypeFromName(const std::string& typeName) {
+  const char* name = typeName.c_str();
+  if(strcmp(name, "void") == 0) return BOUND_TYPE_VOID;
+  if(strcmp(name, "boolean") == 0) return BOUND_TYPE_BOOLEAN;
+  if(strcmp(name, "byte") == 0) return BOUND_TYPE_BYTE;
+  if(strcmp(name, "char") == 0) return BOUND_TYPE_CHAR;
+  if(strcmp(name, "short") == 0) return BOUND_TYPE_SHORT;
+  if(strcmp(name, "int") == 0) return BOUND_TYPE_INT;
+  if(strcmp(name, "long") == 0) return BOUND_TYPE_LONG;
+  if(strcmp(name, "float") == 0) return BOUND_TYPE_FLOAT;
+  if(strcmp(name, "double") == 0) return BOUND_TYPE_DOUBLE;
+  if(strcmp(name, "java.lang.String") == 0) return BOUND_TYPE_STRING;
+  return BOUND_TYPE_OBJECT;
+}
+
+static boundType boundTypeFromClass(JNIEnv* env, jclass clazz) {
+  jclass classClazz = env->FindClass("java/lang/Class");
+  jmethodID class_getName = env->GetMethodID(classClazz, "getName", "()Ljava/lang/String;");
+  jstring nameJava = (jstring)env->CallObjectMethod(clazz, class_getName);
+  boundType result = boundTypeFromName(javaToString(env, nameJava));
+  env->DeleteLocalRef(nameJava);
+  env->DeleteLocalRef(classClazz);
+  return result;
+}
+
+/*
+ * Finds the class for a type name as written in java source, eg. "int", "java.lang.String" or
+ * "byte[]". Primitive types come from the TYPE field of their wrapper class.
+ */
+static jclass boundFindTypeClass(JNIEnv* env, const std::string& typeName) {
+  static const char* primitives[][3] = {
+    { "boolean", "java/lang/Boolean", "Z" },
+    { "byte", "java/lang/Byte", "B" },
+    { "char", "java/lang/Character", "C" },
+    { "short", "java/lang/Short", "S" },
+    { "int", "java/lang/Integer", "I" },
+    { "long", "java/lang/Long", "J" },
+    { "float", "java/lang/Float", "F" },
+    { "double", "java/lang/Double", "D" }
+  };
+
+  std::string elementName = typeName;
+  std::string arrayPrefix;
+  while(elementName.size() > 2 && elementName.compare(elementName.size() - 2, 2, "[]") == 0) {
+    elementName.erase(elementName.size() - 2);
+    arrayPrefix += "[";
+  }
+
+  for(size_t i=0; i<sizeof(primitives) / sizeof(primitives[0]); i++) {
+    if(elementName == primitives[i][0]) {
+      if(arrayPrefix.empty()) {
+        jclass wrapperClazz = env->FindClass(primitives[i][1]);
+        jfieldID typeField = env->GetStaticFieldID(wrapperClazz, "TYPE", "Ljava/lang/Class;");
+        jclass result = (jclass)env->GetStaticObjectField(wrapperClazz, typeField);
+        env->DeleteLocalRef(wrapperClazz);
+        return result;
+      }
+      std::string descriptor = arrayPrefix + primitives[i][2];
+      return javaFindClass(env, descriptor);
+    }
+  }
+
+  if(arrayPrefix.empty()) {
+    return javaFindClass(env, elementName);
+  }
+  std::string descriptor = arrayPrefix + "L" + elementName + ";";
+  return javaFindClass(env, descriptor);
+}
+
+/*
+ * Reads one type descriptor of a JNI signature starting at pos, eg. "J", "Ljava/lang/String;" or
+ * "[I", and moves pos past it. Returns false if the descriptor is malformed.
+ */
+static bool boundParseDescriptor(const std::string& signature, size_t& pos, boundType* type) {
+  size_t start = pos;
+  while(pos < signature.size() && signature[pos] == '[') {
+    pos++;
+  }
+  if(pos >= signature.size()) {
+    return false;
+  }
+  bool isArray = pos > start;
+  char c = signature[pos];
+  if(c == 'L') {
+    size_t end = signature.find(';', pos);
+    if(end == std::string::npos) {
+      return false;
+    }
+    *type = (!isArray && signature.compare(pos, end - pos + 1, "Ljava/lang/String;") == 0) ? BOUND_TYPE_STRING : BOUND_TYPE_OBJECT;
+    pos = end + 1;
+    return true;
+  }
+  pos++;
+  if(isArray) {
+    *type = BOUND_TYPE_OBJECT;
+    return strchr("ZBCSIJFD", c) != NULL;
+  }
+  switch(c) {
+    case 'Z': *type = BOUND_TYPE_BOOLEAN; return true;
+    case 'B': *type = BOUND_TYPE_BYTE; return true;
+    case 'C': *type = BOUND_TYPE_CHAR; return true;
+    case 'S': *type = BOUND_TYPE_SHORT; return true;
+    case 'I': *type = BOUND_TYPE_INT; return true;
+    case 'J': *type = BOUND_TYPE_LONG; return true;
+    case 'F': *type = BOUND_TYPE_FLOAT; return true;
+    case 'D': *type = BOUND_TYPE_DOUBLE; return true;
+  }
+  return false;
+}
+
+/*static*/ v8::Handle<v8::Value> BoundMethod::New(Java* java, const std::string& className, const std::string& methodName, v8::Handle<v8::Value> paramTypes, bool isStatic) {
+  v8::HandleScope scope;
+  JNIEnv *env = java->getJavaEnv();
+
+  v8::Local<v8::Function> ctor = s_ct->GetFunction();
+  v8::Local<v8::Object> boundMethodObj = ctor->NewInstance();
+  BoundMethod *self = new BoundMethod(java, className, methodName, isStatic);
+  self->Wrap(boundMethodObj);
+
+  PUSH_LOCAL_JAVA_FRAME();
+  jclass clazz = java->getClassCache()->find(env, className);
+  if(clazz == NULL) {
+    std::ostringstream errStr;
+    errStr << "Could not find class " << className.c_str();
+    POP_LOCAL_JAVA_FRAME_AND_RETURN(scope.Close(javaExceptionToV8(env, errStr.str())));
+  }
+  v8::Handle<v8::Value> bindResult = self->bind(env, clazz, paramTypes);
+  POP_LOCAL_JAVA_FRAME();
+  if(!bindResult->IsUndefined()) {
+    return scope.Close(bindResult);
+  }
+
+  v8::Local<v8::FunctionTemplate> callTemplate = v8::FunctionTemplate::New(call, boundMethodObj);
+  return scope.Close(callTemplate->GetFunction());
+}
+
+BoundMethod::BoundMethod(Java* java, const std::string& className, const std::string& methodName, bool isStatic) {
+  m_java = java;
+  m_className = className;
+  m_methodName = methodName;
+  m_isStatic = isStatic;
+  m_class = NULL;
+  m_methodId = NULL;
+  m_returnType = BOUND_TYPE_VOID;
+  m_stats = NULL;
+}
+
+BoundMethod::~BoundMethod() {
+  m_java->releaseGlobalRef(m_class, REF_SITE_METHOD);
+  for(std::vector<jclass>::iterator it = m_paramClasses.begin(); it != m_paramClasses.end(); it++) {
+    m_java->releaseGlobalRef(*it, REF_SITE_METHOD);
+  }
+}
+
+/*
+ * Resolves the method either from explicit parameter type names, which skips the overload search, or
+ * by name when the class has exactly one public method of that name, not counting bridge methods. A
+ * JNI signature string instead of type names goes to bindSignature.
+ */
+v8::Handle<v8::Value> BoundMethod::bind(JNIEnv* env, jclass clazz, v8::Handle<v8::Value> paramTypes) {
+  if(paramTypes->IsString()) {
+    v8::String::AsciiValue signature(paramTypes);
+    return bindSignature(env, clazz, *signature);
+  }
+
+  jclass classClazz = env->FindClass("java/lang/Class");
+  jclass methodClazz = env->FindClass("java/lang/reflect/Method");
+  jmethodID method_getModifiers = env->GetMethodID(methodClazz, "getModifiers", "()I");
+  jmethodID method_getName = env->GetMethodID(methodClazz, "getName", "()Ljava/lang/String;");
+  jmethodID method_isBridge = env->GetMethodID(methodClazz, "isBridge", "()Z");
+  jmethodID method_getParameterTypes = env->GetMethodID(methodClazz, "getParameterTypes", "()[Ljava/lang/Class;");
+  jmethodID method_getReturnType = env->GetMethodID(methodClazz, "getReturnType", "()Ljava/lang/Class;");
+  jstring methodNameJava = env->NewStringUTF(m_methodName.c_str());
+
+  jobject method = NULL;
+  if(paramTypes->IsArray()) {
+    v8::Array* paramTypesArray = v8::Array::Cast(*paramTypes);
+    jobjectArray paramClasses = env->NewObjectArray(paramTypesArray->Length(), classClazz, NULL);
+    for(uint32_t i=0; i<paramTypesArray->Length(); i++) {
+      v8::String::AsciiValue typeName(paramTypesArray->Get(i));
+      jclass paramClass = boundFindTypeClass(env, *typeName);
+      if(paramClass == NULL) {
+        std::ostringstream errStr;
+        errStr << "Could not find parameter type " << *typeName;
+        return javaExceptionToV8(env, errStr.str());
+      }
+      env->SetObjectArrayElement(paramClasses, i, paramClass);
+      env->DeleteLocalRef(paramClass);
+    }
+    jmethodID class_getMethod = env->GetMethodID(classClazz, "getMethod", "(Ljava/lang/String;[Ljava/lang/Class;)Ljava/lang/reflect/Method;");
+    method = env->CallObjectMethod(clazz, class_getMethod, methodNameJava, paramClasses);
+    if(env->ExceptionCheck()) {
+      std::ostringstream errStr;
+      errStr << "Could not find method " << m_className << "." << m_methodName << " with the given parameter types";
+      return javaExceptionToV8(env, errStr.str());
+    }
+  } else {
+    jmethodID class_getMethods = env->GetMethodID(classClazz, "getMethods", "()[Ljava/lang/reflect/Method;");
+    jobjectArray methods = (jobjectArray)env->CallObjectMethod(clazz, class_getMethods);
+    jsize methodCount = env->GetArrayLength(methods);
+    int matches = 0;
+    for(jsize i=0; i<methodCount; i++) {
+      jobject candidate = env->GetObjectArrayElement(methods, i);
+      jstring candidateName = (jstring)env->CallObjectMethod(candidate, method_getName);
+      bool candidateStatic = (env->CallIntMethod(candidate, method_getModifiers) & MODIFIER_STATIC_ONLY) != 0;
+      // bridge methods the compiler adds for generics and covariant returns are not overloads
+      bool candidateBridge = env->CallBooleanMethod(candidate, method_isBridge) == JNI_TRUE;
+      if(candidateStatic == m_isStatic && !candidateBridge && javaToString(env, candidateName) == m_methodName) {
+        matches++;
+        method = candidate;
+      } else {
+        env->DeleteLocalRef(candidate);
+      }
+      env->DeleteLocalRef(candidateName);
+    }
+    if(matches != 1) {
+      std::ostringstream errStr;
+      if(matches == 0) {
+        errStr << "Could not find " << (m_isStatic ? "static" : "instance") << " method " << m_className << "." << m_methodName;
+      } else {
+        errStr << "Method " << m_className << "." << m_methodName << " is overloaded, pass the parameter types to choose one";
+      }
+      return v8::Exception::Error(v8::String::New(errStr.str().c_str()));
+    }
+  }
+
+  bool methodStatic = (env->CallIntMethod(method, method_getModifiers) & MODIFIER_STATIC_ONLY) != 0;
+  if(methodStatic != m_isStatic) {
+    std::ostringstream errStr;
+    errStr << m_className << "." << m_methodName << " is " << (methodStatic ? "static, use java.getMethod" : "not static, use java.getInstanceMethod");
+    return v8::Exception::Error(v8::String::New(errStr.str().c_str()));
+  }
+
+  jobjectArray methodParamTypes = (jobjectArray)env->CallObjectMethod(method, method_getParameterTypes);
+  jsize paramCount = env->GetArrayLength(methodParamTypes);
+  for(jsize i=0; i<paramCount; i++) {
+    jclass paramClass = (jclass)env->GetObjectArrayElement(methodParamTypes, i);
+    boundType type = boundTypeFromClass(env, paramClass);
+    m_paramTypes.push_back(type);
+    m_paramClasses.push_back(type == BOUND_TYPE_OBJECT ? (jclass)refStatsNewGlobalRef(env, paramClass, REF_SITE_METHOD) : NULL);
+    env->DeleteLocalRef(paramClass);
+  }
+  jclass returnClass = (jclass)env->CallObjectMethod(method, method_getReturnType);
+  m_returnType = boundTypeFromClass(env, returnClass);
+
+  m_methodId = env->FromReflectedMethod(method);
+  m_class = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_METHOD);
+  return v8::Undefined();
+}
+
+/*
+ * Binds from a JNI signature such as "(JF)V". The parameter and return types are read from the
+ * signature and the jmethodID comes straight from JNI, so no reflection is involved at all.
+ */
+v8::Handle<v8::Value> BoundMethod::bindSignature(JNIEnv* env, jclass clazz, const std::string& signature) {
+  std::ostringstream errStr;
+  std::vector<boundType> paramTypes;
+  std::vector<std::string> paramDescriptors;
+  boundType returnType = BOUND_TYPE_VOID;
+  size_t pos = 1;
+  bool valid = signature.size() > 2 && signature[0] == '(';
+  while(valid && pos < signature.size() && signature[pos] != ')') {
+    boundType type;
+    size_t start = pos;
+    valid = boundParseDescriptor(signature, pos, &type);
+    paramTypes.push_back(type);
+    paramDescriptors.push_back(signature.substr(start, pos - start));
+  }
+  if(valid) {
+    pos++;
+    if(pos < signature.size() && signature[pos] == 'V' && pos + 1 == signature.size()) {
+      returnType = BOUND_TYPE_VOID;
+    } else {
+      valid = boundParseDescriptor(signature, pos, &returnType) && pos == signature.size();
+    }
+  }
+  if(!valid) {
+    errStr << "Invalid method signature \"" << signature << "\"";
+    return v8::Exception::TypeError(v8::String::New(errStr.str().c_str()));
+  }
+
+  jmethodID methodId = m_isStatic
+    ? env->GetStaticMethodID(clazz, m_methodName.c_str(), signature.c_str())
+    : env->GetMethodID(clazz, m_methodName.c_str(), signature.c_str());
+  if(methodId == NULL) {
+    env->ExceptionClear();
+    errStr << "Could not find " << (m_isStatic ? "static" : "instance") << " method " << m_className << "." << m_methodName << signature;
+    return v8::Exception::Error(v8::String::New(errStr.str().c_str()));
+  }
+
+  // object arguments are checked against these on every call, as they are for methods bound by type names
+  for(size_t i=0; i<paramTypes.size(); i++) {
+    if(paramTypes[i] != BOUND_TYPE_OBJECT) {
+      m_paramClasses.push_back(NULL);
+      continue;
+    }
+    // FindClass takes the internal name of a class but the whole descriptor of an array
+    const std::string& descriptor = paramDescriptors[i];
+    std::string paramClassName = descriptor[0] == 'L' ? descriptor.substr(1, descriptor.size() - 2) : descriptor;
+    jclass paramClass = env->FindClass(paramClassName.c_str());
+    if(paramClass == NULL) {
+      env->ExceptionClear();
+      errStr << "Could not find parameter type " << descriptor << " of " << m_className << "." << m_methodName << signature;
+      return v8::Exception::Error(v8::String::New(errStr.str().c_str()));
+    }
+    m_paramClasses.push_back((jclass)refStatsNewGlobalRef(env, paramClass, REF_SITE_METHOD));
+    env->DeleteLocalRef(paramClass);
+  }
+
+  m_paramTypes = paramTypes;
+  m_returnType = returnType;
+  m_methodId = methodId;
+  m_class = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_METHOD);
+  return v8::Undefined();
+}
+
+/*
+ * Checked on every call so turning stats or tracing on or off applies to methods bound before. The
+ * entry is only looked up again when it no longer matches whether stats are enabled.
+ */
+MethodStats* BoundMethod::getStats() {
+  BridgeStats* stats = m_java->getStats();
+  if(!stats->isEnabled() && !traceEnabled()) {
+    return NULL;
+  }
+  if(m_stats == NULL || m_stats->traceOnly == stats->isEnabled()) {
+    m_stats = stats->get(m_className, m_methodName);
+  }
+  return m_stats;
+}
+
+/*
+ * Converts the arguments straight into jvalues following the parameter types found when binding.
+ * Object parameters are converted with v8ToJava and are local refs owned by the caller. JNI does not
+ * check the types of the arguments it is given, so objects are checked against the parameter class
+ * here; a wrongly typed object would otherwise crash the JVM.
+ */
+bool BoundMethod::argsToJava(JNIEnv* env, const v8::Arguments& args, int start, jvalue* values, std::string& error) {
+  V8ConversionPath conversionPath;
+  for(size_t i=0; i<m_paramTypes.size(); i++) {
+    v8::Local<v8::Value> arg = args[start + i];
+    boundType type = m_paramTypes[i];
+    if(type >= BOUND_TYPE_BYTE && type <= BOUND_TYPE_DOUBLE && TypedValue::HasInstance(arg)) {
+      typedToJValue(arg, type, &values[i]);
+      continue;
+    }
+    if(type >= BOUND_TYPE_BYTE && type <= BOUND_TYPE_DOUBLE && type != BOUND_TYPE_CHAR && !arg->IsNumber()) {
+      std::ostringstream errStr;
+      errStr << "Argument " << (start + i + 1) << " must be a number";
+      error = errStr.str();
+      return false;
+    }
+
+    switch(type) {
+      case BOUND_TYPE_BOOLEAN: values[i].z = arg->BooleanValue(); break;
+      case BOUND_TYPE_BYTE: values[i].b = (jbyte)arg->Int32Value(); break;
+      case BOUND_TYPE_SHORT: values[i].s = (jshort)arg->Int32Value(); break;
+      case BOUND_TYPE_INT: values[i].i = arg->Int32Value(); break;
+      case BOUND_TYPE_LONG: values[i].j = arg->IntegerValue(); break;
+      case BOUND_TYPE_FLOAT: values[i].f = (jfloat)arg->NumberValue(); break;
+      case BOUND_TYPE_DOUBLE: values[i].d = arg->NumberValue(); break;
+      case BOUND_TYPE_CHAR:
+        if(arg->IsString()) {
+          v8::String::Value chars(arg);
+          values[i].c = chars.length() > 0 ? (jchar)(*chars)[0] : 0;
+        } else {
+          values[i].c = (jchar)arg->Int32Value();
+        }
+        break;
+      case BOUND_TYPE_STRING:
+        if(arg->IsNull() || arg->IsUndefined()) {
+          values[i].l = NULL;
+        } else {
+          v8::String::Value chars(arg);
+          values[i].l = env->NewString(*chars, chars.length());
+        }
+        break;
+      case BOUND_TYPE_OBJECT:
+      case BOUND_TYPE_VOID:
+        values[i].l = v8ToJava(env, arg, &conversionPath);
+        if(conversionPath.failed()) {
+          std::ostringstream errStr;
+          errStr << "Argument " << (start + i + 1) << " could not be converted, it contains itself or is nested too deeply";
+          error = errStr.str();
+          return false;
+        }
+        if(values[i].l != NULL && m_paramClasses[i] != NULL && !env->IsInstanceOf(values[i].l, m_paramClasses[i])) {
+          jstring classNameJava = (jstring)env->CallObjectMethod(m_paramClasses[i], javaConversionIds.class_getName);
+          std::ostringstream errStr;
+          errStr << "Argument " << (start + i + 1) << " must be an instance of " << javaToString(env, classNameJava);
+          env->DeleteLocalRef(classNameJava);
+          error = errStr.str();
+          return false;
+        }
+        break;
+    }
+  }
+  return true;
+}
+
+/*
+ * A typed value passed for a primitive parameter is narrowed or widened to that parameter's type the
+ * way a java cast would.
+ */
+void BoundMethod::typedToJValue(v8::Local<v8::Value> arg, boundType type, jvalue* value) {
+  jvalue typed = TypedValue::toJValue(arg);
+  jlong integer = 0;
+  jdouble number = 0;
+  switch(TypedValue::getType(arg)) {
+    case 'J': integer = typed.j; number = (jdouble)typed.j; break;
+    case 'F': integer = (jlong)typed.f; number = typed.f; break;
+    case 'S': integer = typed.s; number = typed.s; break;
+    case 'C': integer = typed.c; number = typed.c; break;
+  }
+
+  switch(type) {
+    case BOUND_TYPE_BYTE: value->b = (jbyte)integer; break;
+    case BOUND_TYPE_CHAR: value->c = (jchar)integer; break;
+    case BOUND_TYPE_SHORT: value->s = (jshort)integer; break;
+    case BOUND_TYPE_INT: value->i = (jint)integer; break;
+    case BOUND_TYPE_LONG: value->j = integer; break;
+    case BOUND_TYPE_FLOAT: value->f = (jfloat)number; break;
+    case BOUND_TYPE_DOUBLE: value->d = number; break;
+    default: break;
+  }
+}
+
+jvalue BoundMethod::invoke(JNIEnv* env, jobject obj, jvalue* values) {
+  jvalue result;
+  result.j = 0;
+  if(m_isStatic) {
+    switch(m_returnType) {
+      case BOUND_TYPE_VOID: env->CallStaticVoidMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_BOOLEAN: result.z = env->CallStaticBooleanMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_BYTE: result.b = env->CallStaticByteMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_CHAR: result.c = env->CallStaticCharMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_SHORT: result.s = env->CallStaticShortMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_INT: result.i = env->CallStaticIntMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_LONG: result.j = env->CallStaticLongMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_FLOAT: result.f = env->CallStaticFloatMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_DOUBLE: result.d = env->CallStaticDoubleMethodA(m_class, m_methodId, values); break;
+      case BOUND_TYPE_STRING:
+      case BOUND_TYPE_OBJECT: result.l = env->CallStaticObjectMethodA(m_class, m_methodId, values); break;
+    }
+  } else {
+    switch(m_returnType) {
+      case BOUND_TYPE_VOID: env->CallVoidMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_BOOLEAN: result.z = env->CallBooleanMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_BYTE: result.b = env->CallByteMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_CHAR: result.c = env->CallCharMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_SHORT: result.s = env->CallShortMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_INT: result.i = env->CallIntMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_LONG: result.j = env->CallLongMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_FLOAT: result.f = env->CallFloatMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_DOUBLE: result.d = env->CallDoubleMethodA(obj, m_methodId, values); break;
+      case BOUND_TYPE_STRING:
+      case BOUND_TYPE_OBJECT: result.l = env->CallObjectMethodA(obj, m_methodId, values); break;
+    }
+  }
+  return result;
+}
+
+v8::Handle<v8::Value> BoundMethod::resultToV8(JNIEnv* env, jvalue result) {
+  v8::HandleScope scope;
+  switch(m_returnType) {
+    case BOUND_TYPE_VOID: return v8::Undefined();
+    case BOUND_TYPE_BOOLEAN: return scope.Close(v8::Boolean::New(result.z));
+    case BOUND_TYPE_BYTE: return scope.Close(v8::Integer::New(result.b));
+    case BOUND_TYPE_CHAR: return scope.Close(v8::String::New(&result.c, 1));
+    case BOUND_TYPE_SHORT: return scope.Close(v8::Integer::New(result.s));
+    case BOUND_TYPE_INT: return scope.Close(v8::Integer::New(result.i));
+    case BOUND_TYPE_LONG: return scope.Close(v8::Number::New((double)result.j));
+    case BOUND_TYPE_FLOAT: return scope.Close(v8::Number::New(result.f));
+    case BOUND_TYPE_DOUBLE: return scope.Close(v8::Number::New(result.d));
+    case BOUND_TYPE_STRING:
+    case BOUND_TYPE_OBJECT: return scope.Close(javaToV8(m_java, env, result.l, m_java->getConversionOptions()));
+  }
+  return v8::Undefined();
+}
+
+/*
+ * The function returned to javascript. Instance methods take the object as their first argument. A
+ * trailing callback runs the method on the thread pool, otherwise it runs synchronously.
+ */
+/*static*/ v8::Handle<v8::Value> BoundMethod::call(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  BoundMethod* self = node::ObjectWrap::Unwrap<BoundMethod>(args.Data()->ToObject());
+  Java* java = self->m_java;
+  JNIEnv *env = java->getJavaEnv();
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
+
+  JavaObject* javaObject = NULL;
+  if(!self->m_isStatic) {
+    if(argsEnd < 1 || !JavaObject::HasInstance(args[0])) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("Argument 1 must be a java object")));
+    }
+    javaObject = node::ObjectWrap::Unwrap<JavaObject>(v8::Local<v8::Object>::Cast(args[0]));
+    if(!env->IsInstanceOf(javaObject->getObject(), self->m_class)) {
+      std::ostringstream errStr;
+      errStr << "Argument 1 must be an instance of " << self->m_className;
+      return ThrowException(v8::Exception::TypeError(v8::String::New(errStr.str().c_str())));
+    }
+    argsStart++;
+  }
+  if((size_t)(argsEnd - argsStart) != self->m_paramTypes.size()) {
+    std::ostringstream errStr;
+    errStr << self->m_className << "." << self->m_methodName << " takes " << self->m_paramTypes.size() << " arguments";
+    return ThrowException(v8::Exception::TypeError(v8::String::New(errStr.str().c_str())));
+  }
+
+  MethodStats* stats = self->getStats();
+  uint64_t phaseStart = statsNow(stats);
+  PUSH_LOCAL_JAVA_FRAME_SIZED(LOCAL_FRAME_SIZE_SMALL + (jint)self->m_paramTypes.size());
+  std::vector<jvalue> values(self->m_paramTypes.size() + 1);
+  std::string argsError;
+  if(!self->argsToJava(env, args, argsStart, &values[0], argsError)) {
+    POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(v8::Exception::TypeError(v8::String::New(argsError.c_str()))));
+  }
+  phaseStart = statsRecordPhase(stats, STATS_PHASE_ARGS, phaseStart);
+
+  if(callbackProvided) {
+    BoundMethodBaton* baton = new BoundMethodBaton(java, self, javaObject ? javaObject->getObject() : NULL, &values[0], callback);
+    baton->setStats(stats);
+    baton->setCallOptions(callOptions);
+    POP_LOCAL_JAVA_FRAME();
+    if(!baton->run()) {
+      return v8::False();
+    }
+    return v8::Undefined();
+  }
+
+  SyncCallGuard syncCallGuard(java->getSyncWatchdog(), self->m_className, self->m_methodName);
+  jvalue result = self->invoke(env, javaObject ? javaObject->getObject() : NULL, &values[0]);
+  phaseStart = statsRecordPhase(stats, STATS_PHASE_EXECUTE, phaseStart);
+  if(env->ExceptionCheck()) {
+    statsRecordCall(stats, true);
+    std::ostringstream errStr;
+    errStr << "Error running " << self->m_className << "." << self->m_methodName;
+    v8::Handle<v8::Value> ex = javaExceptionToV8(env, errStr.str());
+    POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(ex));
+  }
+  statsRecordCall(stats, false);
+  v8::Handle<v8::Value> resultV8 = self->resultToV8(env, result);
+  statsRecordPhase(stats, STATS_PHASE_RESULTS, phaseStart);
+  POP_LOCAL_JAVA_FRAME();
+  return scope.Close(resultV8);
+}
+
+BoundMethodBaton::BoundMethodBaton(
+  Java* java,
+  BoundMethod* boundMethod,
+  jobject obj,
+  jvalue* values,
+  v8::Handle<v8::Value>& callback) : MethodCallBaton(java, NULL, NULL, callback) {
+  JNIEnv *env = m_java->getJavaEnv();
+  m_boundMethod = boundMethod;
+  m_boundMethod->Ref();
+  m_obj = refStatsNewGlobalRef(env, obj, REF_SITE_BATON);
+  m_values.assign(values, values + boundMethod->getParamCount());
+  m_returnValue.j = 0;
+
+  // object arguments are used on another thread, so they need global refs
+  for(size_t i=0; i<m_values.size(); i++) {
+    if(boundMethod->isObjectParam(i)) {
+      m_values[i].l = refStatsNewGlobalRef(env, m_values[i].l, REF_SITE_BATON);
+    }
+  }
+}
+
+BoundMethodBaton::~BoundMethodBaton() {
+  JNIEnv *env = m_java->getJavaEnv();
+  for(size_t i=0; i<m_values.size(); i++) {
+    if(m_boundMethod->isObjectParam(i)) {
+      refStatsDeleteGlobalRef(env, m_values[i].l, REF_SITE_BATON);
+    }
+  }
+  refStatsDeleteGlobalRef(env, m_obj, REF_SITE_BATON);
+  m_boundMethod->Unref();
+}
+
+void BoundMethodBaton::execute(JNIEnv *env) {
+  m_returnValue = m_boundMethod->invoke(env, m_obj, m_values.empty() ? NULL : &m_values[0]);
+
+  jthrowable err = env->ExceptionOccurred();
+  if(err) {
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+    m_errorString = "Error running " + m_boundMethod->getClassName() + "." + m_boundMethod->getMethodName();
+    env->ExceptionClear();
+    env->DeleteLocalRef(err);
+    return;
+  }
+
+  if(m_boundMethod->getReturnType() == BOUND_TYPE_STRING || m_boundMethod->getReturnType() == BOUND_TYPE_OBJECT) {
+    m_result = refStatsNewGlobalRef(env, m_returnValue.l, REF_SITE_BATON);
+    env->DeleteLocalRef(m_returnValue.l);
+    m_returnValue.l = NULL;
+  }
+}
+
+v8::Handle<v8::Value> BoundMethodBaton::resultsToV8(JNIEnv *env) {
+  v8::HandleScope scope;
+
+  if(m_error || m_result || m_nativeResult) {
+    return scope.Close(MethodCallBaton::resultsToV8(env));
+  }
+  return scope.Close(m_boundMethod->resultToV8(env, m_returnValue));
+}
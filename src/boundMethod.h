@@ -0,0 +1,95 @@
+
+#ifndef _boundmethod_h_
+#define _boundmethod_h_
+
+#include <v8.h>
+#include <node.h>
+#include <jni.h>
+#include <string>
+#include <vector>
+#include "methodCallBaton.h"
+
+class Java;
+
+typedef enum _boundType {
+  BOUND_TYPE_VOID    = 0,
+  BOUND_TYPE_BOOLEAN = 1,
+  BOUND_TYPE_BYTE    = 2,
+  BOUND_TYPE_CHAR    = 3,
+  BOUND_TYPE_SHORT   = 4,
+  BOUND_TYPE_INT     = 5,
+  BOUND_TYPE_LONG    = 6,
+  BOUND_TYPE_FLOAT   = 7,
+  BOUND_TYPE_DOUBLE  = 8,
+  BOUND_TYPE_STRING  = 9,
+  BOUND_TYPE_OBJECT  = 10
+} boundType;
+
+/*
+ * A method resolved once by java.getMethod or java.getInstanceMethod. The class, jmethodID and how
+ * each argument converts are worked out when binding, so a call only converts its arguments and
+ * makes one JNI call; no class lookup, overload search or reflection is left for the call itself.
+ * The returned function keeps the BoundMethod alive through its data. v8 never collects it, so
+ * Java::getBoundMethod keeps one per method and the BoundMethod and its java refs live as long as
+ * the Java instance.
+ */
+class BoundMethod : public node::ObjectWrap {
+public:
+  static void Init(v8::Handle<v8::Object> target);
+  static v8::Handle<v8::Value> New(Java* java, const std::string& className, const std::string& methodName, v8::Handle<v8::Value> paramTypes, bool isStatic);
+
+  const std::string& getClassName() { return m_className; }
+  const std::string& getMethodName() { return m_methodName; }
+  size_t getParamCount() { return m_paramTypes.size(); }
+  bool argsToJava(JNIEnv* env, const v8::Arguments& args, int start, jvalue* values, std::string& error);
+  jvalue invoke(JNIEnv* env, jobject obj, jvalue* values);
+  v8::Handle<v8::Value> resultToV8(JNIEnv* env, jvalue result);
+  MethodStats* getStats();
+  boundType getReturnType() { return m_returnType; }
+  bool isObjectParam(size_t i) { return m_paramTypes[i] == BOUND_TYPE_STRING || m_paramTypes[i] == BOUND_TYPE_OBJECT; }
+  bool isStatic() { return m_isStatic; }
+
+  void Ref() { node::ObjectWrap::Ref(); }
+  void Unref() { node::ObjectWrap::Unref(); }
+
+private:
+  BoundMethod(Java* java, const std::string& className, const std::string& methodName, bool isStatic);
+  ~BoundMethod();
+  v8::Handle<v8::Value> bind(JNIEnv* env, jclass clazz, v8::Handle<v8::Value> paramTypes);
+  v8::Handle<v8::Value> bindSignature(JNIEnv* env, jclass clazz, const std::string& signature);
+  static void typedToJValue(v8::Local<v8::Value> arg, boundType type, jvalue* value);
+  static v8::Handle<v8::Value> call(const v8::Arguments& args);
+
+  static v8::Persistent<v8::FunctionTemplate> s_ct;
+  Java* m_java;
+  std::string m_className;
+  std::string m_methodName;
+  bool m_isStatic;
+  jclass m_class;
+  jmethodID m_methodId;
+  std::vector<boundType> m_paramTypes;
+  std::vector<jclass> m_paramClasses;
+  boundType m_returnType;
+  MethodStats* m_stats;
+};
+
+/*
+ * Runs a bound method on the thread pool. Object arguments are held as global refs until the call
+ * is done; primitive results are kept as a jvalue and only boxed into a v8 value on the v8 thread.
+ */
+class BoundMethodBaton : public MethodCallBaton {
+public:
+  BoundMethodBaton(Java* java, BoundMethod* boundMethod, jobject obj, jvalue* values, v8::Handle<v8::Value>& callback);
+  virtual ~BoundMethodBaton();
+
+protected:
+  virtual void execute(JNIEnv *env);
+  virtual v8::Handle<v8::Value> resultsToV8(JNIEnv *env);
+
+  BoundMethod* m_boundMethod;
+  jobject m_obj;
+  std::vector<jvalue> m_values;
+  jvalue m_returnValue;
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include "bridgeStats.h"
+#include <string.h>
+
+#ifdef WIN32
+  #include <windows.h>
+  #define STATS_ATOMIC_ADD(PTR, VAL) InterlockedExchangeAdd64((volatile LONGLONG*)(PTR), (LONGLONG)(VAL))
+  #define STATS_ATOMIC_CAS(PTR, OLDVAL, NEWVAL) ((uint64_t)InterlockedCompareExchange64((volatile LONGLONG*)(PTR), (LONGLONG)(NEWVAL), (LONGLONG)(OLDVAL)) == (OLDVAL))
+#else
+  #define STATS_ATOMIC_ADD(PTR, VAL) __sync_fetch_and_add((PTR), (VAL))
+  #define STATS_ATOMIC_CAS(PTR, OLDVAL, NEWVAL) __sync_bool_compare_and_swap((PTR), (OLDVAL), (NEWVAL))
+#endif
+
+static const char* statsPhaseNames[STATS_PHASE_COUNT] = { "resolve", "args", "queue", "execute", "results" };
+
+BridgeStats::BridgeStats() {
+  m_enabled = false;
+}
+
+BridgeStats::~BridgeStats() {
+  for(std::map<std::string, MethodStats*>::iterator it = m_methods.begin(); it != m_methods.end(); it++) {
+    delete it->second;
+  }
+  for(std::map<std::string, MethodStats*>::iterator it = m_traceOnlyMethods.begin(); it != m_traceOnlyMethods.end(); it++) {
+    delete it->second;
+  }
+}
+
+MethodStats* BridgeStats::get(const std::string& className, const std::string& methodName) {
+  if(!m_enabled && !traceEnabled()) {
+    return NULL;
+  }
+
+  std::map<std::string, MethodStats*>* methods = m_enabled ? &m_methods : &m_traceOnlyMethods;
+  std::string key = className + "." + methodName;
+  std::map<std::string, MethodStats*>::iterator it = methods->find(key);
+  if(it != methods->end()) {
+    return it->second;
+  }
+
+  MethodStats* stats = new MethodStats();
+  memset((void*)stats->phases, 0, sizeof(stats->phases));
+  stats->owner = this;
+  stats->traceOnly = !m_enabled;
+  stats->key = key;
+  stats->className = className;
+  stats->methodName = methodName;
+  stats->calls = 0;
+  stats->errors = 0;
+  (*methods)[key] = stats;
+  return stats;
+}
+
+/*
+ * Zeroes the counters instead of freeing the entries since calls in flight still point at them.
+ */
+void BridgeStats::reset() {
+  for(std::map<std::string, MethodStats*>::iterator it = m_methods.begin(); it != m_methods.end(); it++) {
+    MethodStats* stats = it->second;
+    stats->calls = 0;
+    stats->errors = 0;
+    memset((void*)stats->phases, 0, sizeof(stats->phases));
+  }
+}
+
+v8::Handle<v8::Object> BridgeStats::toV8() {
+  v8::HandleScope scope;
+  v8::Local<v8::Object> result = v8::Object::New();
+
+  for(std::map<std::string, MethodStats*>::iterator it = m_methods.begin(); it != m_methods.end(); it++) {
+    MethodStats* stats = it->second;
+    v8::Local<v8::Object> methodObj = v8::Object::New();
+    methodObj->Set(v8::String::New("className"), v8::String::New(stats->className.c_str()));
+    methodObj->Set(v8::String::New("methodName"), v8::String::New(stats->methodName.c_str()));
+    methodObj->Set(v8::String::New("calls"), v8::Number::New((double)stats->calls));
+    methodObj->Set(v8::String::New("errors"), v8::Number::New((double)stats->errors));
+
+    for(int phase=0; phase<STATS_PHASE_COUNT; phase++) {
+      PhaseStats* phaseStats = &stats->phases[phase];
+      v8::Local<v8::Object> phaseObj = v8::Object::New();
+      phaseObj->Set(v8::String::New("count"), v8::Number::New((double)phaseStats->count));
+      phaseObj->Set(v8::String::New("totalMs"), v8::Number::New((double)phaseStats->totalNs / 1000000.0));
+      phaseObj->Set(v8::String::New("maxMs"), v8::Number::New((double)phaseStats->maxNs / 1000000.0));
+
+      int lastBucket = -1;
+      for(int i=0; i<STATS_HISTOGRAM_BUCKETS; i++) {
+        if(phaseStats->histogram[i] > 0) {
+          lastBucket = i;
+        }
+      }
+      v8::Local<v8::Array> histogram = v8::Array::New(lastBucket + 1);
+      for(int i=0; i<=lastBucket; i++) {
+        histogram->Set(i, v8::Number::New((double)phaseStats->histogram[i]));
+      }
+      phaseObj->Set(v8::String::New("histogram"), histogram);
+
+      methodObj->Set(v8::String::New(statsPhaseNames[phase]), phaseObj);
+    }
+
+    result->Set(v8::String::New(it->first.c_str()), methodObj);
+  }
+
+  return scope.Close(result);
+}
+
+uint64_t statsNow(MethodStats* stats) {
+  if(stats == NULL) {
+    return 0;
+  }
+  return uv_hrtime();
+}
+
+uint64_t statsRecordPhase(MethodStats* stats, statsPhase phase, uint64_t start) {
+  if(stats == NULL) {
+    return 0;
+  }
+  uint64_t now = uv_hrtime();
+  if(start == 0) {
+    return now;
+  }
+  statsRecordDuration(stats, phase, now - start);
+  traceComplete("call", statsPhaseNames[phase], stats->key.c_str(), start, now);
+  return now;
+}
+
+void statsRecordDuration(MethodStats* stats, statsPhase phase, uint64_t elapsedNs) {
+  if(stats == NULL || stats->traceOnly || !stats->owner->isEnabled()) {
+    return;
+  }
+  PhaseStats* phaseStats = &stats->phases[phase];
+
+  int bucket = 0;
+  uint64_t elapsedUs = elapsedNs / 1000;
+  while(elapsedUs > 1 && bucket < STATS_HISTOGRAM_BUCKETS - 1) {
+    elapsedUs >>= 1;
+    bucket++;
+  }
+
+  STATS_ATOMIC_ADD(&phaseStats->count, 1);
+  STATS_ATOMIC_ADD(&phaseStats->totalNs, elapsedNs);
+  STATS_ATOMIC_ADD(&phaseStats->histogram[bucket], 1);
+  uint64_t maxNs = phaseStats->maxNs;
+  while(elapsedNs > maxNs && !STATS_ATOMIC_CAS(&phaseStats->maxNs, maxNs, elapsedNs)) {
+    maxNs = phaseStats->maxNs;
+  }
+}
+
+void statsRecordCall(MethodStats* stats, bool error) {
+  if(stats == NULL || stats->traceOnly || !stats->owner->isEnabled()) {
+    return;
+  }
+  STATS_ATOMIC_ADD(&stats->calls, 1);
+  if(error) {
+    STATS_ATOMIC_ADD(&stats->errors, 1);
+  }
+}
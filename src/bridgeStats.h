@@ -0,0 +1,74 @@
+#ifndef _bridgestats_h_
+#define _bridgestats_h_
+
+#include <v8.h>
+#include <uv.h>
+#include <map>
+#include <string>
+#include "bridgeTrace.h"
+
+class BridgeStats;
+
+typedef enum _statsPhase {
+  STATS_PHASE_RESOLVE = 0,
+  STATS_PHASE_ARGS    = 1,
+  STATS_PHASE_QUEUE   = 2,
+  STATS_PHASE_EXECUTE = 3,
+  STATS_PHASE_RESULTS = 4,
+  STATS_PHASE_COUNT   = 5
+} statsPhase;
+
+// bucket i counts durations of [2^i, 2^(i+1)) microseconds, bucket 0 also counts anything faster
+#define STATS_HISTOGRAM_BUCKETS 32
+
+struct PhaseStats {
+  volatile uint64_t count;
+  volatile uint64_t totalNs;
+  volatile uint64_t maxNs;
+  volatile uint64_t histogram[STATS_HISTOGRAM_BUCKETS];
+};
+
+/*
+ * Counters for one method. Entries are created on the v8 thread and never freed while the Java
+ * instance is alive, so batons can update them from worker threads through a plain pointer. While
+ * only tracing is on, get hands out traceOnly entries instead. They are kept apart from the stats,
+ * never count anything and just name the trace events.
+ */
+struct MethodStats {
+  BridgeStats* owner;
+  bool traceOnly;
+  std::string key;
+  std::string className;
+  std::string methodName;
+  volatile uint64_t calls;
+  volatile uint64_t errors;
+  PhaseStats phases[STATS_PHASE_COUNT];
+};
+
+class BridgeStats {
+public:
+  BridgeStats();
+  ~BridgeStats();
+
+  bool isEnabled() { return m_enabled; }
+  void setEnabled(bool enabled) { m_enabled = enabled; }
+  MethodStats* get(const std::string& className, const std::string& methodName);
+  void reset();
+  v8::Handle<v8::Object> toV8();
+
+private:
+  bool m_enabled;
+  std::map<std::string, MethodStats*> m_methods;
+  std::map<std::string, MethodStats*> m_traceOnlyMethods;
+};
+
+/*
+ * Helpers that do nothing when stats is NULL, which is what BridgeStats::get returns while stats and
+ * tracing are disabled. statsRecordPhase returns the current time so consecutive phases can be chained.
+ */
+uint64_t statsNow(MethodStats* stats);
+uint64_t statsRecordPhase(MethodStats* stats, statsPhase phase, uint64_t start);
+void statsRecordDuration(MethodStats* stats, statsPhase phase, uint64_t elapsedNs);
+void statsRecordCall(MethodStats* stats, bool error);
+
+#endif
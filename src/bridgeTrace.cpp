@@ -0,0 +1,176 @@
+#include "bridgeTrace.h"
+#include <string.h>
+#include <sstream>
+#include <vector>
+
+#ifdef WIN32
+  #include <windows.h>
+  #define TRACE_THREAD_LOCAL __declspec(thread)
+  #define TRACE_MEMORY_BARRIER() MemoryBarrier()
+#else
+  #define TRACE_THREAD_LOCAL __thread
+  #define TRACE_MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+volatile bool traceEnabledFlag = false;
+static volatile uint32_t traceGeneration = 0;
+static uint64_t traceStartNs = 0;
+static TRACE_THREAD_LOCAL TraceBuffer* traceThreadBuffer = NULL;
+
+// buffers are registered once per thread and live as long as the process
+static uv_mutex_t traceBuffersMutex;
+static bool traceBuffersMutexInitialized = false;
+static std::vector<TraceBuffer*> traceBuffers;
+
+static TraceBuffer* traceGetThreadBuffer() {
+  TraceBuffer* buffer = traceThreadBuffer;
+  if(buffer == NULL) {
+    buffer = new TraceBuffer();
+    buffer->threadName = NULL;
+    buffer->generation = traceGeneration;
+    buffer->count = 0;
+    buffer->dropped = 0;
+    memset(buffer->chunks, 0, sizeof(buffer->chunks));
+    uv_mutex_lock(&traceBuffersMutex);
+    buffer->threadId = (int)traceBuffers.size() + 1;
+    traceBuffers.push_back(buffer);
+    uv_mutex_unlock(&traceBuffersMutex);
+    traceThreadBuffer = buffer;
+  }
+
+  // only the owning thread resets its buffer, when it first records after a new trace was started
+  if(buffer->generation != traceGeneration) {
+    buffer->count = 0;
+    buffer->dropped = 0;
+    TRACE_MEMORY_BARRIER();
+    buffer->generation = traceGeneration;
+  }
+  return buffer;
+}
+
+void traceSetThreadName(const char* threadName) {
+  traceGetThreadBuffer()->threadName = threadName;
+}
+
+/*
+ * Called on the v8 thread. Starting a new trace discards the events of the previous one.
+ */
+void traceStart() {
+  if(!traceBuffersMutexInitialized) {
+    uv_mutex_init(&traceBuffersMutex);
+    traceBuffersMutexInitialized = true;
+  }
+  traceStartNs = uv_hrtime();
+  traceGeneration++;
+  traceSetThreadName("v8");
+  TRACE_MEMORY_BARRIER();
+  traceEnabledFlag = true;
+}
+
+void traceComplete(const char* category, const char* name, const char* detail, uint64_t startNs, uint64_t endNs) {
+  if(!traceEnabledFlag || startNs == 0) {
+    return;
+  }
+  TraceBuffer* buffer = traceGetThreadBuffer();
+  size_t index = buffer->count;
+  if(index >= TRACE_BUFFER_EVENTS) {
+    buffer->dropped++;
+    return;
+  }
+  TraceEvent* chunk = buffer->chunks[index / TRACE_CHUNK_EVENTS];
+  if(chunk == NULL) {
+    chunk = new TraceEvent[TRACE_CHUNK_EVENTS];
+    buffer->chunks[index / TRACE_CHUNK_EVENTS] = chunk;
+  }
+  TraceEvent* event = &chunk[index % TRACE_CHUNK_EVENTS];
+  event->category = category;
+  event->name = name;
+  if(detail) {
+    strncpy(event->detail, detail, TRACE_DETAIL_LENGTH - 1);
+    event->detail[TRACE_DETAIL_LENGTH - 1] = '\0';
+  } else {
+    event->detail[0] = '\0';
+  }
+  event->startNs = startNs;
+  event->durationNs = endNs > startNs ? endNs - startNs : 0;
+  TRACE_MEMORY_BARRIER();
+  buffer->count = index + 1;
+}
+
+static void traceWriteJsonString(std::ostringstream& out, const char* str) {
+  out << '"';
+  for(const char* p = str; *p; p++) {
+    switch(*p) {
+      case '"': out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      default:
+        if((unsigned char)*p < 0x20) {
+          out << ' ';
+        } else {
+          out << *p;
+        }
+    }
+  }
+  out << '"';
+}
+
+/*
+ * Stops recording and returns the events of every thread in the chrome trace event format.
+ * Events still being recorded on other threads when tracing stops may or may not be included.
+ */
+std::string traceStop() {
+  traceEnabledFlag = false;
+  TRACE_MEMORY_BARRIER();
+
+  std::ostringstream out;
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  size_t dropped = 0;
+
+  if(traceBuffersMutexInitialized) {
+    uv_mutex_lock(&traceBuffersMutex);
+    for(std::vector<TraceBuffer*>::iterator it = traceBuffers.begin(); it != traceBuffers.end(); it++) {
+      TraceBuffer* buffer = *it;
+      if(buffer->generation != traceGeneration) {
+        continue;
+      }
+      size_t count = buffer->count;
+      TRACE_MEMORY_BARRIER();
+      dropped += buffer->dropped;
+
+      if(!first) { out << ","; }
+      first = false;
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+      if(buffer->threadName) {
+        traceWriteJsonString(out, buffer->threadName);
+      } else {
+        out << "\"thread " << buffer->threadId << "\"";
+      }
+      out << "}}";
+
+      for(size_t i=0; i<count; i++) {
+        TraceEvent* event = &buffer->chunks[i / TRACE_CHUNK_EVENTS][i % TRACE_CHUNK_EVENTS];
+        if(event->startNs < traceStartNs) {
+          continue;
+        }
+        out << ",{\"name\":";
+        traceWriteJsonString(out, event->name);
+        out << ",\"cat\":";
+        traceWriteJsonString(out, event->category);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId;
+        out << ",\"ts\":" << ((double)(event->startNs - traceStartNs) / 1000.0);
+        out << ",\"dur\":" << ((double)event->durationNs / 1000.0);
+        if(event->detail[0]) {
+          out << ",\"args\":{\"detail\":";
+          traceWriteJsonString(out, event->detail);
+          out << "}";
+        }
+        out << "}";
+      }
+    }
+    uv_mutex_unlock(&traceBuffersMutex);
+  }
+
+  out << "],\"otherData\":{\"droppedEvents\":" << dropped << "}}";
+  return out.str();
+}
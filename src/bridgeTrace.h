@@ -0,0 +1,43 @@
+#ifndef _bridgetrace_h_
+#define _bridgetrace_h_
+
+#include <uv.h>
+#include <string>
+
+#define TRACE_BUFFER_EVENTS 16384
+#define TRACE_CHUNK_EVENTS 256
+#define TRACE_BUFFER_CHUNKS (TRACE_BUFFER_EVENTS / TRACE_CHUNK_EVENTS)
+#define TRACE_DETAIL_LENGTH 48
+
+struct TraceEvent {
+  const char* category;
+  const char* name;
+  char detail[TRACE_DETAIL_LENGTH];
+  uint64_t startNs;
+  uint64_t durationNs;
+};
+
+/*
+ * Each thread appends to its own buffer so recording needs no lock. An event is written before
+ * count is published, so a reader on another thread only sees complete events. Events are stored in
+ * chunks allocated as the buffer fills, so a thread that records little holds little memory; chunks
+ * are kept for the next trace once allocated.
+ */
+struct TraceBuffer {
+  int threadId;
+  const char* threadName;
+  volatile uint32_t generation;
+  volatile size_t count;
+  volatile size_t dropped;
+  TraceEvent* chunks[TRACE_BUFFER_CHUNKS];
+};
+
+extern volatile bool traceEnabledFlag;
+
+inline bool traceEnabled() { return traceEnabledFlag; }
+void traceStart();
+std::string traceStop();
+void traceComplete(const char* category, const char* name, const char* detail, uint64_t startNs, uint64_t endNs);
+void traceSetThreadName(const char* threadName);
+
+#endif
@@ -0,0 +1,100 @@
+#include "callOptions.h"
+#include "methodCallBaton.h"
+#include <string.h>
+#include <sstream>
+
+/*static*/ v8::Persistent<v8::FunctionTemplate> CallOptions::s_ct;
+
+/*static*/ void CallOptions::Init(v8::Handle<v8::Object> target) {
+  v8::HandleScope scope;
+
+  v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New();
+  s_ct = v8::Persistent<v8::FunctionTemplate>::New(t);
+  s_ct->InstanceTemplate()->SetInternalFieldCount(1);
+  s_ct->SetClassName(v8::String::NewSymbol("CallOptions"));
+
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "cancel", cancel);
+}
+
+/*static*/ v8::Handle<v8::Value> CallOptions::New(v8::Handle<v8::Object> options) {
+  v8::HandleScope scope;
+
+  v8::Local<v8::Function> ctor = s_ct->GetFunction();
+  v8::Local<v8::Object> callOptionsObj = ctor->NewInstance();
+  CallOptions *self = new CallOptions();
+  self->Wrap(callOptionsObj);
+
+  v8::Handle<v8::Value> parseResults = self->parse(options);
+  if(!parseResults->IsUndefined()) {
+    return parseResults;
+  }
+
+  return scope.Close(callOptionsObj);
+}
+
+/*static*/ bool CallOptions::HasInstance(v8::Handle<v8::Value> val) {
+  return val->IsObject() && s_ct->HasInstance(val);
+}
+
+CallOptions::CallOptions() {
+  m_priority = CALL_PRIORITY_NORMAL;
+  m_timeout = 0;
+  m_hasConversionOptions = false;
+  conversionOptionsInit(&m_conversionOptions);
+}
+
+CallOptions::~CallOptions() {
+
+}
+
+v8::Handle<v8::Value> CallOptions::parse(v8::Handle<v8::Object> options) {
+  v8::Local<v8::Value> priority = options->Get(v8::String::New("priority"));
+  if(priority->IsString()) {
+    v8::String::AsciiValue priorityStr(priority);
+    if(strcmp(*priorityStr, "interactive") == 0) {
+      m_priority = CALL_PRIORITY_INTERACTIVE;
+    } else if(strcmp(*priorityStr, "normal") == 0) {
+      m_priority = CALL_PRIORITY_NORMAL;
+    } else if(strcmp(*priorityStr, "bulk") == 0) {
+      m_priority = CALL_PRIORITY_BULK;
+    } else {
+      std::ostringstream errStr;
+      errStr << "Invalid priority \"" << *priorityStr << "\", must be one of interactive, normal or bulk";
+      return ThrowException(v8::Exception::TypeError(v8::String::New(errStr.str().c_str())));
+    }
+  } else if(!priority->IsUndefined()) {
+    return ThrowException(v8::Exception::TypeError(v8::String::New("priority must be a string")));
+  }
+
+  v8::Local<v8::Value> timeout = options->Get(v8::String::New("timeout"));
+  if(!timeout->IsUndefined()) {
+    if(!timeout->IsNumber() || timeout->NumberValue() < 0) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("timeout must be a positive number")));
+    }
+    m_timeout = timeout->NumberValue();
+  }
+
+  v8::Local<v8::Value> signature = options->Get(v8::String::New("signature"));
+  if(signature->IsString()) {
+    v8::String::AsciiValue signatureStr(signature);
+    m_signature = *signatureStr;
+  } else if(!signature->IsUndefined()) {
+    return ThrowException(v8::Exception::TypeError(v8::String::New("signature must be a string")));
+  }
+
+  return conversionOptionsParse(options, &m_conversionOptions, &m_hasConversionOptions);
+}
+
+/*static*/ v8::Handle<v8::Value> CallOptions::cancel(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  CallOptions* self = node::ObjectWrap::Unwrap<CallOptions>(args.This());
+
+  // the batons are taken off the list before any is cancelled, a queued baton is freed by cancel
+  std::list<MethodCallBaton*> batons;
+  batons.swap(self->m_batons);
+  for(std::list<MethodCallBaton*>::iterator it = batons.begin(); it != batons.end(); it++) {
+    (*it)->cancel("Call cancelled", "ECANCELED");
+  }
+
+  return v8::Undefined();
+}
@@ -0,0 +1,49 @@
+#ifndef _calloptions_h_
+#define _calloptions_h_
+
+#include <v8.h>
+#include <node.h>
+#include <list>
+#include <string>
+#include "nativeValue.h"
+
+class MethodCallBaton;
+
+#define CALL_PRIORITY_INTERACTIVE 0
+#define CALL_PRIORITY_NORMAL      1
+#define CALL_PRIORITY_BULK        2
+#define CALL_PRIORITY_COUNT       3
+
+class CallOptions : public node::ObjectWrap {
+public:
+  static void Init(v8::Handle<v8::Object> target);
+  static v8::Handle<v8::Value> New(v8::Handle<v8::Object> options);
+  static bool HasInstance(v8::Handle<v8::Value> val);
+
+  int getPriority() { return m_priority; }
+  double getTimeout() { return m_timeout; }
+  bool hasConversionOptions() { return m_hasConversionOptions; }
+  const ConversionOptions& getConversionOptions() { return m_conversionOptions; }
+  const std::string& getSignature() { return m_signature; }
+  void addBaton(MethodCallBaton* baton) { m_batons.push_back(baton); }
+  void removeBaton(MethodCallBaton* baton) { m_batons.remove(baton); }
+
+  void Ref() { node::ObjectWrap::Ref(); }
+  void Unref() { node::ObjectWrap::Unref(); }
+
+private:
+  CallOptions();
+  ~CallOptions();
+  v8::Handle<v8::Value> parse(v8::Handle<v8::Object> options);
+  static v8::Handle<v8::Value> cancel(const v8::Arguments& args);
+
+  static v8::Persistent<v8::FunctionTemplate> s_ct;
+  int m_priority;
+  double m_timeout;
+  bool m_hasConversionOptions;
+  ConversionOptions m_conversionOptions;
+  std::string m_signature;
+  std::list<MethodCallBaton*> m_batons;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "callStub.h"
+
+// the descriptors of the parameters in a method signature, which the generator has already checked
+static void callStubParamDescriptors(const char* signature, std::vector<std::string>* descriptors) {
+  std::string sig = signature;
+  size_t pos = 1;
+  while(pos < sig.size() && sig[pos] != ')') {
+    size_t start = pos;
+    while(sig[pos] == '[') {
+      pos++;
+    }
+    pos = sig[pos] == 'L' ? sig.find(';', pos) + 1 : pos + 1;
+    descriptors->push_back(sig.substr(start, pos - start));
+  }
+}
+
+// strings convert without a check, other objects and arrays are checked against their class
+static bool callStubIsCheckedParam(const std::string& descriptor) {
+  return (descriptor[0] == 'L' || descriptor[0] == '[') && descriptor != "Ljava/lang/String;";
+}
+
+/*
+ * Runs once the JVM is up. A stub whose class, method or parameter classes can not be found is left
+ * unresolved and throws when called, so one stale entry does not keep the rest from working.
+ */
+void callStubsResolve(JNIEnv* env) {
+  for(size_t i=0; i<callStubCount; i++) {
+    CallStubInfo* info = &callStubTable[i];
+    std::string className = info->className;
+    jclass clazz = javaFindClass(env, className);
+    if(clazz == NULL) {
+      env->ExceptionClear();
+      continue;
+    }
+    jmethodID methodId = info->isStatic
+      ? env->GetStaticMethodID(clazz, info->methodName, info->signature)
+      : env->GetMethodID(clazz, info->methodName, info->signature);
+    if(methodId == NULL) {
+      env->ExceptionClear();
+      env->DeleteLocalRef(clazz);
+      continue;
+    }
+
+    std::vector<std::string> descriptors;
+    callStubParamDescriptors(info->signature, &descriptors);
+    jclass* paramClasses = new jclass[descriptors.size() + 1];
+    bool resolved = true;
+    for(size_t p=0; p<descriptors.size(); p++) {
+      paramClasses[p] = NULL;
+      if(!resolved || !callStubIsCheckedParam(descriptors[p])) {
+        continue;
+      }
+      // FindClass takes the internal name of a class but the whole descriptor of an array
+      std::string paramClassName = descriptors[p][0] == 'L' ? descriptors[p].substr(1, descriptors[p].size() - 2) : descriptors[p];
+      jclass paramClass = env->FindClass(paramClassName.c_str());
+      if(paramClass == NULL) {
+        env->ExceptionClear();
+        resolved = false;
+        continue;
+      }
+      paramClasses[p] = (jclass)refStatsNewGlobalRef(env, paramClass, REF_SITE_METHOD);
+      env->DeleteLocalRef(paramClass);
+    }
+    if(!resolved) {
+      for(size_t p=0; p<descriptors.size(); p++) {
+        refStatsDeleteGlobalRef(env, paramClasses[p], REF_SITE_METHOD);
+      }
+      delete[] paramClasses;
+      env->DeleteLocalRef(clazz);
+      continue;
+    }
+
+    info->clazz = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_METHOD);
+    info->methodId = methodId;
+    info->paramClasses = paramClasses;
+    env->DeleteLocalRef(clazz);
+  }
+}
+
+/*
+ * Builds java.stubs: one object per class, holding a <jsName>Sync function per stub.
+ */
+v8::Handle<v8::Object> callStubsToV8(Java* java) {
+  v8::HandleScope scope;
+  v8::Local<v8::Object> result = v8::Object::New();
+  for(size_t i=0; i<callStubCount; i++) {
+    CallStubInfo* info = &callStubTable[i];
+    info->java = java;
+
+    v8::Local<v8::String> className = v8::String::New(info->className);
+    v8::Local<v8::Value> classStubs = result->Get(className);
+    if(!classStubs->IsObject()) {
+      classStubs = v8::Object::New();
+      result->Set(className, classStubs);
+    }
+    std::string functionName = std::string(info->jsName) + "Sync";
+    v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New(info->callback, v8::External::Wrap(info));
+    classStubs->ToObject()->Set(v8::String::New(functionName.c_str()), t->GetFunction());
+  }
+  return scope.Close(result);
+}
+
+/*
+ * Returns NULL, with an exception thrown, if the stub can not be called.
+ */
+CallStubInfo* callStubPrepare(const v8::Arguments& args, int argCount) {
+  CallStubInfo* info = (CallStubInfo*)v8::External::Unwrap(args.Data());
+  v8::Handle<v8::Value> ensureJvmResults = info->java->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    ThrowException(ensureJvmResults);
+    return NULL;
+  }
+
+  std::ostringstream errStr;
+  if(info->methodId == NULL) {
+    errStr << "Could not resolve the stub for " << info->className << "." << info->methodName << info->signature;
+    ThrowException(v8::Exception::Error(v8::String::New(errStr.str().c_str())));
+    return NULL;
+  }
+  if(args.Length() != argCount) {
+    errStr << info->className << "." << info->jsName << "Sync takes " << argCount << " arguments";
+    ThrowException(v8::Exception::TypeError(v8::String::New(errStr.str().c_str())));
+    return NULL;
+  }
+  return info;
+}
+
+/*
+ * index is that of the parameter; instance stubs take the object before it, so their argument numbers
+ * are one higher.
+ */
+v8::Handle<v8::Value> callStubArgError(JNIEnv* env, CallStubInfo* info, int index, V8ConversionPath* path) {
+  std::vector<std::string> descriptors;
+  callStubParamDescriptors(info->signature, &descriptors);
+  const std::string& descriptor = descriptors[index];
+
+  std::ostringstream errStr;
+  errStr << "Argument " << (index + (info->isStatic ? 1 : 2)) << " of " << info->className << "." << info->jsName << "Sync ";
+  if(path->failed()) {
+    errStr << "could not be converted, it contains itself or is nested too deeply";
+  } else if(callStubIsCheckedParam(descriptor)) {
+    jstring classNameJava = (jstring)env->CallObjectMethod(info->paramClasses[index], javaConversionIds.class_getName);
+    errStr << "must be an instance of " << javaToString(env, classNameJava);
+    env->DeleteLocalRef(classNameJava);
+  } else if(descriptor == "C") {
+    errStr << "must be a string or a number";
+  } else {
+    errStr << "must be a number";
+  }
+  return v8::Exception::TypeError(v8::String::New(errStr.str().c_str()));
+}
+
+v8::Handle<v8::Value> callStubException(JNIEnv* env, CallStubInfo* info) {
+  std::ostringstream errStr;
+  errStr << "Error running " << info->className << "." << info->methodName;
+  return javaExceptionToV8(env, errStr.str());
+}
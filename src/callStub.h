@@ -0,0 +1,292 @@
+
+#ifndef _callstub_h_
+#define _callstub_h_
+
+#include <v8.h>
+#include <node.h>
+#include <jni.h>
+#include <string>
+#include <sstream>
+#include "java.h"
+#include "javaObject.h"
+#include "utils.h"
+
+/*
+ * Call stubs are synchronous functions generated ahead of time by tools/generate-stubs.js for a fixed
+ * set of methods. Each one is an instantiation of StaticStub or InstanceStub on the method's return
+ * and parameter types, so how every argument converts and which Call<Type>MethodA runs is settled by
+ * the compiler. The jmethodIDs and the classes of object parameters are resolved once, when the JVM
+ * is created. A call then converts its arguments, checks object arguments with IsInstanceOf, makes
+ * one JNI call and converts the result, with no reflection or boxing.
+ *
+ * The generated src/callStubs.cpp defines callStubTable; the stubs are exposed as java.stubs.
+ */
+struct CallStubInfo {
+  const char* className;
+  const char* methodName;
+  const char* signature;
+  const char* jsName;
+  bool isStatic;
+  v8::InvocationCallback callback;
+  Java* java;
+  jclass clazz;
+  jmethodID methodId;
+  jclass* paramClasses;
+};
+
+extern CallStubInfo callStubTable[];
+extern size_t callStubCount;
+
+void callStubsResolve(JNIEnv* env);
+v8::Handle<v8::Object> callStubsToV8(Java* java);
+CallStubInfo* callStubPrepare(const v8::Arguments& args, int argCount);
+
+// stands in for jstring in the type lists, some jni.h define jstring as jobject
+struct StubString {};
+
+/*
+ * Parameter conversions, one specialization per JNI type. Objects other than strings go through
+ * v8ToJava and are local refs released with the stub's frame; since JNI does not check the types of
+ * the arguments it is given, they are checked against paramClass, the class of the parameter.
+ */
+template<typename T> struct StubArg;
+
+#define STUB_ARG_NUMBER(TYPE, FIELD, EXPR) \
+  template<> struct StubArg<TYPE> {                                                                                           \
+    static bool toJava(JNIEnv* env, v8::Local<v8::Value> arg, jclass paramClass, V8ConversionPath* path, jvalue* value) {     \
+      if(!arg->IsNumber()) {                                                                                                  \
+        return false;                                                                                                         \
+      }                                                                                                                       \
+      value->FIELD = (TYPE)EXPR;                                                                                              \
+      return true;                                                                                                            \
+    }                                                                                                                         \
+  };
+
+STUB_ARG_NUMBER(jbyte, b, arg->Int32Value())
+STUB_ARG_NUMBER(jshort, s, arg->Int32Value())
+STUB_ARG_NUMBER(jint, i, arg->Int32Value())
+STUB_ARG_NUMBER(jlong, j, arg->IntegerValue())
+STUB_ARG_NUMBER(jfloat, f, arg->NumberValue())
+STUB_ARG_NUMBER(jdouble, d, arg->NumberValue())
+
+template<> struct StubArg<jboolean> {
+  static bool toJava(JNIEnv* env, v8::Local<v8::Value> arg, jclass paramClass, V8ConversionPath* path, jvalue* value) {
+    value->z = arg->BooleanValue();
+    return true;
+  }
+};
+
+template<> struct StubArg<jchar> {
+  static bool toJava(JNIEnv* env, v8::Local<v8::Value> arg, jclass paramClass, V8ConversionPath* path, jvalue* value) {
+    if(arg->IsString()) {
+      v8::String::Value chars(arg);
+      value->c = chars.length() > 0 ? (jchar)(*chars)[0] : 0;
+      return true;
+    }
+    if(!arg->IsNumber()) {
+      return false;
+    }
+    value->c = (jchar)arg->Int32Value();
+    return true;
+  }
+};
+
+template<> struct StubArg<StubString> {
+  static bool toJava(JNIEnv* env, v8::Local<v8::Value> arg, jclass paramClass, V8ConversionPath* path, jvalue* value) {
+    if(arg->IsNull() || arg->IsUndefined()) {
+      value->l = NULL;
+      return true;
+    }
+    v8::String::Value chars(arg);
+    value->l = env->NewString(*chars, chars.length());
+    return true;
+  }
+};
+
+template<> struct StubArg<jobject> {
+  static bool toJava(JNIEnv* env, v8::Local<v8::Value> arg, jclass paramClass, V8ConversionPath* path, jvalue* value) {
+    value->l = v8ToJava(env, arg, path);
+    if(path->failed()) {
+      return false;
+    }
+    return value->l == NULL || env->IsInstanceOf(value->l, paramClass);
+  }
+};
+
+/*
+ * The parameter list as a type list, eg. StubArgs<jint, StubArgs<StubString, StubArgsEnd> >, since
+ * variadic templates are not available.
+ */
+struct StubArgsEnd {
+  enum { count = 0 };
+  static int toJava(JNIEnv* env, const v8::Arguments& args, int start, int index, CallStubInfo* info, V8ConversionPath* path, jvalue* values) {
+    return -1;
+  }
+};
+
+template<typename T, typename Rest>
+struct StubArgs {
+  enum { count = 1 + Rest::count };
+
+  // returns the index of the first argument that could not be converted, or -1
+  static int toJava(JNIEnv* env, const v8::Arguments& args, int start, int index, CallStubInfo* info, V8ConversionPath* path, jvalue* values) {
+    if(!StubArg<T>::toJava(env, args[start + index], info->paramClasses[index], path, &values[index])) {
+      return index;
+    }
+    return Rest::toJava(env, args, start, index + 1, info, path, values);
+  }
+};
+
+/*
+ * Return conversions, one specialization per JNI type.
+ */
+template<typename R> struct StubReturn;
+
+#define STUB_RETURN_PRIMITIVE(TYPE, NAME, FIELD, V8EXPR) \
+  template<> struct StubReturn<TYPE> {                                                                   \
+    static jvalue callStatic(JNIEnv* env, jclass clazz, jmethodID methodId, jvalue* values) {            \
+      jvalue result;                                                                                     \
+      result.FIELD = env->CallStatic##NAME##MethodA(clazz, methodId, values);                            \
+      return result;                                                                                     \
+    }                                                                                                    \
+    static jvalue call(JNIEnv* env, jobject obj, jmethodID methodId, jvalue* values) {                   \
+      jvalue result;                                                                                     \
+      result.FIELD = env->Call##NAME##MethodA(obj, methodId, values);                                    \
+      return result;                                                                                     \
+    }                                                                                                    \
+    static v8::Handle<v8::Value> toV8(Java* java, JNIEnv* env, jvalue result) {                          \
+      return V8EXPR;                                                                                     \
+    }                                                                                                    \
+  };
+
+STUB_RETURN_PRIMITIVE(jboolean, Boolean, z, v8::Boolean::New(result.z))
+STUB_RETURN_PRIMITIVE(jbyte, Byte, b, v8::Integer::New(result.b))
+STUB_RETURN_PRIMITIVE(jchar, Char, c, v8::String::New(&result.c, 1))
+STUB_RETURN_PRIMITIVE(jshort, Short, s, v8::Integer::New(result.s))
+STUB_RETURN_PRIMITIVE(jint, Int, i, v8::Integer::New(result.i))
+STUB_RETURN_PRIMITIVE(jlong, Long, j, v8::Number::New((double)result.j))
+STUB_RETURN_PRIMITIVE(jfloat, Float, f, v8::Number::New(result.f))
+STUB_RETURN_PRIMITIVE(jdouble, Double, d, v8::Number::New(result.d))
+
+template<> struct StubReturn<void> {
+  static jvalue callStatic(JNIEnv* env, jclass clazz, jmethodID methodId, jvalue* values) {
+    jvalue result;
+    result.l = NULL;
+    env->CallStaticVoidMethodA(clazz, methodId, values);
+    return result;
+  }
+  static jvalue call(JNIEnv* env, jobject obj, jmethodID methodId, jvalue* values) {
+    jvalue result;
+    result.l = NULL;
+    env->CallVoidMethodA(obj, methodId, values);
+    return result;
+  }
+  static v8::Handle<v8::Value> toV8(Java* java, JNIEnv* env, jvalue result) {
+    return v8::Undefined();
+  }
+};
+
+template<> struct StubReturn<jobject> {
+  static jvalue callStatic(JNIEnv* env, jclass clazz, jmethodID methodId, jvalue* values) {
+    jvalue result;
+    result.l = env->CallStaticObjectMethodA(clazz, methodId, values);
+    return result;
+  }
+  static jvalue call(JNIEnv* env, jobject obj, jmethodID methodId, jvalue* values) {
+    jvalue result;
+    result.l = env->CallObjectMethodA(obj, methodId, values);
+    return result;
+  }
+  static v8::Handle<v8::Value> toV8(Java* java, JNIEnv* env, jvalue result) {
+    return javaToV8(java, env, result.l, java->getConversionOptions());
+  }
+};
+
+template<> struct StubReturn<StubString> {
+  static jvalue callStatic(JNIEnv* env, jclass clazz, jmethodID methodId, jvalue* values) {
+    return StubReturn<jobject>::callStatic(env, clazz, methodId, values);
+  }
+  static jvalue call(JNIEnv* env, jobject obj, jmethodID methodId, jvalue* values) {
+    return StubReturn<jobject>::call(env, obj, methodId, values);
+  }
+  static v8::Handle<v8::Value> toV8(Java* java, JNIEnv* env, jvalue result) {
+    if(result.l == NULL) {
+      return v8::Null();
+    }
+    jstring str = (jstring)result.l;
+    const jchar* chars = env->GetStringChars(str, NULL);
+    v8::Local<v8::String> v8Str = v8::String::New(chars, env->GetStringLength(str));
+    env->ReleaseStringChars(str, chars);
+    return v8Str;
+  }
+};
+
+v8::Handle<v8::Value> callStubArgError(JNIEnv* env, CallStubInfo* info, int index, V8ConversionPath* path);
+v8::Handle<v8::Value> callStubException(JNIEnv* env, CallStubInfo* info);
+
+template<typename R, typename Args>
+struct StaticStub {
+  static v8::Handle<v8::Value> call(const v8::Arguments& args) {
+    v8::HandleScope scope;
+    CallStubInfo* info = callStubPrepare(args, Args::count);
+    if(info == NULL) {
+      return v8::Undefined();
+    }
+    JNIEnv* env = info->java->getJavaEnv();
+
+    PUSH_LOCAL_JAVA_FRAME_SIZED(LOCAL_FRAME_SIZE_SMALL + Args::count);
+    jvalue values[Args::count + 1];
+    V8ConversionPath conversionPath;
+    int badArg = Args::toJava(env, args, 0, 0, info, &conversionPath, values);
+    if(badArg >= 0) {
+      POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(callStubArgError(env, info, badArg, &conversionPath)));
+    }
+    jvalue result = StubReturn<R>::callStatic(env, info->clazz, info->methodId, values);
+    if(env->ExceptionCheck()) {
+      POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(callStubException(env, info)));
+    }
+    v8::Handle<v8::Value> resultV8 = StubReturn<R>::toV8(info->java, env, result);
+    POP_LOCAL_JAVA_FRAME();
+    return scope.Close(resultV8);
+  }
+};
+
+// instance stubs take the object as their first argument
+template<typename R, typename Args>
+struct InstanceStub {
+  static v8::Handle<v8::Value> call(const v8::Arguments& args) {
+    v8::HandleScope scope;
+    CallStubInfo* info = callStubPrepare(args, Args::count + 1);
+    if(info == NULL) {
+      return v8::Undefined();
+    }
+    JNIEnv* env = info->java->getJavaEnv();
+
+    jobject obj = NULL;
+    if(JavaObject::HasInstance(args[0])) {
+      obj = node::ObjectWrap::Unwrap<JavaObject>(v8::Local<v8::Object>::Cast(args[0]))->getObject();
+    }
+    if(obj == NULL || !env->IsInstanceOf(obj, info->clazz)) {
+      std::ostringstream errStr;
+      errStr << "Argument 1 must be an instance of " << info->className;
+      return ThrowException(v8::Exception::TypeError(v8::String::New(errStr.str().c_str())));
+    }
+
+    PUSH_LOCAL_JAVA_FRAME_SIZED(LOCAL_FRAME_SIZE_SMALL + Args::count);
+    jvalue values[Args::count + 1];
+    V8ConversionPath conversionPath;
+    int badArg = Args::toJava(env, args, 1, 0, info, &conversionPath, values);
+    if(badArg >= 0) {
+      POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(callStubArgError(env, info, badArg, &conversionPath)));
+    }
+    jvalue result = StubReturn<R>::call(env, obj, info->methodId, values);
+    if(env->ExceptionCheck()) {
+      POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(callStubException(env, info)));
+    }
+    v8::Handle<v8::Value> resultV8 = StubReturn<R>::toV8(info->java, env, result);
+    POP_LOCAL_JAVA_FRAME();
+    return scope.Close(resultV8);
+  }
+};
+
+#endif
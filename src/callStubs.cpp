@@ -0,0 +1,21 @@
+// Generated by tools/generate-stubs.js from tools/stubs.json, do not edit.
+
+#include "callStub.h"
+
+CallStubInfo callStubTable[] = {
+  { "java.lang.Math", "max", "(II)I", "max", true, &StaticStub<jint, StubArgs<jint, StubArgs<jint, StubArgsEnd > > >::call, NULL, NULL, NULL, NULL },
+  { "java.lang.Math", "max", "(DD)D", "maxDouble", true, &StaticStub<jdouble, StubArgs<jdouble, StubArgs<jdouble, StubArgsEnd > > >::call, NULL, NULL, NULL, NULL },
+  { "java.lang.Math", "sqrt", "(D)D", "sqrt", true, &StaticStub<jdouble, StubArgs<jdouble, StubArgsEnd > >::call, NULL, NULL, NULL, NULL },
+  { "java.lang.Integer", "parseInt", "(Ljava/lang/String;)I", "parseInt", true, &StaticStub<jint, StubArgs<StubString, StubArgsEnd > >::call, NULL, NULL, NULL, NULL },
+  { "java.lang.Integer", "toString", "(II)Ljava/lang/String;", "toStringRadix", true, &StaticStub<StubString, StubArgs<jint, StubArgs<jint, StubArgsEnd > > >::call, NULL, NULL, NULL, NULL },
+  { "java.lang.StringBuilder", "append", "(Ljava/lang/String;)Ljava/lang/StringBuilder;", "append", false, &InstanceStub<jobject, StubArgs<StubString, StubArgsEnd > >::call, NULL, NULL, NULL, NULL },
+  { "java.lang.StringBuilder", "length", "()I", "length", false, &InstanceStub<jint, StubArgsEnd >::call, NULL, NULL, NULL, NULL },
+  { "java.lang.StringBuilder", "charAt", "(I)C", "charAt", false, &InstanceStub<jchar, StubArgs<jint, StubArgsEnd > >::call, NULL, NULL, NULL, NULL },
+  { "java.lang.StringBuilder", "setLength", "(I)V", "setLength", false, &InstanceStub<void, StubArgs<jint, StubArgsEnd > >::call, NULL, NULL, NULL, NULL },
+  { "java.util.ArrayList", "add", "(Ljava/lang/Object;)Z", "add", false, &InstanceStub<jboolean, StubArgs<jobject, StubArgsEnd > >::call, NULL, NULL, NULL, NULL },
+  { "java.util.ArrayList", "addAll", "(Ljava/util/Collection;)Z", "addAll", false, &InstanceStub<jboolean, StubArgs<jobject, StubArgsEnd > >::call, NULL, NULL, NULL, NULL },
+  { "java.util.ArrayList", "get", "(I)Ljava/lang/Object;", "get", false, &InstanceStub<jobject, StubArgs<jint, StubArgsEnd > >::call, NULL, NULL, NULL, NULL },
+  { "java.util.ArrayList", "size", "()I", "size", false, &InstanceStub<jint, StubArgsEnd >::call, NULL, NULL, NULL, NULL }
+};
+
+size_t callStubCount = sizeof(callStubTable) / sizeof(callStubTable[0]);
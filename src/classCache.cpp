@@ -0,0 +1,70 @@
+#include "classCache.h"
+#include "utils.h"
+
+ClassCache::ClassCache() {
+  m_hits = 0;
+  m_misses = 0;
+  m_evictions = 0;
+}
+
+ClassCache::~ClassCache() {
+  // the JVM is never destroyed while the bridge is loaded, the refs go with the process
+}
+
+jclass ClassCache::find(JNIEnv* env, const std::string& className) {
+  std::map<std::string, jclass>::iterator it = m_classes.find(className);
+  if(it != m_classes.end()) {
+    m_hits++;
+    return it->second;
+  }
+
+  m_misses++;
+  std::string searchClassName = className;
+  jclass clazz = javaFindClass(env, searchClassName);
+  if(clazz == NULL) {
+    return NULL;
+  }
+  jclass ref = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_CLASS_CACHE);
+  env->DeleteLocalRef(clazz);
+  m_classes[className] = ref;
+  return ref;
+}
+
+/*
+ * Adds a class loaded elsewhere, by java.preload on the thread pool, without counting a lookup.
+ */
+void ClassCache::put(JNIEnv* env, const std::string& className, jclass clazz) {
+  if(clazz == NULL || m_classes.find(className) != m_classes.end()) {
+    return;
+  }
+  m_classes[className] = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_CLASS_CACHE);
+}
+
+bool ClassCache::evict(JNIEnv* env, const std::string& className) {
+  std::map<std::string, jclass>::iterator it = m_classes.find(className);
+  if(it == m_classes.end()) {
+    return false;
+  }
+  refStatsDeleteGlobalRef(env, it->second, REF_SITE_CLASS_CACHE);
+  m_classes.erase(it);
+  m_evictions++;
+  return true;
+}
+
+void ClassCache::clear(JNIEnv* env) {
+  for(std::map<std::string, jclass>::iterator it = m_classes.begin(); it != m_classes.end(); it++) {
+    refStatsDeleteGlobalRef(env, it->second, REF_SITE_CLASS_CACHE);
+    m_evictions++;
+  }
+  m_classes.clear();
+}
+
+v8::Handle<v8::Object> ClassCache::toV8() {
+  v8::HandleScope scope;
+  v8::Local<v8::Object> result = v8::Object::New();
+  result->Set(v8::String::New("size"), v8::Number::New((double)m_classes.size()));
+  result->Set(v8::String::New("hits"), v8::Number::New((double)m_hits));
+  result->Set(v8::String::New("misses"), v8::Number::New((double)m_misses));
+  result->Set(v8::String::New("evictions"), v8::Number::New((double)m_evictions));
+  return scope.Close(result);
+}
@@ -0,0 +1,36 @@
+
+#ifndef _classcache_h_
+#define _classcache_h_
+
+#include <v8.h>
+#include <jni.h>
+#include <uv.h>
+#include <map>
+#include <string>
+
+/*
+ * Classes looked up by name from javascript, held as global refs so repeated static calls and
+ * constructors skip the class loader. Lookups only happen on the v8 thread. The jclass returned by
+ * find is borrowed from the cache: callers must not delete it, and must take their own global ref if
+ * it has to outlive the current call, since the entry can be evicted at any time from javascript.
+ * Classes that fail to load are not cached, so a later classpath change can still find them.
+ */
+class ClassCache {
+public:
+  ClassCache();
+  ~ClassCache();
+
+  jclass find(JNIEnv* env, const std::string& className);
+  void put(JNIEnv* env, const std::string& className, jclass clazz);
+  bool evict(JNIEnv* env, const std::string& className);
+  void clear(JNIEnv* env);
+  v8::Handle<v8::Object> toV8();
+
+private:
+  std::map<std::string, jclass> m_classes;
+  uint64_t m_hits;
+  uint64_t m_misses;
+  uint64_t m_evictions;
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "eventRing.h"
+#include "java.h"
+#include "javaObject.h"
+#include "methodCallBaton.h"
+#include "node_NodeEventRing.h"
+#include <string.h>
+#include <sstream>
+#include <algorithm>
+
+extern std::string nativeBindingLocation;
+
+/*static*/ v8::Persistent<v8::FunctionTemplate> EventRing::s_ct;
+
+/*static*/ void EventRing::Init(v8::Handle<v8::Object> target) {
+  v8::HandleScope scope;
+
+  v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New();
+  s_ct = v8::Persistent<v8::FunctionTemplate>::New(t);
+  s_ct->InstanceTemplate()->SetInternalFieldCount(1);
+  s_ct->SetClassName(v8::String::NewSymbol("EventRing"));
+
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "close", close);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "getStats", getStats);
+}
+
+/*static*/ v8::Handle<v8::Value> EventRing::New(Java* java, v8::Handle<v8::Object> options, v8::Handle<v8::Value> callback) {
+  v8::HandleScope scope;
+  JNIEnv* env = java->getJavaEnv();
+
+  v8::Local<v8::Value> recordSize = options->Get(v8::String::New("recordSize"));
+  if(!recordSize->IsNumber() || recordSize->Int32Value() < 1) {
+    return ThrowException(v8::Exception::TypeError(v8::String::New("recordSize must be a number greater than 0")));
+  }
+  v8::Local<v8::Value> capacity = options->Get(v8::String::New("capacity"));
+  int capacityValue = EVENT_RING_DEFAULT_CAPACITY;
+  if(!capacity->IsUndefined()) {
+    if(!capacity->IsNumber() || capacity->Int32Value() < 1) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("capacity must be a number greater than 0")));
+    }
+    capacityValue = capacity->Int32Value();
+  }
+
+  v8::Local<v8::Function> ctor = s_ct->GetFunction();
+  v8::Local<v8::Object> eventRingObj = ctor->NewInstance();
+  EventRing* self = new EventRing(java, recordSize->Int32Value(), capacityValue, callback);
+  self->Wrap(eventRingObj);
+
+  // find NodeEventRing
+  std::string className = "node.NodeEventRing";
+  jclass clazz = javaFindClass(env, className);
+  if(clazz == NULL) {
+    std::ostringstream errStr;
+    errStr << "Could not create class node/NodeEventRing";
+    return ThrowException(javaExceptionToV8(env, errStr.str()));
+  }
+
+  // find constructor
+  jobjectArray methodArgs = env->NewObjectArray(3, javaConversionIds.objectClazz, NULL);
+  env->SetObjectArrayElement(methodArgs, 0, v8ToJava(env, v8::String::New(nativeBindingLocation.c_str())));
+  env->SetObjectArrayElement(methodArgs, 1, longToJavaLongObj(env, (long)self));
+  env->SetObjectArrayElement(methodArgs, 2, v8ToJava(env, v8::Integer::New(self->m_recordSize)));
+  jobject method = javaFindConstructor(env, clazz, methodArgs);
+  if(method == NULL) {
+    std::ostringstream errStr;
+    errStr << "Could not find constructor for class node/NodeEventRing";
+    return ThrowException(javaExceptionToV8(env, errStr.str()));
+  }
+
+  // run constructor
+  v8::Handle<v8::Value> batonCallback = v8::Object::New();
+  NewInstanceBaton* baton = new NewInstanceBaton(java, method, methodArgs, batonCallback);
+  v8::Handle<v8::Value> javaRing = baton->runSync();
+  delete baton;
+  if(javaRing->IsNativeError()) {
+    return ThrowException(javaRing);
+  }
+  JavaObject* javaRingObject = node::ObjectWrap::Unwrap<JavaObject>(javaRing->ToObject());
+  self->m_javaRing = refStatsNewGlobalRef(env, javaRingObject->getObject(), REF_SITE_OTHER);
+  eventRingObj->Set(v8::String::NewSymbol("javaObject"), javaRing);
+
+  // java holds a pointer to the ring until it is closed
+  self->Ref();
+  self->m_async = new uv_async_t();
+  self->m_async->data = self;
+  uv_async_init(uv_default_loop(), self->m_async, onAsync);
+
+  return scope.Close(eventRingObj);
+}
+
+EventRing::EventRing(Java* java, size_t recordSize, size_t capacity, v8::Handle<v8::Value> callback) {
+  m_java = java;
+  m_javaRing = NULL;
+  m_callback = v8::Persistent<v8::Value>::New(callback);
+  m_async = NULL;
+  uv_mutex_init(&m_mutex);
+  m_closed = false;
+  m_recordSize = recordSize;
+  m_capacity = capacity;
+  m_data.resize(recordSize * capacity);
+  m_readIndex = 0;
+  m_size = 0;
+  m_appended = 0;
+  m_delivered = 0;
+  m_dropped = 0;
+  m_batches = 0;
+}
+
+EventRing::~EventRing() {
+  if(m_javaRing) {
+    m_java->releaseGlobalRef(m_javaRing, REF_SITE_OTHER);
+  }
+  m_callback.Dispose();
+  uv_mutex_destroy(&m_mutex);
+}
+
+/*
+ * Called on java threads. Copies as many records as fit straight from the java array into the ring;
+ * the rest are counted as dropped. Wakeups are coalesced by libuv so a burst of appends results in
+ * a single drain.
+ */
+bool EventRing::append(JNIEnv* env, jbyteArray records, jint offset, jint count) {
+  uv_mutex_lock(&m_mutex);
+  size_t appendCount = std::min((size_t)count, m_capacity - m_size);
+  size_t writeIndex = (m_readIndex + m_size) % m_capacity;
+  size_t firstCount = std::min(appendCount, m_capacity - writeIndex);
+  env->GetByteArrayRegion(records, offset, firstCount * m_recordSize, (jbyte*)&m_data[writeIndex * m_recordSize]);
+  if(appendCount > firstCount) {
+    env->GetByteArrayRegion(records, offset + firstCount * m_recordSize, (appendCount - firstCount) * m_recordSize, (jbyte*)&m_data[0]);
+  }
+  m_size += appendCount;
+  m_appended += appendCount;
+  m_dropped += count - appendCount;
+  uv_mutex_unlock(&m_mutex);
+
+  if(appendCount > 0) {
+    uv_async_send(m_async);
+  }
+  return appendCount == (size_t)count;
+}
+
+void EventRing::drain() {
+  uv_mutex_lock(&m_mutex);
+  size_t count = m_size;
+  if(count > 0) {
+    m_drainBuffer.resize(count * m_recordSize);
+    size_t firstCount = std::min(count, m_capacity - m_readIndex);
+    memcpy(&m_drainBuffer[0], &m_data[m_readIndex * m_recordSize], firstCount * m_recordSize);
+    if(count > firstCount) {
+      memcpy(&m_drainBuffer[firstCount * m_recordSize], &m_data[0], (count - firstCount) * m_recordSize);
+    }
+    m_readIndex = (m_readIndex + count) % m_capacity;
+    m_size = 0;
+  }
+  uv_mutex_unlock(&m_mutex);
+
+  if(count == 0 || !m_callback->IsFunction()) {
+    return;
+  }
+  m_delivered += count;
+  m_batches++;
+
+  v8::HandleScope scope;
+  v8::Handle<v8::Value> argv[2];
+  argv[0] = bytesToV8Buffer(&m_drainBuffer[0], count * m_recordSize);
+  argv[1] = v8::Integer::New(count);
+  v8::Function::Cast(*m_callback)->Call(v8::Context::GetCurrent()->Global(), 2, argv);
+}
+
+/*static*/ void EventRing::onAsync(uv_async_t* handle, int status) {
+  EventRing* self = static_cast<EventRing*>(handle->data);
+  if(self == NULL) {
+    return;
+  }
+  self->drain();
+}
+
+void onEventRingAsyncClose(uv_handle_t* handle) {
+  delete (uv_async_t*)handle;
+}
+
+/*
+ * NodeEventRing.close is synchronized with its appends, so once it returns no java thread can be
+ * using the pointer to this ring.
+ */
+void EventRing::closeRing() {
+  if(m_closed) {
+    return;
+  }
+  m_closed = true;
+
+  JNIEnv* env = m_java->getJavaEnv();
+  jclass javaRingClazz = env->GetObjectClass(m_javaRing);
+  jmethodID nodeEventRing_close = env->GetMethodID(javaRingClazz, "close", "()V");
+  env->CallVoidMethod(m_javaRing, nodeEventRing_close);
+  env->DeleteLocalRef(javaRingClazz);
+
+  drain();
+
+  m_async->data = NULL;
+  uv_close((uv_handle_t*)m_async, onEventRingAsyncClose);
+  m_async = NULL;
+  Unref();
+}
+
+/*static*/ v8::Handle<v8::Value> EventRing::close(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  EventRing* self = node::ObjectWrap::Unwrap<EventRing>(args.This());
+  self->closeRing();
+  return v8::Undefined();
+}
+
+/*static*/ v8::Handle<v8::Value> EventRing::getStats(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  EventRing* self = node::ObjectWrap::Unwrap<EventRing>(args.This());
+
+  uv_mutex_lock(&self->m_mutex);
+  size_t pending = self->m_size;
+  uint64_t appended = self->m_appended;
+  uint64_t dropped = self->m_dropped;
+  uv_mutex_unlock(&self->m_mutex);
+
+  v8::Local<v8::Object> stats = v8::Object::New();
+  stats->Set(v8::String::New("recordSize"), v8::Number::New(self->m_recordSize));
+  stats->Set(v8::String::New("capacity"), v8::Number::New(self->m_capacity));
+  stats->Set(v8::String::New("pending"), v8::Number::New(pending));
+  stats->Set(v8::String::New("appended"), v8::Number::New(appended));
+  stats->Set(v8::String::New("delivered"), v8::Number::New(self->m_delivered));
+  stats->Set(v8::String::New("dropped"), v8::Number::New(dropped));
+  stats->Set(v8::String::New("batches"), v8::Number::New(self->m_batches));
+  return scope.Close(stats);
+}
+
+JNIEXPORT jboolean JNICALL Java_node_NodeEventRing_appendRecords(JNIEnv *env, jobject src, jlong ptr, jbyteArray records, jint offset, jint count) {
+  EventRing* eventRing = (EventRing*)ptr;
+  return eventRing->append(env, records, offset, count) ? JNI_TRUE : JNI_FALSE;
+}
@@ -0,0 +1,53 @@
+#ifndef _eventring_h_
+#define _eventring_h_
+
+#include <v8.h>
+#include <node.h>
+#include <jni.h>
+#include <vector>
+
+class Java;
+
+#define EVENT_RING_DEFAULT_CAPACITY 65536
+
+/*
+ * A fixed size ring of fixed size records. Java threads append records through node.NodeEventRing,
+ * which serializes producers, and the v8 thread drains everything appended since the last wakeup
+ * into one Buffer.
+ */
+class EventRing : public node::ObjectWrap {
+public:
+  static void Init(v8::Handle<v8::Object> target);
+  static v8::Handle<v8::Value> New(Java* java, v8::Handle<v8::Object> options, v8::Handle<v8::Value> callback);
+
+  bool append(JNIEnv* env, jbyteArray records, jint offset, jint count);
+
+private:
+  EventRing(Java* java, size_t recordSize, size_t capacity, v8::Handle<v8::Value> callback);
+  ~EventRing();
+  void drain();
+  void closeRing();
+  static void onAsync(uv_async_t* handle, int status);
+  static v8::Handle<v8::Value> close(const v8::Arguments& args);
+  static v8::Handle<v8::Value> getStats(const v8::Arguments& args);
+
+  static v8::Persistent<v8::FunctionTemplate> s_ct;
+  Java* m_java;
+  jobject m_javaRing;
+  v8::Persistent<v8::Value> m_callback;
+  uv_async_t* m_async;
+  uv_mutex_t m_mutex;
+  bool m_closed;
+  size_t m_recordSize;
+  size_t m_capacity;
+  std::vector<char> m_data;
+  std::vector<char> m_drainBuffer;
+  size_t m_readIndex;
+  size_t m_size;
+  uint64_t m_appended;
+  uint64_t m_delivered;
+  uint64_t m_dropped;
+  uint64_t m_batches;
+};
+
+#endif
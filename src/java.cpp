@@ -4,8 +4,13 @@
 #include <unistd.h>
 #include "javaObject.h"
 #include "methodCallBaton.h"
+#include "eventRing.h"
+#include "boundMethod.h"
+#include "typedValue.h"
+#include "callStub.h"
 #include "node_NodeDynamicProxyClass.h"
 #include <sstream>
+#include <node_buffer.h>
 
 std::string nativeBindingLocation;
 long v8ThreadId;
@@ -46,8 +51,39 @@ long my_getThreadId() {
   NODE_SET_PROTOTYPE_METHOD(s_ct, "findClassSync", findClassSync);
   NODE_SET_PROTOTYPE_METHOD(s_ct, "newArray", newArray);
   NODE_SET_PROTOTYPE_METHOD(s_ct, "newByte", newByte);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "long", newTypedLong);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "float", newTypedFloat);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "short", newTypedShort);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "char", newTypedChar);
   NODE_SET_PROTOTYPE_METHOD(s_ct, "getStaticFieldValue", getStaticFieldValue);
   NODE_SET_PROTOTYPE_METHOD(s_ct, "setStaticFieldValue", setStaticFieldValue);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "callOptions", callOptions);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "setAsyncOptions", setAsyncOptions);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "getAsyncStats", getAsyncStats);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "setConversionOptions", setConversionOptions);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "streamRead", streamRead);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "streamWrite", streamWrite);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "createEventRing", createEventRing);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "stats", stats);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "setStatsEnabled", setStatsEnabled);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "resetStats", resetStats);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "startTracing", startTracing);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "stopTracing", stopTracing);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "setSyncWatchdog", setSyncWatchdog);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "getBlockedSyncCalls", getBlockedSyncCalls);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "refStats", refStats);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "resetRefStats", resetRefStats);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "getMethod", getMethod);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "getInstanceMethod", getInstanceMethod);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "runPipeline", runPipeline);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "mapChunk", mapChunk);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "preloadClass", preloadClass);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "evictClass", evictClass);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "clearClassCache", clearClassCache);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "getClassCacheStats", getClassCacheStats);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "memoize", memoize);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "unmemoize", unmemoize);
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "getMemoStats", getMemoStats);
 
   target->Set(v8::String::NewSymbol("Java"), s_ct->GetFunction());
 }
@@ -61,6 +97,7 @@ long my_getThreadId() {
   self->handle_->Set(v8::String::New("classpath"), v8::Array::New());
   self->handle_->Set(v8::String::New("options"), v8::Array::New());
   self->handle_->Set(v8::String::New("nativeBindingLocation"), v8::String::New("Not Set"));
+  self->handle_->Set(v8::String::New("stubs"), callStubsToV8(self));
 
   return args.This();
 }
@@ -68,20 +105,184 @@ long my_getThreadId() {
 Java::Java() {
   this->m_jvm = NULL;
   this->m_env = NULL;
+  this->m_nodeDynamicProxyClass = NULL;
+  this->m_releaseIdleActive = false;
+  this->m_releaseIdle = new uv_idle_t();
+  uv_idle_init(uv_default_loop(), this->m_releaseIdle);
+  this->m_releaseIdle->data = this;
+  this->m_callbackIdleActive = false;
+  this->m_callbackIdle = new uv_idle_t();
+  uv_idle_init(uv_default_loop(), this->m_callbackIdle);
+  this->m_callbackIdle->data = this;
+  conversionOptionsInit(&this->m_conversionOptions);
+}
+
+static void onIdleClose(uv_handle_t* handle) {
+  delete (uv_idle_t*)handle;
 }
 
 Java::~Java() {
+  // the handles outlive this object until libuv has closed them
+  uv_idle_stop(m_releaseIdle);
+  m_releaseIdle->data = NULL;
+  uv_close((uv_handle_t*)m_releaseIdle, onIdleClose);
+  m_releaseIdle = NULL;
+  m_releaseIdleActive = false;
+  uv_idle_stop(m_callbackIdle);
+  m_callbackIdle->data = NULL;
+  uv_close((uv_handle_t*)m_callbackIdle, onIdleClose);
+  m_callbackIdle = NULL;
+  m_callbackIdleActive = false;
+
+  // callbacks not yet called are dropped with the instance
+  for(std::vector<DeferredCallback>::iterator it = m_deferredCallbacks.begin(); it != m_deferredCallbacks.end(); it++) {
+    it->callback.Dispose();
+    it->error.Dispose();
+    it->result.Dispose();
+  }
+  m_deferredCallbacks.clear();
 
+  // refs still waiting for a batch are deleted here, there will be no idle callback to queue them
+  if(m_env && !m_pendingGlobalRefReleases.empty()) {
+    for(std::vector<jobject>::iterator it = m_pendingGlobalRefReleases.begin(); it != m_pendingGlobalRefReleases.end(); it++) {
+      m_env->DeleteGlobalRef(*it);
+    }
+    refStatsReleased(m_pendingGlobalRefReleases.size());
+  }
+  m_pendingGlobalRefReleases.clear();
 }
 
 v8::Handle<v8::Value> Java::ensureJvm() {
   if(!m_jvm) {
-    return createJVM(&this->m_jvm, &this->m_env);
+    uint64_t traceStartNs = traceEnabled() ? uv_hrtime() : 0;
+    v8::Handle<v8::Value> result = createJVM(&this->m_jvm, &this->m_env);
+    if(m_jvm) {
+      javaInitConversionIds(m_env);
+      callStubsResolve(m_env);
+    }
+    traceComplete("jvm", "createJVM", NULL, traceStartNs, uv_hrtime());
+    return result;
   }
 
   return v8::Undefined();
 }
 
+jclass Java::getNodeDynamicProxyClass() {
+  if(m_nodeDynamicProxyClass == NULL) {
+    jclass clazz = m_env->FindClass("node/NodeDynamicProxyClass");
+    if(clazz == NULL) {
+      m_env->ExceptionClear();
+      return NULL;
+    }
+    m_nodeDynamicProxyClass = (jclass)refStatsNewGlobalRef(m_env, clazz, REF_SITE_OTHER);
+    m_env->DeleteLocalRef(clazz);
+  }
+  return m_nodeDynamicProxyClass;
+}
+
+/*
+ * Global refs released by wrapper finalizers are not deleted in the GC callback. They are queued
+ * here and deleted in one batch on a thread pool thread once the event loop goes idle.
+ */
+void Java::releaseGlobalRef(jobject ref, refSite site) {
+  if(ref == NULL) {
+    return;
+  }
+  refStatsQueueRelease(site);
+  m_pendingGlobalRefReleases.push_back(ref);
+  if(!m_releaseIdleActive) {
+    m_releaseIdleActive = true;
+    uv_idle_start(m_releaseIdle, releaseGlobalRefsIdle);
+  }
+}
+
+struct GlobalRefReleaseBatch {
+  JavaVM* jvm;
+  std::vector<jobject> refs;
+};
+
+void EIO_ReleaseGlobalRefs(uv_work_t* req) {
+  GlobalRefReleaseBatch* batch = static_cast<GlobalRefReleaseBatch*>(req->data);
+  uint64_t traceStartNs = traceEnabled() ? uv_hrtime() : 0;
+  JNIEnv* env = javaAttachCurrentThread(batch->jvm);
+  for(std::vector<jobject>::iterator it = batch->refs.begin(); it != batch->refs.end(); it++) {
+    env->DeleteGlobalRef(*it);
+  }
+  refStatsReleased(batch->refs.size());
+  traceComplete("gc", "releaseGlobalRefs", NULL, traceStartNs, uv_hrtime());
+  javaDetachCurrentThread(batch->jvm);
+}
+
+void EIO_AfterReleaseGlobalRefs(uv_work_t* req) {
+  GlobalRefReleaseBatch* batch = static_cast<GlobalRefReleaseBatch*>(req->data);
+  delete batch;
+  delete req;
+}
+
+/*static*/ void Java::releaseGlobalRefsIdle(uv_idle_t* handle, int status) {
+  Java* self = static_cast<Java*>(handle->data);
+  if(self == NULL) {
+    return;
+  }
+  uv_idle_stop(self->m_releaseIdle);
+  self->m_releaseIdleActive = false;
+  if(self->m_pendingGlobalRefReleases.empty()) {
+    return;
+  }
+
+  GlobalRefReleaseBatch* batch = new GlobalRefReleaseBatch();
+  batch->jvm = self->m_jvm;
+  batch->refs.swap(self->m_pendingGlobalRefReleases);
+
+  uv_work_t* req = new uv_work_t();
+  req->data = batch;
+  uv_queue_work(uv_default_loop(), req, EIO_ReleaseGlobalRefs, EIO_AfterReleaseGlobalRefs);
+}
+
+/*
+ * Calls callback(error, result) on the next turn of the event loop. Used where a result is known
+ * before an async call returns, so the callback is still never called before the call returns.
+ */
+void Java::deferCallback(v8::Handle<v8::Value> callback, v8::Handle<v8::Value> error, v8::Handle<v8::Value> result) {
+  DeferredCallback deferred;
+  deferred.callback = v8::Persistent<v8::Value>::New(callback);
+  deferred.error = v8::Persistent<v8::Value>::New(error);
+  deferred.result = v8::Persistent<v8::Value>::New(result);
+  m_deferredCallbacks.push_back(deferred);
+  if(!m_callbackIdleActive) {
+    m_callbackIdleActive = true;
+    uv_idle_start(m_callbackIdle, deferredCallbacksIdle);
+  }
+}
+
+/*static*/ void Java::deferredCallbacksIdle(uv_idle_t* handle, int status) {
+  Java* self = static_cast<Java*>(handle->data);
+  if(self == NULL) {
+    return;
+  }
+  uv_idle_stop(self->m_callbackIdle);
+  self->m_callbackIdleActive = false;
+
+  // callbacks deferred by these callbacks wait for the next turn
+  std::vector<DeferredCallback> callbacks;
+  callbacks.swap(self->m_deferredCallbacks);
+
+  v8::HandleScope scope;
+  for(std::vector<DeferredCallback>::iterator it = callbacks.begin(); it != callbacks.end(); it++) {
+    v8::Handle<v8::Value> argv[2];
+    argv[0] = it->error;
+    argv[1] = it->result;
+    v8::TryCatch tryCatch;
+    v8::Function::Cast(*it->callback)->Call(v8::Context::GetCurrent()->Global(), 2, argv);
+    it->callback.Dispose();
+    it->error.Dispose();
+    it->result.Dispose();
+    if(tryCatch.HasCaught()) {
+      node::FatalException(tryCatch);
+    }
+  }
+}
+
 v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   JavaVM* jvmTemp;
   JavaVMInitArgs args;
@@ -164,25 +365,33 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   // arguments
   ARGS_FRONT_CLASSNAME();
   ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
 
   // find class
-  jclass clazz = javaFindClass(env, className);
+  jclass clazz = self->m_classCache.find(env, className);
   if(clazz == NULL) {
     EXCEPTION_CALL_CALLBACK("Could not find class " << className.c_str());
     return v8::Undefined();
   }
 
-  // get method
-  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd);
-  jobject method = javaFindConstructor(env, clazz, methodArgs);
-  if(method == NULL) {
-    EXCEPTION_CALL_CALLBACK("Could not find constructor for class " << className);
-    return v8::Undefined();
+  // the constructor is found on the thread pool once the arguments are built there
+  MethodStats* stats = self->m_stats.get(className, "<init>");
+  uint64_t phaseStart = statsNow(stats);
+  V8ConversionPath conversionPath;
+  NativeValue* methodArgs = v8ToNative(env, args, argsStart, argsEnd, &conversionPath);
+  if(methodArgs == NULL) {
+    return ThrowException(conversionPath.getError());
   }
+  statsRecordPhase(stats, STATS_PHASE_ARGS, phaseStart);
 
   // run
-  NewInstanceBaton* baton = new NewInstanceBaton(self, clazz, method, methodArgs, callback);
-  baton->run();
+  NewInstanceBaton* baton = new NewInstanceBaton(self, NULL, NULL, callback);
+  baton->deferArgs(methodArgs, clazz, className, "<init>");
+  baton->setStats(stats);
+  baton->setCallOptions(callOptions);
+  if(!baton->run()) {
+    return v8::False();
+  }
 
   END_CALLBACK_FUNCTION("\"Constructor for class '" << className << "' called without a callback did you mean to use the Sync version?\"");
 }
@@ -201,9 +410,11 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
 
   // arguments
   ARGS_FRONT_CLASSNAME();
+  ARGS_BACK_CALL_OPTIONS();
+  SyncCallGuard syncCallGuard(&self->m_syncWatchdog, className, "<init>");
 
   // find class
-  jclass clazz = javaFindClass(env, className);
+  jclass clazz = self->m_classCache.find(env, className);
   if(clazz == NULL) {
     std::ostringstream errStr;
     errStr << "Could not create class " << className.c_str();
@@ -211,9 +422,18 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   }
 
   // find method
-  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd);
+  MethodStats* stats = self->m_stats.get(className, "<init>");
+  uint64_t phaseStart = statsNow(stats);
+  V8ConversionPath conversionPath;
+  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd, &conversionPath);
+  if(methodArgs == NULL) {
+    return ThrowException(conversionPath.getError());
+  }
+  phaseStart = statsRecordPhase(stats, STATS_PHASE_ARGS, phaseStart);
   jobject method = javaFindConstructor(env, clazz, methodArgs);
+  statsRecordPhase(stats, STATS_PHASE_RESOLVE, phaseStart);
   if(method == NULL) {
+    statsRecordCall(stats, true);
     std::ostringstream errStr;
     errStr << "Could not find constructor for class " << className.c_str();
     return ThrowException(javaExceptionToV8(env, errStr.str()));
@@ -221,7 +441,9 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
 
   // run
   v8::Handle<v8::Value> callback = v8::Object::New();
-  NewInstanceBaton* baton = new NewInstanceBaton(self, clazz, method, methodArgs, callback);
+  NewInstanceBaton* baton = new NewInstanceBaton(self, method, methodArgs, callback);
+  baton->setStats(stats);
+  baton->setCallOptions(callOptions);
   v8::Handle<v8::Value> result = baton->runSync();
   delete baton;
   if(result->IsNativeError()) {
@@ -254,7 +476,7 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
 
   // find NodeDynamicProxyClass
   std::string className = "node.NodeDynamicProxyClass";
-  jclass clazz = javaFindClass(env, className);
+  jclass clazz = self->m_classCache.find(env, className);
   if(clazz == NULL) {
     std::ostringstream errStr;
     errStr << "Could not create class node/NodeDynamicProxyClass";
@@ -275,7 +497,7 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
 
   // run constructor
   v8::Handle<v8::Value> callback = v8::Object::New();
-  NewInstanceBaton* baton = new NewInstanceBaton(self, clazz, method, methodArgs, callback);
+  NewInstanceBaton* baton = new NewInstanceBaton(self, method, methodArgs, callback);
   v8::Handle<v8::Value> result = baton->runSync();
   delete baton;
   if(result->IsNativeError()) {
@@ -300,25 +522,53 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   ARGS_FRONT_CLASSNAME();
   ARGS_FRONT_STRING(methodName);
   ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
+
+  if(callOptions && !callOptions->getSignature().empty()) {
+    return scope.Close(self->callWithSignature(args, argsStart, argsEnd, v8::Handle<v8::Value>(), className, methodName, callOptions, callback, callbackProvided));
+  }
+
+  // memoized results are handed back on the next turn of the event loop, without going to the thread pool
+  std::string memoKey;
+  if(!self->m_memoCache.empty()) {
+    MemoMethod* memoMethod = self->m_memoCache.findMethod(className, methodName);
+    if(memoMethod && MemoCache::keyFor(args, argsStart, argsEnd, &memoKey)) {
+      v8::Handle<v8::Value> memoResult = self->m_memoCache.get(memoMethod, memoKey);
+      if(!memoResult.IsEmpty()) {
+        if(callbackProvided) {
+          self->deferCallback(callback, v8::Undefined(), memoResult);
+        }
+        END_CALLBACK_FUNCTION("\"Static method '" << methodName << "' called without a callback did you mean to use the Sync version?\"");
+      }
+    }
+  }
 
   // find class
-  jclass clazz = javaFindClass(env, className);
+  jclass clazz = self->m_classCache.find(env, className);
   if(clazz == NULL) {
     EXCEPTION_CALL_CALLBACK("Could not create class " << className.c_str());
     return v8::Undefined();
   }
 
-  // find method
-  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd);
-  jobject method = javaFindMethod(env, clazz, methodName, methodArgs);
-  if(method == NULL) {
-    EXCEPTION_CALL_CALLBACK("Could not find method \"" << methodName.c_str() << "\"");
-    return v8::Undefined();
+  // the method is found on the thread pool once the arguments are built there
+  MethodStats* stats = self->m_stats.get(className, methodName);
+  uint64_t phaseStart = statsNow(stats);
+  V8ConversionPath conversionPath;
+  NativeValue* methodArgs = v8ToNative(env, args, argsStart, argsEnd, &conversionPath);
+  if(methodArgs == NULL) {
+    return ThrowException(conversionPath.getError());
   }
+  statsRecordPhase(stats, STATS_PHASE_ARGS, phaseStart);
 
   // run
-  StaticMethodCallBaton* baton = new StaticMethodCallBaton(self, clazz, method, methodArgs, callback);
-  baton->run();
+  StaticMethodCallBaton* baton = new StaticMethodCallBaton(self, NULL, NULL, callback);
+  baton->deferArgs(methodArgs, clazz, className, methodName);
+  baton->setMemoKey(className, methodName, memoKey);
+  baton->setStats(stats);
+  baton->setCallOptions(callOptions);
+  if(!baton->run()) {
+    return v8::False();
+  }
 
   END_CALLBACK_FUNCTION("\"Static method '" << methodName << "' called without a callback did you mean to use the Sync version?\"");
 }
@@ -338,9 +588,26 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   // arguments
   ARGS_FRONT_CLASSNAME();
   ARGS_FRONT_STRING(methodName);
+  ARGS_BACK_CALL_OPTIONS();
+
+  if(callOptions && !callOptions->getSignature().empty()) {
+    return scope.Close(self->callWithSignature(args, argsStart, argsEnd, v8::Handle<v8::Value>(), className, methodName, callOptions, v8::Undefined(), false));
+  }
+
+  std::string memoKey;
+  if(!self->m_memoCache.empty()) {
+    MemoMethod* memoMethod = self->m_memoCache.findMethod(className, methodName);
+    if(memoMethod && MemoCache::keyFor(args, argsStart, argsEnd, &memoKey)) {
+      v8::Handle<v8::Value> memoResult = self->m_memoCache.get(memoMethod, memoKey);
+      if(!memoResult.IsEmpty()) {
+        return scope.Close(memoResult);
+      }
+    }
+  }
+  SyncCallGuard syncCallGuard(&self->m_syncWatchdog, className, methodName);
 
   // find class
-  jclass clazz = javaFindClass(env, className);
+  jclass clazz = self->m_classCache.find(env, className);
   if(clazz == NULL) {
     std::ostringstream errStr;
     errStr << "Could not create class " << className.c_str();
@@ -348,9 +615,18 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   }
 
   // find method
-  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd);
+  MethodStats* stats = self->m_stats.get(className, methodName);
+  uint64_t phaseStart = statsNow(stats);
+  V8ConversionPath conversionPath;
+  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd, &conversionPath);
+  if(methodArgs == NULL) {
+    return ThrowException(conversionPath.getError());
+  }
+  phaseStart = statsRecordPhase(stats, STATS_PHASE_ARGS, phaseStart);
   jobject method = javaFindMethod(env, clazz, methodName, methodArgs);
+  statsRecordPhase(stats, STATS_PHASE_RESOLVE, phaseStart);
   if(method == NULL) {
+    statsRecordCall(stats, true);
     std::ostringstream errStr;
     errStr << "Could not find method \"" << methodName.c_str() << "\"";
     return ThrowException(javaExceptionToV8(env, errStr.str()));
@@ -358,7 +634,10 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
 
   // run
   v8::Handle<v8::Value> callback = v8::Object::New();
-  StaticMethodCallBaton* baton = new StaticMethodCallBaton(self, clazz, method, methodArgs, callback);
+  StaticMethodCallBaton* baton = new StaticMethodCallBaton(self, method, methodArgs, callback);
+  baton->setMemoKey(className, methodName, memoKey);
+  baton->setStats(stats);
+  baton->setCallOptions(callOptions);
   v8::Handle<v8::Value> result = baton->runSync();
   delete baton;
   if(result->IsNativeError()) {
@@ -367,6 +646,53 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   return scope.Close(result);
 }
 
+/*
+ * Calls made with a signature call option go through the bound method for that exact signature.
+ * target is the java object for instance methods and empty for static ones.
+ */
+v8::Handle<v8::Value> Java::callWithSignature(
+  const v8::Arguments& args,
+  int argsStart,
+  int argsEnd,
+  v8::Handle<v8::Value> target,
+  const std::string& className,
+  const std::string& methodName,
+  CallOptions* callOptions,
+  v8::Handle<v8::Value> callback,
+  bool callbackProvided) {
+  v8::HandleScope scope;
+  bool isStatic = target.IsEmpty();
+  const std::string& signature = callOptions->getSignature();
+
+  v8::Handle<v8::Value> bound = getBoundMethod(className, methodName, v8::String::New(signature.c_str()), isStatic);
+  if(bound->IsNativeError()) {
+    if(!callbackProvided) {
+      return ThrowException(bound);
+    }
+    deferCallback(callback, bound, v8::Undefined());
+    return v8::Undefined();
+  }
+  v8::Handle<v8::Function> boundFunction = v8::Handle<v8::Function>::Cast(bound);
+
+  std::vector<v8::Handle<v8::Value> > argv;
+  if(!isStatic) {
+    argv.push_back(target);
+  }
+  for(int i=argsStart; i<argsEnd; i++) {
+    argv.push_back(args[i]);
+  }
+  argv.push_back(callOptions->handle_);
+  if(callbackProvided) {
+    argv.push_back(callback);
+  }
+  v8::Local<v8::Value> result = boundFunction->Call(v8::Context::GetCurrent()->Global(), (int)argv.size(), &argv[0]);
+  if(result.IsEmpty()) {
+    // the bound method threw, leave the exception to propagate
+    return v8::Handle<v8::Value>();
+  }
+  return scope.Close(result);
+}
+
 /*static*/ v8::Handle<v8::Value> Java::findClassSync(const v8::Arguments& args) {
   v8::HandleScope scope;
   Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
@@ -383,7 +709,7 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   ARGS_FRONT_CLASSNAME();
 
   // find class
-  jclass clazz = javaFindClass(env, className);
+  jclass clazz = self->m_classCache.find(env, className);
   if(clazz == NULL) {
     std::ostringstream errStr;
     errStr << "Could not create class " << className.c_str();
@@ -410,6 +736,17 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   // arguments
   ARGS_FRONT_CLASSNAME();
 
+  // a Buffer can be copied straight into a byte[]
+  if(strcmp(className.c_str(), "byte") == 0 && args.Length() >= argsStart+1 && node::Buffer::HasInstance(args[argsStart])) {
+    v8::Local<v8::Object> bufferObj = v8::Local<v8::Object>::Cast(args[argsStart]);
+    jsize bufferLength = (jsize)node::Buffer::Length(bufferObj);
+    jbyteArray bufferResults = env->NewByteArray(bufferLength);
+    env->SetByteArrayRegion(bufferResults, 0, bufferLength, (jbyte*)node::Buffer::Data(bufferObj));
+    v8::Local<v8::Object> bufferResultsObj = JavaObject::New(self, bufferResults);
+    env->DeleteLocalRef(bufferResults);
+    return scope.Close(bufferResultsObj);
+  }
+
   // argument - array
   if(args.Length() < argsStart+1 || !args[argsStart]->IsArray()) {
     std::ostringstream errStr;
@@ -423,21 +760,31 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   // find class and method
   jarray results;
   if(strcmp(className.c_str(), "byte") == 0) {
-    results = env->NewByteArray(arrayObj->Length());
-    for(uint32_t i=0; i<arrayObj->Length(); i++) {
+    uint32_t arrayLength = arrayObj->Length();
+    std::vector<jbyte> byteValues(arrayLength);
+    for(uint32_t i=0; i<arrayLength; i++) {
       v8::Local<v8::Value> item = arrayObj->Get(i);
-      jobject val = v8ToJava(env, item);
-      jclass byteClazz = env->FindClass("java/lang/Byte");
-      jmethodID byte_byteValue = env->GetMethodID(byteClazz, "byteValue", "()B");
-      jbyte byteValues[1];
-      byteValues[0] = env->CallByteMethod(val, byte_byteValue);
-      env->SetByteArrayRegion((jbyteArray)results, i, 1, byteValues);
+      if(item->IsNumber()) {
+        byteValues[i] = (jbyte)item->Int32Value();
+      } else {
+        V8ConversionPath conversionPath;
+        jobject val = v8ToJava(env, item, &conversionPath);
+        if(conversionPath.failed()) {
+          return ThrowException(conversionPath.getError());
+        }
+        byteValues[i] = env->CallByteMethod(val, javaConversionIds.byte_byteValue);
+        env->DeleteLocalRef(val);
+      }
+    }
+    results = env->NewByteArray(arrayLength);
+    if(arrayLength > 0) {
+      env->SetByteArrayRegion((jbyteArray)results, 0, arrayLength, &byteValues[0]);
     }
   }
 
   else
   {
-    jclass clazz = javaFindClass(env, className);
+    jclass clazz = self->m_classCache.find(env, className);
     if(clazz == NULL) {
       std::ostringstream errStr;
       errStr << "Could not create class " << className.c_str();
@@ -449,8 +796,13 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
 
     for(uint32_t i=0; i<arrayObj->Length(); i++) {
       v8::Local<v8::Value> item = arrayObj->Get(i);
-      jobject val = v8ToJava(env, item);
+      V8ConversionPath conversionPath;
+      jobject val = v8ToJava(env, item, &conversionPath);
+      if(conversionPath.failed()) {
+        return ThrowException(conversionPath.getError());
+      }
       env->SetObjectArrayElement((jobjectArray)results, i, val);
+      env->DeleteLocalRef(val);
       if(env->ExceptionOccurred()) {
         std::ostringstream errStr;
         v8::String::AsciiValue valStr(item);
@@ -460,7 +812,9 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
     }
   }
 
-  return scope.Close(JavaObject::New(self, results));
+  v8::Local<v8::Object> resultsObj = JavaObject::New(self, results);
+  env->DeleteLocalRef(results);
+  return scope.Close(resultsObj);
 }
 
 /*static*/ v8::Handle<v8::Value> Java::newByte(const v8::Arguments& args) {
@@ -487,7 +841,29 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   jmethodID constructor = env->GetMethodID(clazz, "<init>", "(B)V");
   jobject newObj = env->NewObject(clazz, constructor, (jbyte)val->Value());
 
-  return scope.Close(JavaObject::New(self, newObj));
+  v8::Local<v8::Object> newObjObj = JavaObject::New(self, newObj);
+  env->DeleteLocalRef(newObj);
+  env->DeleteLocalRef(clazz);
+  return scope.Close(newObjObj);
+}
+
+/*
+ * Typed values need no JVM, so unlike newByte these work before the JVM is created.
+ */
+/*static*/ v8::Handle<v8::Value> Java::newTypedLong(const v8::Arguments& args) {
+  return TypedValue::New('J', args);
+}
+
+/*static*/ v8::Handle<v8::Value> Java::newTypedFloat(const v8::Arguments& args) {
+  return TypedValue::New('F', args);
+}
+
+/*static*/ v8::Handle<v8::Value> Java::newTypedShort(const v8::Arguments& args) {
+  return TypedValue::New('S', args);
+}
+
+/*static*/ v8::Handle<v8::Value> Java::newTypedChar(const v8::Arguments& args) {
+  return TypedValue::New('C', args);
 }
 
 /*static*/ v8::Handle<v8::Value> Java::getStaticFieldValue(const v8::Arguments& args) {
@@ -506,10 +882,11 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   // arguments
   ARGS_FRONT_CLASSNAME();
   ARGS_FRONT_STRING(fieldName);
+  SyncCallGuard syncCallGuard(&self->m_syncWatchdog, className, fieldName);
   UNUSED_VARIABLE(argsEnd);
 
   // find the class
-  jclass clazz = javaFindClass(env, className);
+  jclass clazz = self->m_classCache.find(env, className);
   if(clazz == NULL) {
     std::ostringstream errStr;
     errStr << "Could not create class " << className.c_str();
@@ -535,11 +912,10 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
     POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(javaExceptionToV8(env, errStr.str())));
   }
 
-  env->DeleteLocalRef(clazz);
   env->DeleteLocalRef(field);
   env->DeleteLocalRef(fieldClazz);
 
-  POP_LOCAL_JAVA_FRAME_AND_RETURN(scope.Close(javaToV8(self, env, val)));
+  POP_LOCAL_JAVA_FRAME_AND_RETURN(scope.Close(javaToV8(self, env, val, self->getConversionOptions())));
 }
 
 /*static*/ v8::Handle<v8::Value> Java::setStaticFieldValue(const v8::Arguments& args) {
@@ -558,6 +934,7 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   // arguments
   ARGS_FRONT_CLASSNAME();
   ARGS_FRONT_STRING(fieldName);
+  SyncCallGuard syncCallGuard(&self->m_syncWatchdog, className, fieldName);
 
   // argument - new value
   if(args.Length() < argsStart+1) {
@@ -565,13 +942,17 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
     errStr << "setStaticFieldValue requires " << (argsStart+1) << " arguments";
     POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(v8::Exception::TypeError(v8::String::New(errStr.str().c_str()))));
   }
-  jobject newValue = v8ToJava(env, args[argsStart]);
+  V8ConversionPath conversionPath;
+  jobject newValue = v8ToJava(env, args[argsStart], &conversionPath);
+  if(conversionPath.failed()) {
+    POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(conversionPath.getError()));
+  }
   argsStart++;
 
   UNUSED_VARIABLE(argsEnd);
 
   // find the class
-  jclass clazz = javaFindClass(env, className);
+  jclass clazz = self->m_classCache.find(env, className);
   if(clazz == NULL) {
     std::ostringstream errStr;
     errStr << "Could not create class " << className.c_str();
@@ -602,6 +983,64 @@ v8::Handle<v8::Value> Java::createJVM(JavaVM** jvm, JNIEnv** env) {
   POP_LOCAL_JAVA_FRAME_AND_RETURN(v8::Undefined());
 }
 
+/*static*/ v8::Handle<v8::Value> Java::callOptions(const v8::Arguments& args) {
+  v8::HandleScope scope;
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_FRONT_OBJECT(options);
+  UNUSED_VARIABLE(argsEnd);
+
+  return scope.Close(CallOptions::New(options));
+}
+
+/*static*/ v8::Handle<v8::Value> Java::setAsyncOptions(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_FRONT_OBJECT(options);
+  UNUSED_VARIABLE(argsEnd);
+
+  return scope.Close(self->m_scheduler.setOptions(options));
+}
+
+/*static*/ v8::Handle<v8::Value> Java::getAsyncStats(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Object> result = self->m_scheduler.getStats();
+  result->Set(v8::String::New("batonPool"), MethodCallBaton::poolStatsToV8());
+  result->Set(v8::String::New("methodCache"), self->m_methodCache.toV8());
+  return scope.Close(result);
+}
+
+/*static*/ v8::Handle<v8::Value> Java::setConversionOptions(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_FRONT_OBJECT(options);
+  UNUSED_VARIABLE(argsEnd);
+
+  ConversionOptions conversionOptions = self->m_conversionOptions;
+  bool found;
+  v8::Handle<v8::Value> parseResults = conversionOptionsParse(options, &conversionOptions, &found);
+  if(!parseResults->IsUndefined()) {
+    return parseResults;
+  }
+  self->m_conversionOptions = conversionOptions;
+
+  return v8::Undefined();
+}
+
 void EIO_CallJs(uv_work_t* req) {
 }
 
@@ -613,6 +1052,7 @@ void EIO_AfterCallJs(uv_work_t* req) {
   dynamicProxyData->result = NULL;
 
   JNIEnv* env = dynamicProxyData->env;
+  uint64_t traceStartNs = traceEnabled() ? uv_hrtime() : 0;
 
   v8::HandleScope scope;
   v8::Array* v8Args;
@@ -622,6 +1062,7 @@ void EIO_AfterCallJs(uv_work_t* req) {
   int i;
   v8::Local<v8::Value> v8Result;
   jobject javaResult;
+  V8ConversionPath conversionPath;
 
   v8::Local<v8::Value> fnObj = dynamicProxyData->functions->Get(v8::String::New(dynamicProxyData->methodName.c_str()));
   if(fnObj->IsUndefined() || fnObj->IsNull()) {
@@ -651,19 +1092,25 @@ void EIO_AfterCallJs(uv_work_t* req) {
     return;
   }
 
-  javaResult = v8ToJava(env, v8Result);
-  if(javaResult == NULL) {
+  javaResult = v8ToJava(env, v8Result, &conversionPath);
+  if(conversionPath.failed()) {
+    printf("ERROR: Could not convert the result of %s, the value contains itself or is nested too deeply.\n", dynamicProxyData->methodName.c_str());
+    dynamicProxyData->result = NULL;
+  } else if(javaResult == NULL) {
     dynamicProxyData->result = NULL;
   } else {
-    dynamicProxyData->result = env->NewGlobalRef(javaResult);
+    dynamicProxyData->result = refStatsNewGlobalRef(env, javaResult, REF_SITE_PROXY);
+    env->DeleteLocalRef(javaResult);
   }
 
 CleanUp:
+  traceComplete("proxy", "EIO_AfterCallJs", dynamicProxyData->methodName.c_str(), traceStartNs, uv_hrtime());
   dynamicProxyData->done = true;
 }
 
 JNIEXPORT jobject JNICALL Java_node_NodeDynamicProxyClass_callJs(JNIEnv *env, jobject src, jlong ptr, jobject method, jobjectArray args) {
   long myThreadId = my_getThreadId();
+  uint64_t traceStartNs = traceEnabled() ? uv_hrtime() : 0;
 
   DynamicProxyData* dynamicProxyData = (DynamicProxyData*)ptr;
   dynamicProxyData->env = env;
@@ -673,7 +1120,10 @@ JNIEXPORT jobject JNICALL Java_node_NodeDynamicProxyClass_callJs(JNIEnv *env, jo
 
   jclass methodClazz = env->FindClass("java/lang/reflect/Method");
   jmethodID method_getName = env->GetMethodID(methodClazz, "getName", "()Ljava/lang/String;");
-  dynamicProxyData->methodName = javaObjectToString(env, env->CallObjectMethod(method, method_getName));
+  jobject methodName = env->CallObjectMethod(method, method_getName);
+  dynamicProxyData->methodName = javaObjectToString(env, methodName);
+  env->DeleteLocalRef(methodName);
+  env->DeleteLocalRef(methodClazz);
 
   uv_work_t* req = new uv_work_t();
   req->data = dynamicProxyData;
@@ -690,8 +1140,597 @@ JNIEXPORT jobject JNICALL Java_node_NodeDynamicProxyClass_callJs(JNIEnv *env, jo
   if(!dynamicProxyDataVerify(dynamicProxyData)) {
     return NULL;
   }
+  // hand java a local ref, the global one only carried the result across threads
+  jobject result = NULL;
   if(dynamicProxyData->result) {
-    env->DeleteGlobalRef(dynamicProxyData->result);
+    result = env->NewLocalRef(dynamicProxyData->result);
+    refStatsDeleteGlobalRef(env, dynamicProxyData->result, REF_SITE_PROXY);
+    dynamicProxyData->result = NULL;
+  }
+  if(traceStartNs && myThreadId != v8ThreadId) {
+    traceSetThreadName("java");
+  }
+  traceComplete("proxy", "callJs", dynamicProxyData->methodName.c_str(), traceStartNs, uv_hrtime());
+  return result;
+}
+
+/*
+ * Used by java.createReadStream to read the next chunk of an InputStream, Reader or Iterator on the
+ * thread pool. maxCount is the number of bytes, chars or elements to read at most.
+ */
+/*static*/ v8::Handle<v8::Value> Java::streamRead(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Value> ensureJvmResults = self->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    return ensureJvmResults;
   }
-  return dynamicProxyData->result;
+  JNIEnv* env = self->getJavaEnv();
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_FRONT_OBJECT(obj);
+  ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
+
+  v8::String::AsciiValue constructorName(obj->GetConstructorName());
+  if(strcmp(*constructorName, "JavaObject") != 0) {
+    EXCEPTION_CALL_CALLBACK("Argument 1 must be a java object");
+    return v8::Undefined();
+  }
+  JavaObject* javaObject = node::ObjectWrap::Unwrap<JavaObject>(obj);
+
+  jint maxCount = 64 * 1024;
+  if(argsEnd > argsStart && args[argsStart]->IsNumber()) {
+    maxCount = args[argsStart]->Int32Value();
+  }
+  if(maxCount < 1) {
+    EXCEPTION_CALL_CALLBACK("Chunk size must be greater than 0");
+    return v8::Undefined();
+  }
+
+  JavaConversionIds* ids = &javaConversionIds;
+  jobject jobj = javaObject->getObject();
+  streamKind kind;
+  if(env->IsInstanceOf(jobj, ids->inputStreamClazz)) {
+    kind = STREAM_KIND_INPUT_STREAM;
+  } else if(env->IsInstanceOf(jobj, ids->readerClazz)) {
+    kind = STREAM_KIND_READER;
+  } else if(env->IsInstanceOf(jobj, ids->iteratorClazz)) {
+    kind = STREAM_KIND_ITERATOR;
+  } else {
+    EXCEPTION_CALL_CALLBACK("Object must be a java.io.InputStream, java.io.Reader or java.util.Iterator");
+    return v8::Undefined();
+  }
+
+  StreamReadBaton* baton = new StreamReadBaton(self, javaObject, kind, maxCount, callback);
+  baton->setCallOptions(callOptions);
+  if(!baton->run()) {
+    return v8::False();
+  }
+
+  END_CALLBACK_FUNCTION("\"streamRead called without a callback\"");
+}
+
+/*
+ * Used by java.createWriteStream. All the Buffers passed in are copied into one byte[] and written to
+ * the OutputStream with a single write call on the thread pool.
+ */
+/*static*/ v8::Handle<v8::Value> Java::streamWrite(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Value> ensureJvmResults = self->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    return ensureJvmResults;
+  }
+  JNIEnv* env = self->getJavaEnv();
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_FRONT_OBJECT(obj);
+  ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
+
+  v8::String::AsciiValue constructorName(obj->GetConstructorName());
+  if(strcmp(*constructorName, "JavaObject") != 0) {
+    EXCEPTION_CALL_CALLBACK("Argument 1 must be a java object");
+    return v8::Undefined();
+  }
+  JavaObject* javaObject = node::ObjectWrap::Unwrap<JavaObject>(obj);
+  if(!env->IsInstanceOf(javaObject->getObject(), javaConversionIds.outputStreamClazz)) {
+    EXCEPTION_CALL_CALLBACK("Object must be a java.io.OutputStream");
+    return v8::Undefined();
+  }
+
+  v8::Local<v8::Array> chunks;
+  if(argsEnd > argsStart && args[argsStart]->IsArray()) {
+    chunks = v8::Local<v8::Array>::Cast(args[argsStart]);
+  } else {
+    chunks = v8::Array::New(0);
+    if(argsEnd > argsStart) {
+      chunks->Set(0, args[argsStart]);
+    }
+  }
+
+  StreamWriteBaton* baton = new StreamWriteBaton(self, javaObject, callback);
+  for(uint32_t i=0; i<chunks->Length(); i++) {
+    v8::Local<v8::Value> chunk = chunks->Get(i);
+    if(!node::Buffer::HasInstance(chunk)) {
+      delete baton;
+      EXCEPTION_CALL_CALLBACK("Chunks must be Buffers");
+      return v8::Undefined();
+    }
+    v8::Local<v8::Object> chunkObj = v8::Local<v8::Object>::Cast(chunk);
+    baton->append(node::Buffer::Data(chunkObj), node::Buffer::Length(chunkObj));
+  }
+  baton->setCallOptions(callOptions);
+  if(!baton->run()) {
+    return v8::False();
+  }
+
+  END_CALLBACK_FUNCTION("\"streamWrite called without a callback\"");
+}
+
+/*static*/ v8::Handle<v8::Value> Java::createEventRing(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Value> ensureJvmResults = self->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    return ensureJvmResults;
+  }
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_FRONT_OBJECT(options);
+  if(argsEnd <= argsStart || !args[argsStart]->IsFunction()) {
+    return ThrowException(v8::Exception::TypeError(v8::String::New("Argument 2 must be a function")));
+  }
+  v8::Local<v8::Value> callback = args[argsStart];
+
+  return scope.Close(EventRing::New(self, options, callback));
+}
+
+/*static*/ v8::Handle<v8::Value> Java::stats(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  return scope.Close(self->m_stats.toV8());
+}
+
+/*static*/ v8::Handle<v8::Value> Java::setStatsEnabled(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  self->m_stats.setEnabled(args.Length() > 0 && args[0]->BooleanValue());
+  return v8::Undefined();
+}
+
+/*static*/ v8::Handle<v8::Value> Java::resetStats(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  self->m_stats.reset();
+  return v8::Undefined();
+}
+
+/*static*/ v8::Handle<v8::Value> Java::startTracing(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  traceStart();
+  return v8::Undefined();
+}
+
+/*static*/ v8::Handle<v8::Value> Java::stopTracing(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  std::string trace = traceStop();
+  return scope.Close(v8::String::New(trace.c_str(), trace.size()));
+}
+
+/*static*/ v8::Handle<v8::Value> Java::setSyncWatchdog(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Value> ensureJvmResults = self->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    return ensureJvmResults;
+  }
+
+  v8::Handle<v8::Value> options = args.Length() > 0 ? args[0] : v8::Handle<v8::Value>(v8::Undefined());
+  return scope.Close(self->m_syncWatchdog.setOptions(self, options));
+}
+
+/*static*/ v8::Handle<v8::Value> Java::getBlockedSyncCalls(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  return scope.Close(self->m_syncWatchdog.takeReports());
+}
+
+/*static*/ v8::Handle<v8::Value> Java::refStats(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  return scope.Close(refStatsToV8());
+}
+
+/*
+ * Live counts always reflect what is currently held, only the high-water marks can be reset.
+ */
+/*static*/ v8::Handle<v8::Value> Java::resetRefStats(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  refStatsResetHighWaterMarks();
+  return v8::Undefined();
+}
+
+/*static*/ v8::Handle<v8::Value> Java::getMethod(const v8::Arguments& args) {
+  return bindMethod(args, true);
+}
+
+/*static*/ v8::Handle<v8::Value> Java::getInstanceMethod(const v8::Arguments& args) {
+  return bindMethod(args, false);
+}
+
+/*static*/ v8::Handle<v8::Value> Java::bindMethod(const v8::Arguments& args, bool isStatic) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Value> ensureJvmResults = self->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    return ensureJvmResults;
+  }
+
+  int argsStart = 0;
+
+  // arguments
+  ARGS_FRONT_CLASSNAME();
+  ARGS_FRONT_STRING(methodName);
+  v8::Handle<v8::Value> paramTypes = v8::Undefined();
+  if(args.Length() > argsStart && !args[argsStart]->IsUndefined() && !args[argsStart]->IsNull()) {
+    if(!args[argsStart]->IsArray() && !args[argsStart]->IsString()) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("Argument 3 must be an array of type names or a method signature")));
+    }
+    paramTypes = args[argsStart];
+  }
+
+  v8::Handle<v8::Value> result = self->getBoundMethod(className, methodName, paramTypes, isStatic);
+  if(result->IsNativeError()) {
+    return ThrowException(result);
+  }
+  return scope.Close(result);
+}
+
+/*
+ * Bound functions are never collected by v8, so one is made per method and kept for later
+ * getMethod/getInstanceMethod calls and signature calls. paramTypes is undefined, an array of type
+ * names or a JNI signature; each gets its own key. Failed binds are not kept.
+ */
+v8::Handle<v8::Value> Java::getBoundMethod(const std::string& className, const std::string& methodName, v8::Handle<v8::Value> paramTypes, bool isStatic) {
+  v8::HandleScope scope;
+  std::ostringstream key;
+  key << className << "#" << methodName << (isStatic ? "#static#" : "#instance#");
+  if(paramTypes->IsArray()) {
+    v8::Array* paramTypesArray = v8::Array::Cast(*paramTypes);
+    key << "[";
+    for(uint32_t i=0; i<paramTypesArray->Length(); i++) {
+      v8::String::AsciiValue typeName(paramTypesArray->Get(i));
+      key << (i > 0 ? "," : "") << *typeName;
+    }
+    key << "]";
+  } else if(paramTypes->IsString()) {
+    v8::String::AsciiValue signature(paramTypes);
+    key << *signature;
+  }
+
+  std::map<std::string, v8::Persistent<v8::Function> >::iterator it = m_boundMethods.find(key.str());
+  if(it != m_boundMethods.end()) {
+    return scope.Close(it->second);
+  }
+  v8::Handle<v8::Value> bound = BoundMethod::New(this, className, methodName, paramTypes, isStatic);
+  if(bound->IsNativeError()) {
+    return scope.Close(bound);
+  }
+  m_boundMethods[key.str()] = v8::Persistent<v8::Function>::New(v8::Handle<v8::Function>::Cast(bound));
+  return scope.Close(bound);
+}
+
+/*
+ * Used by the builder java.pipeline returns. Takes the steps, optionally the indexes of the steps whose
+ * results are wanted, call options and the callback.
+ */
+/*static*/ v8::Handle<v8::Value> Java::runPipeline(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Value> ensureJvmResults = self->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    return ensureJvmResults;
+  }
+  JNIEnv* env = self->getJavaEnv();
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_FRONT_OBJECT(stepsObj);
+  ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
+
+  if(!stepsObj->IsArray() || v8::Array::Cast(*stepsObj)->Length() == 0) {
+    EXCEPTION_CALL_CALLBACK("A pipeline needs at least one step");
+    return v8::Undefined();
+  }
+  v8::Local<v8::Array> steps = v8::Local<v8::Array>(v8::Array::Cast(*stepsObj));
+
+  PipelineBaton* baton = new PipelineBaton(self, callback);
+  for(uint32_t i=0; i<steps->Length(); i++) {
+    std::string error;
+    if(!steps->Get(i)->IsObject() || !baton->addStep(env, steps->Get(i)->ToObject(), error)) {
+      delete baton;
+      EXCEPTION_CALL_CALLBACK((error.empty() ? "Invalid pipeline step" : error));
+      return v8::Undefined();
+    }
+  }
+  if(argsEnd > argsStart && args[argsStart]->IsArray()) {
+    v8::Local<v8::Array> keep = v8::Local<v8::Array>(v8::Array::Cast(*args[argsStart]));
+    for(uint32_t i=0; i<keep->Length(); i++) {
+      if(!baton->keepStep(keep->Get(i)->Int32Value())) {
+        delete baton;
+        EXCEPTION_CALL_CALLBACK("Pipeline results must name steps of the pipeline");
+        return v8::Undefined();
+      }
+    }
+  }
+
+  baton->setCallOptions(callOptions);
+  if(!baton->run()) {
+    return v8::False();
+  }
+
+  END_CALLBACK_FUNCTION("\"runPipeline called without a callback\"");
+}
+
+/*
+ * Used by java.parallelMap, which splits its input and runs one chunk per call. Takes the target (a
+ * class name for a static method or a java object), the method name, an array with the arguments of
+ * each call, call options and the callback.
+ */
+/*static*/ v8::Handle<v8::Value> Java::mapChunk(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Value> ensureJvmResults = self->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    return ensureJvmResults;
+  }
+  JNIEnv* env = self->getJavaEnv();
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  v8::Local<v8::Value> target = args[argsStart];
+  argsStart++;
+  ARGS_FRONT_STRING(methodName);
+  ARGS_FRONT_OBJECT(itemsObj);
+  ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
+
+  if(!itemsObj->IsArray() || v8::Array::Cast(*itemsObj)->Length() == 0) {
+    EXCEPTION_CALL_CALLBACK("A chunk needs at least one item");
+    return v8::Undefined();
+  }
+  v8::Local<v8::Array> items = v8::Local<v8::Array>(v8::Array::Cast(*itemsObj));
+  for(uint32_t i=0; i<items->Length(); i++) {
+    if(!items->Get(i)->IsArray()) {
+      EXCEPTION_CALL_CALLBACK("Item " << i << " of the chunk must be an array of arguments");
+      return v8::Undefined();
+    }
+  }
+
+  jobject targetObj = NULL;
+  jclass clazz;
+  std::string className;
+  if(JavaObject::HasInstance(target)) {
+    JavaObject* javaObject = node::ObjectWrap::Unwrap<JavaObject>(target->ToObject());
+    targetObj = javaObject->getObject();
+    clazz = javaObject->getClass();
+    className = javaObject->getClassName();
+  } else if(target->IsString()) {
+    v8::String::AsciiValue classNameStr(target);
+    className = *classNameStr;
+    clazz = self->m_classCache.find(env, className);
+    if(clazz == NULL) {
+      EXCEPTION_CALL_CALLBACK("Could not find class " << className);
+      return v8::Undefined();
+    }
+  } else {
+    return ThrowException(v8::Exception::TypeError(v8::String::New("Argument 1 must be a class name or a java object")));
+  }
+
+  V8ConversionPath conversionPath;
+  std::vector<NativeValue*> nativeItems;
+  for(uint32_t i=0; i<items->Length() && !conversionPath.failed(); i++) {
+    nativeItems.push_back(v8ValueToNative(env, items->Get(i), &conversionPath));
+  }
+  if(conversionPath.failed()) {
+    for(std::vector<NativeValue*>::iterator it = nativeItems.begin(); it != nativeItems.end(); it++) {
+      deleteNativeValue(env, *it);
+    }
+    return ThrowException(conversionPath.getError());
+  }
+
+  ParallelMapBaton* baton = new ParallelMapBaton(self, targetObj, callback);
+  for(size_t i=1; i<nativeItems.size(); i++) {
+    baton->addItem(nativeItems[i]);
+  }
+  baton->deferArgs(nativeItems[0], clazz, className, methodName);
+  baton->setCallOptions(callOptions);
+  if(!baton->run()) {
+    return v8::False();
+  }
+
+  END_CALLBACK_FUNCTION("\"mapChunk called without a callback\"");
+}
+
+/*
+ * Used by java.preload, which fans out one call per class. Options are initialize (default true),
+ * warmup (the name of a static method), args (its arguments) and iterations (default 1).
+ */
+/*static*/ v8::Handle<v8::Value> Java::preloadClass(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  v8::Handle<v8::Value> ensureJvmResults = self->ensureJvm();
+  if(!ensureJvmResults->IsUndefined()) {
+    return ensureJvmResults;
+  }
+  JNIEnv* env = self->getJavaEnv();
+
+  int argsStart = 0;
+  int argsEnd = args.Length();
+
+  // arguments
+  ARGS_FRONT_CLASSNAME();
+  ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
+
+  bool initialize = true;
+  std::string warmupMethodName;
+  jint iterations = 1;
+  jobjectArray warmupArgs = NULL;
+  std::string warmupKey;
+  if(argsEnd > argsStart && args[argsStart]->IsObject()) {
+    v8::Local<v8::Object> options = args[argsStart]->ToObject();
+    v8::Local<v8::Value> initializeValue = options->Get(v8::String::New("initialize"));
+    if(!initializeValue->IsUndefined()) {
+      initialize = initializeValue->BooleanValue();
+    }
+    v8::Local<v8::Value> warmupValue = options->Get(v8::String::New("warmup"));
+    if(warmupValue->IsString()) {
+      v8::String::AsciiValue warmupStr(warmupValue);
+      warmupMethodName = *warmupStr;
+    }
+    v8::Local<v8::Value> iterationsValue = options->Get(v8::String::New("iterations"));
+    if(iterationsValue->IsNumber()) {
+      iterations = iterationsValue->Int32Value();
+    }
+    v8::Local<v8::Value> argsValue = options->Get(v8::String::New("args"));
+    if(!warmupMethodName.empty()) {
+      // built the way callStaticMethod builds its arguments, so the warm-up method is cached under the same key
+      v8::Local<v8::Array> argsArray = argsValue->IsArray() ? v8::Local<v8::Array>(v8::Array::Cast(*argsValue)) : v8::Array::New();
+      NativeValue* nativeArgs = new NativeValue();
+      nativeArgs->type = NATIVE_ARRAY;
+      nativeArgs->objectValue = NULL;
+      V8ConversionPath conversionPath;
+      for(uint32_t i=0; i<argsArray->Length() && !conversionPath.failed(); i++) {
+        nativeArgs->items.push_back(v8ValueToNative(env, argsArray->Get(i), &conversionPath));
+      }
+      if(conversionPath.failed()) {
+        deleteNativeValue(env, nativeArgs);
+        return ThrowException(conversionPath.getError());
+      }
+      self->m_methodCache.keyFor(env, className, warmupMethodName, nativeArgs, &warmupKey);
+      warmupArgs = nativeToJavaArgs(env, nativeArgs);
+      deleteNativeValue(env, nativeArgs);
+    }
+  }
+  if(iterations < 0) {
+    EXCEPTION_CALL_CALLBACK("Warm-up iterations must not be negative");
+    return v8::Undefined();
+  }
+
+  PreloadClassBaton* baton = new PreloadClassBaton(self, className, initialize, warmupMethodName, iterations, warmupArgs, callback);
+  baton->setWarmupKey(warmupKey);
+  if(warmupArgs) {
+    env->DeleteLocalRef(warmupArgs);
+  }
+  baton->setCallOptions(callOptions);
+  if(!baton->run()) {
+    return v8::False();
+  }
+
+  END_CALLBACK_FUNCTION("\"preloadClass called without a callback\"");
+}
+
+/*
+ * Only the cache's own ref is dropped. Batons, bound methods and wrapped class objects hold their own
+ * refs, so calls already in flight are not affected by an eviction.
+ */
+/*static*/ v8::Handle<v8::Value> Java::evictClass(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  if(!self->m_jvm) {
+    return v8::False();
+  }
+  JNIEnv* env = self->getJavaEnv();
+
+  int argsStart = 0;
+
+  // arguments
+  ARGS_FRONT_CLASSNAME();
+
+  return scope.Close(v8::Boolean::New(self->m_classCache.evict(env, className)));
+}
+
+/*static*/ v8::Handle<v8::Value> Java::clearClassCache(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  if(self->m_jvm) {
+    self->m_classCache.clear(self->getJavaEnv());
+  }
+  return v8::Undefined();
+}
+
+/*static*/ v8::Handle<v8::Value> Java::getClassCacheStats(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  return scope.Close(self->m_classCache.toV8());
+}
+
+/*
+ * Opts a static method in to having its results cached. Options are maxEntries (default 1000) and
+ * ttl in milliseconds (default 0, entries only leave when evicted).
+ */
+/*static*/ v8::Handle<v8::Value> Java::memoize(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+
+  int argsStart = 0;
+
+  // arguments
+  ARGS_FRONT_CLASSNAME();
+  ARGS_FRONT_STRING(methodName);
+
+  double maxEntries = MEMO_DEFAULT_MAX_ENTRIES;
+  double ttl = 0;
+  if(args.Length() > argsStart && args[argsStart]->IsObject()) {
+    v8::Local<v8::Object> options = args[argsStart]->ToObject();
+    v8::Local<v8::Value> maxEntriesValue = options->Get(v8::String::New("maxEntries"));
+    if(!maxEntriesValue->IsUndefined()) {
+      maxEntries = maxEntriesValue->NumberValue();
+    }
+    v8::Local<v8::Value> ttlValue = options->Get(v8::String::New("ttl"));
+    if(!ttlValue->IsUndefined()) {
+      ttl = ttlValue->NumberValue();
+    }
+  }
+  if(!(maxEntries >= 1) || !(ttl >= 0)) {
+    return ThrowException(v8::Exception::RangeError(v8::String::New("maxEntries must be at least 1 and ttl must not be negative")));
+  }
+
+  self->m_memoCache.enable(className, methodName, (size_t)maxEntries, (uint64_t)ttl);
+  return v8::Undefined();
+}
+
+/*static*/ v8::Handle<v8::Value> Java::unmemoize(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+
+  int argsStart = 0;
+
+  // arguments
+  ARGS_FRONT_CLASSNAME();
+  ARGS_FRONT_STRING(methodName);
+
+  return scope.Close(v8::Boolean::New(self->m_memoCache.disable(className, methodName)));
+}
+
+/*static*/ v8::Handle<v8::Value> Java::getMemoStats(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  Java* self = node::ObjectWrap::Unwrap<Java>(args.This());
+  return scope.Close(self->m_memoCache.toV8());
 }
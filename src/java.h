@@ -6,12 +6,44 @@
 #include <node.h>
 #include <jni.h>
 #include <string>
+#include <vector>
+#include <map>
+#include "asyncScheduler.h"
+#include "nativeValue.h"
+#include "bridgeStats.h"
+#include "syncWatchdog.h"
+#include "refStats.h"
+#include "classCache.h"
+#include "methodCache.h"
+#include "memoCache.h"
+
+class CallOptions;
+
+// a callback called on the next turn of the event loop by Java::deferCallback
+struct DeferredCallback {
+  v8::Persistent<v8::Value> callback;
+  v8::Persistent<v8::Value> error;
+  v8::Persistent<v8::Value> result;
+};
 
 class Java : public node::ObjectWrap {
 public:
   static void Init(v8::Handle<v8::Object> target);
   JavaVM* getJvm() { return m_jvm; }
   JNIEnv* getJavaEnv() { return m_env; }
+  jclass getNodeDynamicProxyClass();
+  void releaseGlobalRef(jobject ref, refSite site);
+  void deferCallback(v8::Handle<v8::Value> callback, v8::Handle<v8::Value> error, v8::Handle<v8::Value> result);
+  AsyncScheduler* getScheduler() { return &m_scheduler; }
+  const ConversionOptions& getConversionOptions() { return m_conversionOptions; }
+  BridgeStats* getStats() { return &m_stats; }
+  SyncWatchdog* getSyncWatchdog() { return &m_syncWatchdog; }
+  ClassCache* getClassCache() { return &m_classCache; }
+  MethodCache* getMethodCache() { return &m_methodCache; }
+  MemoCache* getMemoCache() { return &m_memoCache; }
+  v8::Handle<v8::Value> ensureJvm();
+  v8::Handle<v8::Value> getBoundMethod(const std::string& className, const std::string& methodName, v8::Handle<v8::Value> paramTypes, bool isStatic);
+  v8::Handle<v8::Value> callWithSignature(const v8::Arguments& args, int argsStart, int argsEnd, v8::Handle<v8::Value> target, const std::string& className, const std::string& methodName, CallOptions* callOptions, v8::Handle<v8::Value> callback, bool callbackProvided);
 
 private:
   Java();
@@ -27,14 +59,62 @@ private:
   static v8::Handle<v8::Value> findClassSync(const v8::Arguments& args);
   static v8::Handle<v8::Value> newArray(const v8::Arguments& args);
   static v8::Handle<v8::Value> newByte(const v8::Arguments& args);
+  static v8::Handle<v8::Value> newTypedLong(const v8::Arguments& args);
+  static v8::Handle<v8::Value> newTypedFloat(const v8::Arguments& args);
+  static v8::Handle<v8::Value> newTypedShort(const v8::Arguments& args);
+  static v8::Handle<v8::Value> newTypedChar(const v8::Arguments& args);
   static v8::Handle<v8::Value> getStaticFieldValue(const v8::Arguments& args);
   static v8::Handle<v8::Value> setStaticFieldValue(const v8::Arguments& args);
-  v8::Handle<v8::Value> ensureJvm();
+  static v8::Handle<v8::Value> callOptions(const v8::Arguments& args);
+  static v8::Handle<v8::Value> setAsyncOptions(const v8::Arguments& args);
+  static v8::Handle<v8::Value> getAsyncStats(const v8::Arguments& args);
+  static v8::Handle<v8::Value> setConversionOptions(const v8::Arguments& args);
+  static v8::Handle<v8::Value> streamRead(const v8::Arguments& args);
+  static v8::Handle<v8::Value> streamWrite(const v8::Arguments& args);
+  static v8::Handle<v8::Value> createEventRing(const v8::Arguments& args);
+  static v8::Handle<v8::Value> stats(const v8::Arguments& args);
+  static v8::Handle<v8::Value> setStatsEnabled(const v8::Arguments& args);
+  static v8::Handle<v8::Value> resetStats(const v8::Arguments& args);
+  static v8::Handle<v8::Value> startTracing(const v8::Arguments& args);
+  static v8::Handle<v8::Value> stopTracing(const v8::Arguments& args);
+  static v8::Handle<v8::Value> setSyncWatchdog(const v8::Arguments& args);
+  static v8::Handle<v8::Value> getBlockedSyncCalls(const v8::Arguments& args);
+  static v8::Handle<v8::Value> refStats(const v8::Arguments& args);
+  static v8::Handle<v8::Value> resetRefStats(const v8::Arguments& args);
+  static v8::Handle<v8::Value> getMethod(const v8::Arguments& args);
+  static v8::Handle<v8::Value> getInstanceMethod(const v8::Arguments& args);
+  static v8::Handle<v8::Value> bindMethod(const v8::Arguments& args, bool isStatic);
+  static v8::Handle<v8::Value> runPipeline(const v8::Arguments& args);
+  static v8::Handle<v8::Value> mapChunk(const v8::Arguments& args);
+  static v8::Handle<v8::Value> preloadClass(const v8::Arguments& args);
+  static v8::Handle<v8::Value> evictClass(const v8::Arguments& args);
+  static v8::Handle<v8::Value> clearClassCache(const v8::Arguments& args);
+  static v8::Handle<v8::Value> getClassCacheStats(const v8::Arguments& args);
+  static v8::Handle<v8::Value> memoize(const v8::Arguments& args);
+  static v8::Handle<v8::Value> unmemoize(const v8::Arguments& args);
+  static v8::Handle<v8::Value> getMemoStats(const v8::Arguments& args);
+  static void releaseGlobalRefsIdle(uv_idle_t* handle, int status);
+  static void deferredCallbacksIdle(uv_idle_t* handle, int status);
 
   static v8::Persistent<v8::FunctionTemplate> s_ct;
   JavaVM* m_jvm;
   JNIEnv* m_env;
   std::string m_classPath;
+  jclass m_nodeDynamicProxyClass;
+  std::vector<jobject> m_pendingGlobalRefReleases;
+  uv_idle_t* m_releaseIdle;
+  bool m_releaseIdleActive;
+  std::vector<DeferredCallback> m_deferredCallbacks;
+  uv_idle_t* m_callbackIdle;
+  bool m_callbackIdleActive;
+  AsyncScheduler m_scheduler;
+  ConversionOptions m_conversionOptions;
+  BridgeStats m_stats;
+  SyncWatchdog m_syncWatchdog;
+  ClassCache m_classCache;
+  MethodCache m_methodCache;
+  MemoCache m_memoCache;
+  std::map<std::string, v8::Persistent<v8::Function> > m_boundMethods;
 };
 
 #endif
@@ -5,6 +5,37 @@
 #include <sstream>
 
 /*static*/ v8::Persistent<v8::FunctionTemplate> JavaObject::s_ct;
+/*static*/ std::map<std::string, JavaObjectClass*> JavaObject::s_objectClasses;
+
+/*
+ * Finds what a member name refers to: a field, a method, which is called asynchronously, or a method
+ * with "Sync" added, which is called synchronously. Fields win over methods of the same name.
+ */
+typedef enum _memberKind {
+  MEMBER_NONE,
+  MEMBER_FIELD,
+  MEMBER_METHOD,
+  MEMBER_METHOD_SYNC
+} memberKind;
+
+static memberKind javaObjectFindMember(JavaObjectClass* objectClass, const std::string& name, std::string* methodName) {
+  if(objectClass->fieldNames.find(name) != objectClass->fieldNames.end()) {
+    return MEMBER_FIELD;
+  }
+  if(objectClass->methodNames.find(name) != objectClass->methodNames.end()) {
+    *methodName = name;
+    return MEMBER_METHOD;
+  }
+  size_t suffixLength = 4; // "Sync"
+  if(name.length() > suffixLength && name.compare(name.length() - suffixLength, suffixLength, "Sync") == 0) {
+    std::string baseName = name.substr(0, name.length() - suffixLength);
+    if(objectClass->methodNames.find(baseName) != objectClass->methodNames.end()) {
+      *methodName = baseName;
+      return MEMBER_METHOD_SYNC;
+    }
+  }
+  return MEMBER_NONE;
+}
 
 /*static*/ void JavaObject::Init(v8::Handle<v8::Object> target) {
   v8::HandleScope scope;
@@ -23,74 +54,132 @@
   JNIEnv *env = java->getJavaEnv();
   PUSH_LOCAL_JAVA_FRAME();
 
-  v8::Local<v8::Function> ctor = s_ct->GetFunction();
-  v8::Local<v8::Object> javaObjectObj = ctor->NewInstance();
   JavaObject *self = new JavaObject(java, obj);
+  JavaObjectClass* objectClass = getObjectClass(env, self);
+  v8::Local<v8::Object> javaObjectObj = objectClass->objectTemplate->GetFunction()->NewInstance();
   self->Wrap(javaObjectObj);
 
+  POP_LOCAL_JAVA_FRAME();
+
+  return scope.Close(javaObjectObj);
+}
+
+/*
+ * Classes are told apart by name, so two classes of the same name from different class loaders
+ * share their member names. Methods are still found on the object's own class when called.
+ */
+/*static*/ JavaObjectClass* JavaObject::getObjectClass(JNIEnv* env, JavaObject* self) {
+  const std::string& className = self->getClassName();
+  std::map<std::string, JavaObjectClass*>::iterator it = s_objectClasses.find(className);
+  if(it != s_objectClasses.end()) {
+    return it->second;
+  }
+
+  JavaObjectClass* objectClass = new JavaObjectClass();
+  readMembers(env, self->m_class, &objectClass->methodNames, &objectClass->fieldNames);
+  initObjectClass(className, objectClass);
+  return objectClass;
+}
+
+/*
+ * Only uses JNI, so java.preload can read the members of a class on the thread pool.
+ */
+/*static*/ void JavaObject::readMembers(JNIEnv* env, jclass clazz, std::set<std::string>* methodNames, std::set<std::string>* fieldNames) {
   std::list<jobject> methods;
-  javaReflectionGetMethods(env, self->m_class, &methods);
+  javaReflectionGetMethods(env, clazz, &methods);
   jclass methodClazz = env->FindClass("java/lang/reflect/Method");
   jmethodID method_getName = env->GetMethodID(methodClazz, "getName", "()Ljava/lang/String;");
   for(std::list<jobject>::iterator it = methods.begin(); it != methods.end(); it++) {
     jstring methodNameJava = (jstring)env->CallObjectMethod(*it, method_getName);
-    std::string methodNameStr = javaToString(env, methodNameJava);
-
-    v8::Handle<v8::String> methodName = v8::String::New(methodNameStr.c_str());
-    v8::Local<v8::FunctionTemplate> methodCallTemplate = v8::FunctionTemplate::New(methodCall, methodName);
-    javaObjectObj->Set(methodName, methodCallTemplate->GetFunction());
-
-    v8::Handle<v8::String> methodNameSync = v8::String::New((methodNameStr + "Sync").c_str());
-    v8::Local<v8::FunctionTemplate> methodCallSyncTemplate = v8::FunctionTemplate::New(methodCallSync, methodName);
-    javaObjectObj->Set(methodNameSync, methodCallSyncTemplate->GetFunction());
-
+    methodNames->insert(javaToString(env, methodNameJava));
     env->DeleteLocalRef(methodNameJava);
     env->DeleteLocalRef(*it);
   }
+  env->DeleteLocalRef(methodClazz);
 
   std::list<jobject> fields;
-  javaReflectionGetFields(env, self->m_class, &fields);
+  javaReflectionGetFields(env, clazz, &fields);
   jclass fieldClazz = env->FindClass("java/lang/reflect/Field");
   jmethodID field_getName = env->GetMethodID(fieldClazz, "getName", "()Ljava/lang/String;");
   for(std::list<jobject>::iterator it = fields.begin(); it != fields.end(); it++) {
     jstring fieldNameJava = (jstring)env->CallObjectMethod(*it, field_getName);
-    std::string fieldNameStr = javaToString(env, fieldNameJava);
-
-    v8::Handle<v8::String> fieldName = v8::String::New(fieldNameStr.c_str());
-    javaObjectObj->SetAccessor(fieldName, fieldGetter, fieldSetter);
-
+    fieldNames->insert(javaToString(env, fieldNameJava));
     env->DeleteLocalRef(fieldNameJava);
     env->DeleteLocalRef(*it);
   }
+  env->DeleteLocalRef(fieldClazz);
+}
 
-  env->DeleteLocalRef(obj);
+/*
+ * Adds the template for a class ahead of its first object, from member names read by readMembers.
+ * A class that already has one is left alone.
+ */
+/*static*/ void JavaObject::addObjectClass(const std::string& className, const std::set<std::string>& methodNames, const std::set<std::string>& fieldNames) {
+  if(s_objectClasses.find(className) != s_objectClasses.end()) {
+    return;
+  }
+  JavaObjectClass* objectClass = new JavaObjectClass();
+  objectClass->methodNames = methodNames;
+  objectClass->fieldNames = fieldNames;
+  initObjectClass(className, objectClass);
+}
 
-  POP_LOCAL_JAVA_FRAME();
+/*static*/ void JavaObject::initObjectClass(const std::string& className, JavaObjectClass* objectClass) {
+  v8::HandleScope scope;
+  v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New();
+  t->Inherit(s_ct);
+  t->SetClassName(v8::String::NewSymbol("JavaObject"));
+  t->InstanceTemplate()->SetInternalFieldCount(1);
+  t->InstanceTemplate()->SetNamedPropertyHandler(memberGetter, memberSetter, memberQuery, NULL, memberEnumerator, v8::External::Wrap(objectClass));
+  objectClass->objectTemplate = v8::Persistent<v8::FunctionTemplate>::New(t);
+  s_objectClasses[className] = objectClass;
+}
 
-  return scope.Close(javaObjectObj);
+/*static*/ bool JavaObject::HasInstance(v8::Handle<v8::Value> val) {
+  return val->IsObject() && s_ct->HasInstance(val);
 }
 
 JavaObject::JavaObject(Java *java, jobject obj) {
   m_java = java;
   JNIEnv *env = m_java->getJavaEnv();
-  m_obj = env->NewGlobalRef(obj);
-  m_class = (jclass)env->NewGlobalRef(env->GetObjectClass(obj));
+  m_obj = refStatsNewGlobalRef(env, obj, REF_SITE_JAVA_OBJECT);
+  jclass clazz = env->GetObjectClass(obj);
+  m_class = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_JAVA_OBJECT);
+  env->DeleteLocalRef(clazz);
+
+  // look up the proxy data now so the destructor, which runs inside a GC pause, needs no JNI calls
+  m_proxyData = NULL;
+  jclass nodeDynamicProxyClass = m_java->getNodeDynamicProxyClass();
+  if(nodeDynamicProxyClass != NULL && env->IsInstanceOf(m_obj, nodeDynamicProxyClass)) {
+    jfieldID ptrField = env->GetFieldID(nodeDynamicProxyClass, "ptr", "J");
+    m_proxyData = (DynamicProxyData*)(long)env->GetLongField(m_obj, ptrField);
+  }
 }
 
 JavaObject::~JavaObject() {
-  JNIEnv *env = m_java->getJavaEnv();
+  uint64_t traceStartNs = traceEnabled() ? uv_hrtime() : 0;
 
-  jclass nodeDynamicProxyClass = env->FindClass("node/NodeDynamicProxyClass");
-  if(env->IsInstanceOf(m_obj, nodeDynamicProxyClass)) {
-    jfieldID ptrField = env->GetFieldID(nodeDynamicProxyClass, "ptr", "J");
-    DynamicProxyData* proxyData = (DynamicProxyData*)(long)env->GetLongField(m_obj, ptrField);
-    if(dynamicProxyDataVerify(proxyData)) {
-      delete proxyData;
-    }
+  if(m_proxyData && dynamicProxyDataVerify(m_proxyData)) {
+    delete m_proxyData;
   }
 
-  env->DeleteGlobalRef(m_obj);
-  env->DeleteGlobalRef(m_class);
+  m_java->releaseGlobalRef(m_obj, REF_SITE_JAVA_OBJECT);
+  m_java->releaseGlobalRef(m_class, REF_SITE_JAVA_OBJECT);
+
+  traceComplete("gc", "finalize", m_className.c_str(), traceStartNs, uv_hrtime());
+}
+
+const std::string& JavaObject::getClassName() {
+  if(m_className.empty()) {
+    JNIEnv *env = m_java->getJavaEnv();
+    jclass classClazz = env->FindClass("java/lang/Class");
+    jmethodID class_getName = env->GetMethodID(classClazz, "getName", "()Ljava/lang/String;");
+    jstring classNameJava = (jstring)env->CallObjectMethod(m_class, class_getName);
+    m_className = javaToString(env, classNameJava);
+    env->DeleteLocalRef(classNameJava);
+    env->DeleteLocalRef(classClazz);
+  }
+  return m_className;
 }
 
 /*static*/ v8::Handle<v8::Value> JavaObject::methodCall(const v8::Arguments& args) {
@@ -108,29 +197,43 @@ JavaObject::~JavaObject() {
 
   // arguments
   ARGS_BACK_CALLBACK();
+  ARGS_BACK_CALL_OPTIONS();
 
   if(!callbackProvided && methodNameStr == "toString") {
     POP_LOCAL_JAVA_FRAME();
     return methodCallSync(args);
   }
 
-  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd);
-
-  jobject method = javaFindMethod(env, self->m_class, methodNameStr, methodArgs);
-  if(method == NULL) {
-    EXCEPTION_CALL_CALLBACK("Could not find method " << methodNameStr);
+  if(callOptions && !callOptions->getSignature().empty()) {
     POP_LOCAL_JAVA_FRAME();
-    return v8::Undefined();
+    return scope.Close(self->m_java->callWithSignature(args, argsStart, argsEnd, args.This(), self->getClassName(), methodNameStr, callOptions, callback, callbackProvided));
   }
 
-  // run
-  InstanceMethodCallBaton* baton = new InstanceMethodCallBaton(self->m_java, self, method, methodArgs, callback);
-  baton->run();
+  MethodStats* stats = NULL;
+  if(self->m_java->getStats()->isEnabled() || traceEnabled()) {
+    stats = self->m_java->getStats()->get(self->getClassName(), methodNameStr);
+  }
+  uint64_t phaseStart = statsNow(stats);
+  V8ConversionPath conversionPath;
+  NativeValue* methodArgs = v8ToNative(env, args, argsStart, argsEnd, &conversionPath);
+  if(methodArgs == NULL) {
+    POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(conversionPath.getError()));
+  }
+  statsRecordPhase(stats, STATS_PHASE_ARGS, phaseStart);
+
+  // run, the method is found on the thread pool once the arguments are built there
+  InstanceMethodCallBaton* baton = new InstanceMethodCallBaton(self->m_java, self, NULL, NULL, callback);
+  baton->deferArgs(methodArgs, NULL, self->getClassName(), methodNameStr);
+  baton->setStats(stats);
+  baton->setCallOptions(callOptions);
+  bool queueHasCapacity = baton->run();
 
-  env->DeleteLocalRef(methodArgs);
-  env->DeleteLocalRef(method);
   POP_LOCAL_JAVA_FRAME();
 
+  if(!queueHasCapacity) {
+    return v8::False();
+  }
+
   END_CALLBACK_FUNCTION("\"Method '" << methodNameStr << "' called without a callback did you mean to use the Sync version?\"");
 }
 
@@ -147,10 +250,30 @@ JavaObject::~JavaObject() {
   int argsStart = 0;
   int argsEnd = args.Length();
 
-  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd);
+  // arguments
+  ARGS_BACK_CALL_OPTIONS();
+  if(callOptions && !callOptions->getSignature().empty()) {
+    POP_LOCAL_JAVA_FRAME();
+    return scope.Close(self->m_java->callWithSignature(args, argsStart, argsEnd, args.This(), self->getClassName(), methodNameStr, callOptions, v8::Undefined(), false));
+  }
+  SyncCallGuard syncCallGuard(self->m_java->getSyncWatchdog(), self, methodNameStr);
+
+  MethodStats* stats = NULL;
+  if(self->m_java->getStats()->isEnabled() || traceEnabled()) {
+    stats = self->m_java->getStats()->get(self->getClassName(), methodNameStr);
+  }
+  uint64_t phaseStart = statsNow(stats);
+  V8ConversionPath conversionPath;
+  jobjectArray methodArgs = v8ToJava(env, args, argsStart, argsEnd, &conversionPath);
+  if(methodArgs == NULL) {
+    POP_LOCAL_JAVA_FRAME_AND_RETURN(ThrowException(conversionPath.getError()));
+  }
+  phaseStart = statsRecordPhase(stats, STATS_PHASE_ARGS, phaseStart);
 
   jobject method = javaFindMethod(env, self->m_class, methodNameStr, methodArgs);
+  statsRecordPhase(stats, STATS_PHASE_RESOLVE, phaseStart);
   if(method == NULL) {
+    statsRecordCall(stats, true);
     std::ostringstream errStr;
     errStr << "Could not find method " << methodNameStr;
     v8::Handle<v8::Value> ex = javaExceptionToV8(env, errStr.str());
@@ -161,6 +284,8 @@ JavaObject::~JavaObject() {
   // run
   v8::Handle<v8::Value> callback = v8::Object::New();
   InstanceMethodCallBaton* baton = new InstanceMethodCallBaton(self->m_java, self, method, methodArgs, callback);
+  baton->setStats(stats);
+  baton->setCallOptions(callOptions);
   v8::Handle<v8::Value> result = baton->runSync();
   delete baton;
 
@@ -169,6 +294,69 @@ JavaObject::~JavaObject() {
   return scope.Close(result);
 }
 
+/*static*/ v8::Handle<v8::Value> JavaObject::memberGetter(v8::Local<v8::String> property, const v8::AccessorInfo& info) {
+  JavaObjectClass* objectClass = (JavaObjectClass*)v8::External::Unwrap(info.Data());
+  v8::String::Utf8Value propertyCStr(property);
+  std::string propertyStr = *propertyCStr;
+
+  std::map<std::string, v8::Persistent<v8::FunctionTemplate> >::iterator it = objectClass->methodTemplates.find(propertyStr);
+  if(it != objectClass->methodTemplates.end()) {
+    return it->second->GetFunction();
+  }
+
+  std::string methodName;
+  memberKind kind = javaObjectFindMember(objectClass, propertyStr, &methodName);
+  if(kind == MEMBER_FIELD) {
+    return fieldGetter(property, info);
+  }
+  if(kind == MEMBER_NONE) {
+    // not a java member, so the object's own properties and its prototype are looked at as usual
+    return v8::Handle<v8::Value>();
+  }
+
+  v8::HandleScope scope;
+  v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New(kind == MEMBER_METHOD_SYNC ? methodCallSync : methodCall, v8::String::New(methodName.c_str()));
+  objectClass->methodTemplates[propertyStr] = v8::Persistent<v8::FunctionTemplate>::New(t);
+  return scope.Close(t->GetFunction());
+}
+
+/*static*/ v8::Handle<v8::Value> JavaObject::memberSetter(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::AccessorInfo& info) {
+  JavaObjectClass* objectClass = (JavaObjectClass*)v8::External::Unwrap(info.Data());
+  v8::String::Utf8Value propertyCStr(property);
+  if(objectClass->fieldNames.find(*propertyCStr) == objectClass->fieldNames.end()) {
+    return v8::Handle<v8::Value>();
+  }
+  fieldSetter(property, value, info);
+  return value;
+}
+
+/*static*/ v8::Handle<v8::Integer> JavaObject::memberQuery(v8::Local<v8::String> property, const v8::AccessorInfo& info) {
+  JavaObjectClass* objectClass = (JavaObjectClass*)v8::External::Unwrap(info.Data());
+  v8::String::Utf8Value propertyCStr(property);
+  std::string methodName;
+  if(javaObjectFindMember(objectClass, *propertyCStr, &methodName) == MEMBER_NONE) {
+    return v8::Handle<v8::Integer>();
+  }
+  return v8::Integer::New(v8::None);
+}
+
+/*static*/ v8::Handle<v8::Array> JavaObject::memberEnumerator(const v8::AccessorInfo& info) {
+  v8::HandleScope scope;
+  JavaObjectClass* objectClass = (JavaObjectClass*)v8::External::Unwrap(info.Data());
+  v8::Local<v8::Array> result = v8::Array::New();
+  uint32_t i = 0;
+  for(std::set<std::string>::iterator it = objectClass->methodNames.begin(); it != objectClass->methodNames.end(); it++) {
+    if(objectClass->fieldNames.find(*it) == objectClass->fieldNames.end()) {
+      result->Set(i++, v8::String::New(it->c_str()));
+    }
+    result->Set(i++, v8::String::New((*it + "Sync").c_str()));
+  }
+  for(std::set<std::string>::iterator it = objectClass->fieldNames.begin(); it != objectClass->fieldNames.end(); it++) {
+    result->Set(i++, v8::String::New(it->c_str()));
+  }
+  return scope.Close(result);
+}
+
 /*static*/ v8::Handle<v8::Value> JavaObject::fieldGetter(v8::Local<v8::String> property, const v8::AccessorInfo& info) {
   v8::HandleScope scope;
   JavaObject* self = node::ObjectWrap::Unwrap<JavaObject>(info.This());
@@ -178,6 +366,7 @@ JavaObject::~JavaObject() {
 
   v8::String::AsciiValue propertyCStr(property);
   std::string propertyStr = *propertyCStr;
+  SyncCallGuard syncCallGuard(self->m_java->getSyncWatchdog(), self, propertyStr);
   jobject field = javaFindField(env, self->m_class, propertyStr);
   if(field == NULL) {
     std::ostringstream errStr;
@@ -200,7 +389,7 @@ JavaObject::~JavaObject() {
     return ThrowException(ex);
   }
 
-  v8::Handle<v8::Value> result = javaToV8(self->m_java, env, val);
+  v8::Handle<v8::Value> result = javaToV8(self->m_java, env, val, self->m_java->getConversionOptions());
 
   env->DeleteLocalRef(fieldClazz);
   env->DeleteLocalRef(field);
@@ -217,10 +406,17 @@ JavaObject::~JavaObject() {
 
   PUSH_LOCAL_JAVA_FRAME();
 
-  jobject newValue = v8ToJava(env, value);
+  V8ConversionPath conversionPath;
+  jobject newValue = v8ToJava(env, value, &conversionPath);
+  if(conversionPath.failed()) {
+    POP_LOCAL_JAVA_FRAME();
+    ThrowException(conversionPath.getError());
+    return;
+  }
 
   v8::String::AsciiValue propertyCStr(property);
   std::string propertyStr = *propertyCStr;
+  SyncCallGuard syncCallGuard(self->m_java->getSyncWatchdog(), self, propertyStr);
   jobject field = javaFindField(env, self->m_class, propertyStr);
   if(field == NULL) {
     std::ostringstream errStr;
@@ -6,16 +6,37 @@
 #include <node.h>
 #include <jni.h>
 #include <list>
+#include <map>
+#include <set>
+#include <string>
 #include "methodCallBaton.h"
 
 class Java;
 
+/*
+ * The member names of a java class and the template its objects are made from. It is built the first
+ * time an object of the class is wrapped and shared by every later one. The functions for a method
+ * are only made the first time the method is looked up on one of the objects.
+ */
+struct JavaObjectClass {
+  std::set<std::string> methodNames;
+  std::set<std::string> fieldNames;
+  v8::Persistent<v8::FunctionTemplate> objectTemplate;
+  std::map<std::string, v8::Persistent<v8::FunctionTemplate> > methodTemplates;
+};
+
 class JavaObject : public node::ObjectWrap {
 public:
   static void Init(v8::Handle<v8::Object> target);
   static v8::Local<v8::Object> New(Java* java, jobject obj);
+  static bool HasInstance(v8::Handle<v8::Value> val);
+  static void readMembers(JNIEnv* env, jclass clazz, std::set<std::string>* methodNames, std::set<std::string>* fieldNames);
+  static void addObjectClass(const std::string& className, const std::set<std::string>& methodNames, const std::set<std::string>& fieldNames);
 
   jobject getObject() { return m_obj; }
+  jclass getClass() { return m_class; }
+  const std::string& getClassName();
+  bool isDynamicProxy() { return m_proxyData != NULL; }
 
   void Ref() { node::ObjectWrap::Ref(); }
   void Unref() { node::ObjectWrap::Unref(); }
@@ -27,11 +48,20 @@ private:
   static v8::Handle<v8::Value> methodCallSync(const v8::Arguments& args);
   static v8::Handle<v8::Value> fieldGetter(v8::Local<v8::String> property, const v8::AccessorInfo& info);
   static void fieldSetter(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::AccessorInfo& info);
+  static JavaObjectClass* getObjectClass(JNIEnv* env, JavaObject* self);
+  static void initObjectClass(const std::string& className, JavaObjectClass* objectClass);
+  static v8::Handle<v8::Value> memberGetter(v8::Local<v8::String> property, const v8::AccessorInfo& info);
+  static v8::Handle<v8::Value> memberSetter(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::AccessorInfo& info);
+  static v8::Handle<v8::Integer> memberQuery(v8::Local<v8::String> property, const v8::AccessorInfo& info);
+  static v8::Handle<v8::Array> memberEnumerator(const v8::AccessorInfo& info);
 
   static v8::Persistent<v8::FunctionTemplate> s_ct;
+  static std::map<std::string, JavaObjectClass*> s_objectClasses;
   Java* m_java;
   jobject m_obj;
   jclass m_class;
+  DynamicProxyData* m_proxyData;
+  std::string m_className;
 };
 
 #endif
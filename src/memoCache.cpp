@@ -0,0 +1,183 @@
+#include "memoCache.h"
+#include <uv.h>
+#include <sstream>
+#include <iomanip>
+
+static uint64_t memoNowMs() {
+  return uv_hrtime() / 1000000;
+}
+
+MemoCache::MemoCache() {
+}
+
+MemoCache::~MemoCache() {
+  clear();
+}
+
+std::string MemoCache::methodKey(const std::string& className, const std::string& methodName) {
+  return className + "#" + methodName;
+}
+
+/*
+ * Memoizing a method that is already memoized changes its limits and drops what it has cached.
+ */
+void MemoCache::enable(const std::string& className, const std::string& methodName, size_t maxEntries, uint64_t ttlMs) {
+  std::string name = methodKey(className, methodName);
+  std::map<std::string, MemoMethod*>::iterator it = m_methods.find(name);
+  if(it != m_methods.end()) {
+    deleteMethod(it->second);
+    m_methods.erase(it);
+  }
+
+  MemoMethod* method = new MemoMethod();
+  method->maxEntries = maxEntries;
+  method->ttlMs = ttlMs;
+  method->hits = 0;
+  method->misses = 0;
+  method->evictions = 0;
+  method->expirations = 0;
+  m_methods[name] = method;
+}
+
+bool MemoCache::disable(const std::string& className, const std::string& methodName) {
+  std::map<std::string, MemoMethod*>::iterator it = m_methods.find(methodKey(className, methodName));
+  if(it == m_methods.end()) {
+    return false;
+  }
+  deleteMethod(it->second);
+  m_methods.erase(it);
+  return true;
+}
+
+void MemoCache::clear() {
+  for(std::map<std::string, MemoMethod*>::iterator it = m_methods.begin(); it != m_methods.end(); it++) {
+    deleteMethod(it->second);
+  }
+  m_methods.clear();
+}
+
+MemoMethod* MemoCache::findMethod(const std::string& className, const std::string& methodName) {
+  std::map<std::string, MemoMethod*>::iterator it = m_methods.find(methodKey(className, methodName));
+  return it == m_methods.end() ? NULL : it->second;
+}
+
+/*
+ * Integers and other numbers are told apart the same way v8ToJava tells Integer from Double, since
+ * they can pick different overloads. The key starts with the argument count so it is never empty.
+ * Returns false if an argument can not be part of a key.
+ */
+/*static*/ bool MemoCache::keyFor(const v8::Arguments& args, int start, int end, std::string* key) {
+  std::ostringstream result;
+  result << std::setprecision(17) << (end - start) << ";";
+  for(int i=start; i<end; i++) {
+    v8::Local<v8::Value> arg = args[i];
+    if(arg->IsNull() || arg->IsUndefined()) {
+      result << "n;";
+    } else if(arg->IsString()) {
+      v8::String::Utf8Value val(arg);
+      result << "s" << val.length() << ":";
+      result.write(*val, val.length());
+      result << ";";
+    } else if(arg->IsInt32() || arg->IsUint32()) {
+      result << "i" << arg->ToInt32()->Value() << ";";
+    } else if(arg->IsNumber()) {
+      result << "d" << arg->NumberValue() << ";";
+    } else if(arg->IsBoolean()) {
+      result << (arg->BooleanValue() ? "t;" : "f;");
+    } else {
+      return false;
+    }
+  }
+  *key = result.str();
+  return true;
+}
+
+/*
+ * Returns an empty handle on a miss.
+ */
+v8::Handle<v8::Value> MemoCache::get(MemoMethod* method, const std::string& key) {
+  std::map<std::string, std::list<MemoEntry*>::iterator>::iterator it = method->index.find(key);
+  if(it == method->index.end()) {
+    method->misses++;
+    return v8::Handle<v8::Value>();
+  }
+
+  MemoEntry* entry = *it->second;
+  if(entry->expires != 0 && memoNowMs() >= entry->expires) {
+    removeEntry(method, it->second);
+    method->index.erase(it);
+    method->expirations++;
+    method->misses++;
+    return v8::Handle<v8::Value>();
+  }
+
+  method->entries.splice(method->entries.begin(), method->entries, it->second);
+  method->hits++;
+  return entry->value;
+}
+
+/*
+ * Called with the result of a call that missed. The method is looked up again since it may have been
+ * unmemoized while an async call was running.
+ */
+void MemoCache::put(const std::string& className, const std::string& methodName, const std::string& key, v8::Handle<v8::Value> value) {
+  MemoMethod* method = findMethod(className, methodName);
+  if(method == NULL || method->maxEntries == 0) {
+    return;
+  }
+  if(!(value->IsNull() || value->IsUndefined() || value->IsString() || value->IsNumber() || value->IsBoolean())) {
+    return;
+  }
+
+  std::map<std::string, std::list<MemoEntry*>::iterator>::iterator it = method->index.find(key);
+  if(it != method->index.end()) {
+    removeEntry(method, it->second);
+    method->index.erase(it);
+  }
+  while(method->entries.size() >= method->maxEntries) {
+    std::list<MemoEntry*>::iterator last = method->entries.end();
+    last--;
+    method->index.erase((*last)->key);
+    removeEntry(method, last);
+    method->evictions++;
+  }
+
+  MemoEntry* entry = new MemoEntry();
+  entry->key = key;
+  entry->value = v8::Persistent<v8::Value>::New(value);
+  entry->expires = method->ttlMs == 0 ? 0 : memoNowMs() + method->ttlMs;
+  method->entries.push_front(entry);
+  method->index[key] = method->entries.begin();
+}
+
+/*static*/ void MemoCache::removeEntry(MemoMethod* method, std::list<MemoEntry*>::iterator it) {
+  MemoEntry* entry = *it;
+  entry->value.Dispose();
+  delete entry;
+  method->entries.erase(it);
+}
+
+/*static*/ void MemoCache::deleteMethod(MemoMethod* method) {
+  while(!method->entries.empty()) {
+    removeEntry(method, method->entries.begin());
+  }
+  delete method;
+}
+
+v8::Handle<v8::Object> MemoCache::toV8() {
+  v8::HandleScope scope;
+  v8::Local<v8::Object> result = v8::Object::New();
+  for(std::map<std::string, MemoMethod*>::iterator it = m_methods.begin(); it != m_methods.end(); it++) {
+    MemoMethod* method = it->second;
+    v8::Local<v8::Object> methodStats = v8::Object::New();
+    methodStats->Set(v8::String::New("size"), v8::Number::New((double)method->entries.size()));
+    methodStats->Set(v8::String::New("maxEntries"), v8::Number::New((double)method->maxEntries));
+    methodStats->Set(v8::String::New("ttl"), v8::Number::New((double)method->ttlMs));
+    methodStats->Set(v8::String::New("hits"), v8::Number::New((double)method->hits));
+    methodStats->Set(v8::String::New("misses"), v8::Number::New((double)method->misses));
+    methodStats->Set(v8::String::New("evictions"), v8::Number::New((double)method->evictions));
+    methodStats->Set(v8::String::New("expirations"), v8::Number::New((double)method->expirations));
+    result->Set(v8::String::New(it->first.c_str()), methodStats);
+  }
+  return scope.Close(result);
+}
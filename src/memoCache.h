@@ -0,0 +1,62 @@
+#ifndef _memocache_h_
+#define _memocache_h_
+
+#include <v8.h>
+#include <map>
+#include <list>
+#include <string>
+
+#define MEMO_DEFAULT_MAX_ENTRIES 1000
+
+struct MemoEntry {
+  std::string key;
+  v8::Persistent<v8::Value> value;
+  uint64_t expires;
+};
+
+/*
+ * The results cached for one memoized static method, least recently used first out once maxEntries
+ * is reached. Entries older than ttlMs are dropped when they are next looked up; a ttl of 0 keeps
+ * them until they are evicted.
+ */
+struct MemoMethod {
+  size_t maxEntries;
+  uint64_t ttlMs;
+  std::list<MemoEntry*> entries;
+  std::map<std::string, std::list<MemoEntry*>::iterator> index;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t expirations;
+};
+
+/*
+ * Results of static methods opted in with java.memoize, keyed by the javascript arguments of the call.
+ * Only calls whose arguments are all null, booleans, numbers or strings are cached, and only results
+ * of those same kinds are kept, so a hit hands back a value without building a java argument or
+ * entering the JVM. Everything happens on the v8 thread.
+ */
+class MemoCache {
+public:
+  MemoCache();
+  ~MemoCache();
+
+  void enable(const std::string& className, const std::string& methodName, size_t maxEntries, uint64_t ttlMs);
+  bool disable(const std::string& className, const std::string& methodName);
+  void clear();
+  bool empty() { return m_methods.empty(); }
+  MemoMethod* findMethod(const std::string& className, const std::string& methodName);
+  static bool keyFor(const v8::Arguments& args, int start, int end, std::string* key);
+  v8::Handle<v8::Value> get(MemoMethod* method, const std::string& key);
+  void put(const std::string& className, const std::string& methodName, const std::string& key, v8::Handle<v8::Value> value);
+  v8::Handle<v8::Object> toV8();
+
+private:
+  static std::string methodKey(const std::string& className, const std::string& methodName);
+  static void removeEntry(MemoMethod* method, std::list<MemoEntry*>::iterator it);
+  static void deleteMethod(MemoMethod* method);
+
+  std::map<std::string, MemoMethod*> m_methods;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "methodCache.h"
+#include "utils.h"
+
+MethodCache::MethodCache() {
+  uv_mutex_init(&m_mutex);
+  m_hits = 0;
+  m_misses = 0;
+  m_full = 0;
+}
+
+MethodCache::~MethodCache() {
+  // the JVM is never destroyed while the bridge is loaded, the refs go with the process
+  uv_mutex_destroy(&m_mutex);
+}
+
+/*
+ * The argument classes are the ones the arguments will have once built: v8ToJava boxes integers as
+ * Integer, other numbers as Double and plain objects as LinkedHashMap. Java objects use the class name
+ * their wrapper already knows, so only objects v8ValueToNative could not name, such as proxies, cost a
+ * Class.getName call. Calls with array arguments are not cached since resolving them can turn the
+ * arrays into lists.
+ */
+bool MethodCache::keyFor(JNIEnv* env, const std::string& className, const std::string& methodName, NativeValue* args, std::string* key) {
+  std::string result = className;
+  result += '#';
+  result += methodName;
+  for(std::vector<NativeValue*>::iterator it = args->items.begin(); it != args->items.end(); it++) {
+    result += ',';
+    switch((*it)->type) {
+      case NATIVE_NULL: result += "null"; break;
+      case NATIVE_BOOLEAN: result += "java.lang.Boolean"; break;
+      case NATIVE_INTEGER: result += "java.lang.Integer"; break;
+      case NATIVE_NUMBER: result += "java.lang.Double"; break;
+      case NATIVE_STRING: result += "java.lang.String"; break;
+      case NATIVE_MAP: result += "java.util.LinkedHashMap"; break;
+      case NATIVE_OBJECT:
+        if(!(*it)->stringValue.empty()) {
+          result += (*it)->stringValue;
+        } else {
+          jclass clazz = env->GetObjectClass((*it)->objectValue);
+          jstring name = (jstring)env->CallObjectMethod(clazz, javaConversionIds.class_getName);
+          result += javaToString(env, name);
+          env->DeleteLocalRef(name);
+          env->DeleteLocalRef(clazz);
+        }
+        break;
+      default:
+        return false;
+    }
+  }
+  *key = result;
+  return true;
+}
+
+jobject MethodCache::find(const std::string& key) {
+  uv_mutex_lock(&m_mutex);
+  jobject result = NULL;
+  std::map<std::string, jobject>::iterator it = m_methods.find(key);
+  if(it != m_methods.end()) {
+    result = it->second;
+    m_hits++;
+  } else {
+    m_misses++;
+  }
+  uv_mutex_unlock(&m_mutex);
+  return result;
+}
+
+/*
+ * Returns the cached global ref for key, which may have been added by another thread in the meantime,
+ * or NULL if the cache is full and the caller has to keep its own ref.
+ */
+jobject MethodCache::put(JNIEnv* env, const std::string& key, jobject method) {
+  uv_mutex_lock(&m_mutex);
+  jobject result = NULL;
+  std::map<std::string, jobject>::iterator it = m_methods.find(key);
+  if(it != m_methods.end()) {
+    result = it->second;
+  } else if(m_methods.size() < METHOD_CACHE_MAX_ENTRIES) {
+    result = refStatsNewGlobalRef(env, method, REF_SITE_METHOD);
+    m_methods[key] = result;
+  } else {
+    m_full++;
+  }
+  uv_mutex_unlock(&m_mutex);
+  return result;
+}
+
+v8::Handle<v8::Object> MethodCache::toV8() {
+  v8::HandleScope scope;
+  uv_mutex_lock(&m_mutex);
+  v8::Local<v8::Object> result = v8::Object::New();
+  result->Set(v8::String::New("size"), v8::Number::New((double)m_methods.size()));
+  result->Set(v8::String::New("hits"), v8::Number::New((double)m_hits));
+  result->Set(v8::String::New("misses"), v8::Number::New((double)m_misses));
+  result->Set(v8::String::New("full"), v8::Number::New((double)m_full));
+  uv_mutex_unlock(&m_mutex);
+  return scope.Close(result);
+}
@@ -0,0 +1,40 @@
+
+#ifndef _methodcache_h_
+#define _methodcache_h_
+
+#include <v8.h>
+#include <jni.h>
+#include <uv.h>
+#include <map>
+#include <string>
+#include "nativeValue.h"
+
+// entries beyond this are resolved every time instead of cached
+#define METHOD_CACHE_MAX_ENTRIES 4096
+
+/*
+ * Methods and constructors resolved for async calls, keyed by class, method name and the java class
+ * of each argument, so a call with the same argument types skips the overload search. Keys are built
+ * on the v8 thread from the argument snapshot, entries are added by worker threads once they have
+ * resolved a call, so the map is guarded by a mutex. Entries are never removed while the Java
+ * instance is alive, which lets batons borrow the cached global ref instead of taking their own.
+ */
+class MethodCache {
+public:
+  MethodCache();
+  ~MethodCache();
+
+  bool keyFor(JNIEnv* env, const std::string& className, const std::string& methodName, NativeValue* args, std::string* key);
+  jobject find(const std::string& key);
+  jobject put(JNIEnv* env, const std::string& key, jobject method);
+  v8::Handle<v8::Object> toV8();
+
+private:
+  uv_mutex_t m_mutex;
+  std::map<std::string, jobject> m_methods;
+  uint64_t m_hits;
+  uint64_t m_misses;
+  uint64_t m_full;
+};
+
+#endif
@@ -2,55 +2,388 @@
 #include "methodCallBaton.h"
 #include "java.h"
 #include "javaObject.h"
+#include "callOptions.h"
+#include <sstream>
+#include <string.h>
+
+#define MODIFIER_STATIC_ONLY 8
+
+// batons are pooled in size classes of BATON_POOL_GRANULARITY bytes, larger ones are not pooled
+#define BATON_POOL_GRANULARITY 64
+#define BATON_POOL_CLASSES 16
+#define BATON_POOL_MAX_FREE 1024
+
+static std::vector<void*> batonPoolFree[BATON_POOL_CLASSES];
+static uint64_t batonPoolReused = 0;
+static uint64_t batonPoolAllocated = 0;
 
 MethodCallBaton::MethodCallBaton(Java* java, jobject method, jarray args, v8::Handle<v8::Value>& callback) {
   JNIEnv *env = java->getJavaEnv();
 
   m_java = java;
-  m_args = (jarray)env->NewGlobalRef(args);
+  m_args = (jarray)refStatsNewGlobalRef(env, args, REF_SITE_BATON);
   m_callback = v8::Persistent<v8::Value>::New(callback);
-  m_method = env->NewGlobalRef(method);
+  m_method = refStatsNewGlobalRef(env, method, REF_SITE_BATON);
+  m_localArgs = false;
   m_error = NULL;
   m_result = NULL;
+  m_nativeArgs = NULL;
+  m_clazz = NULL;
+  m_methodBorrowed = false;
+  m_priority = CALL_PRIORITY_NORMAL;
+  m_queuedTime = 0;
+  m_callOptions = NULL;
+  m_timeoutTimer = NULL;
+  uv_mutex_init(&m_stateMutex);
+  m_state = BATON_STATE_QUEUED;
+  m_cancelled = false;
+  m_workerThread = NULL;
+  m_conversionOptions = java->getConversionOptions();
+  m_nativeResult = NULL;
+  m_stats = NULL;
+  m_convertNs = 0;
 }
 
 MethodCallBaton::~MethodCallBaton() {
   JNIEnv *env = m_java->getJavaEnv();
-  env->DeleteGlobalRef(m_args);
-  env->DeleteGlobalRef(m_method);
+  if(!m_localArgs) {
+    refStatsDeleteGlobalRef(env, m_args, REF_SITE_BATON);
+  }
+  if(!m_methodBorrowed) {
+    refStatsDeleteGlobalRef(env, m_method, REF_SITE_BATON);
+  }
+  refStatsDeleteGlobalRef(env, m_clazz, REF_SITE_BATON);
+  deleteNativeValue(env, m_nativeArgs);
+  m_callback.Dispose();
+  stopTimeout();
+  if(m_callOptions) {
+    m_callOptions->removeBaton(this);
+    m_callOptions->Unref();
+  }
+  uv_mutex_destroy(&m_stateMutex);
+}
+
+void MethodCallBaton::setCallOptions(CallOptions* callOptions) {
+  if(callOptions == NULL) {
+    return;
+  }
+  m_priority = callOptions->getPriority();
+  m_callOptions = callOptions;
+  m_callOptions->Ref();
+  m_callOptions->addBaton(this);
+  if(callOptions->hasConversionOptions()) {
+    m_conversionOptions = callOptions->getConversionOptions();
+  }
+}
+
+/*
+ * Batons are only created and deleted on the v8 thread, so the free lists need no locking. Memory
+ * handed back to a full free list goes back to the allocator.
+ */
+/*static*/ void* MethodCallBaton::operator new(size_t size) {
+  size_t sizeClass = (size + BATON_POOL_GRANULARITY - 1) / BATON_POOL_GRANULARITY;
+  if(sizeClass < BATON_POOL_CLASSES && !batonPoolFree[sizeClass].empty()) {
+    void* ptr = batonPoolFree[sizeClass].back();
+    batonPoolFree[sizeClass].pop_back();
+    batonPoolReused++;
+    return ptr;
+  }
+  batonPoolAllocated++;
+  if(sizeClass < BATON_POOL_CLASSES) {
+    return ::operator new(sizeClass * BATON_POOL_GRANULARITY);
+  }
+  return ::operator new(size);
+}
+
+/*static*/ void MethodCallBaton::operator delete(void* ptr, size_t size) {
+  size_t sizeClass = (size + BATON_POOL_GRANULARITY - 1) / BATON_POOL_GRANULARITY;
+  if(sizeClass < BATON_POOL_CLASSES && batonPoolFree[sizeClass].size() < BATON_POOL_MAX_FREE) {
+    batonPoolFree[sizeClass].push_back(ptr);
+    return;
+  }
+  ::operator delete(ptr);
+}
+
+/*static*/ v8::Handle<v8::Object> MethodCallBaton::poolStatsToV8() {
+  v8::HandleScope scope;
+  size_t pooled = 0;
+  for(int i=0; i<BATON_POOL_CLASSES; i++) {
+    pooled += batonPoolFree[i].size();
+  }
+  v8::Local<v8::Object> result = v8::Object::New();
+  result->Set(v8::String::New("reused"), v8::Number::New((double)batonPoolReused));
+  result->Set(v8::String::New("allocated"), v8::Number::New((double)batonPoolAllocated));
+  result->Set(v8::String::New("pooled"), v8::Number::New((double)pooled));
+  return scope.Close(result);
+}
+
+/*
+ * Async calls snapshot their arguments on the v8 thread and leave building the java arguments, and
+ * finding the method that fits them, to the thread the call runs on. Batons given deferred arguments
+ * are created with a NULL method and NULL args. When the method cache already knows the method for
+ * these argument types the baton borrows it, and needs no ref to the class either.
+ */
+void MethodCallBaton::deferArgs(NativeValue* args, jclass clazz, const std::string& className, const std::string& methodName) {
+  JNIEnv *env = m_java->getJavaEnv();
+  MethodCache* methodCache = m_java->getMethodCache();
+  m_nativeArgs = args;
+  m_className = className;
+  m_methodName = methodName;
+  if(methodCache->keyFor(env, className, methodName, args, &m_methodKey)) {
+    m_method = methodCache->find(m_methodKey);
+    if(m_method) {
+      m_methodBorrowed = true;
+      return;
+    }
+  }
+  m_clazz = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_BATON);
+}
+
+/*
+ * Returns false, with m_error or m_failure set, if no method fits the arguments. The arguments are
+ * left as a local ref of the frame the call runs in, since nothing uses them once it returns.
+ */
+bool MethodCallBaton::prepare(JNIEnv *env) {
+  if(m_nativeArgs == NULL) {
+    return true;
+  }
+
+  m_args = nativeToJavaArgs(env, m_nativeArgs);
+  m_localArgs = true;
+  deleteNativeValue(env, m_nativeArgs);
+  m_nativeArgs = NULL;
+  if(m_method) {
+    return true;
+  }
+
+  jobject method = resolveMethod(env);
+  if(method == NULL) {
+    jthrowable err = env->ExceptionOccurred();
+    if(err) {
+      m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+      m_errorString = m_failure;
+      m_failure.clear();
+      env->ExceptionClear();
+      env->DeleteLocalRef(err);
+    }
+    return false;
+  }
+  if(!m_methodKey.empty()) {
+    m_method = m_java->getMethodCache()->put(env, m_methodKey, method);
+    m_methodBorrowed = (m_method != NULL);
+  }
+  if(m_method == NULL) {
+    m_method = refStatsNewGlobalRef(env, method, REF_SITE_BATON);
+  }
+  env->DeleteLocalRef(method);
+  return true;
+}
+
+/*
+ * Cancels an async call. A call still waiting in the scheduler is dropped and freed right away. A
+ * call already handed to the thread pool has its worker thread interrupted; the baton is freed,
+ * along with its java refs, once the worker returns. Either way the callback gets its error on the
+ * next turn of the event loop, so no javascript runs while the caller is still walking its batons.
+ */
+void MethodCallBaton::cancel(const char* message, const char* code) {
+  if(m_cancelled) {
+    return;
+  }
+
+  uv_mutex_lock(&m_stateMutex);
+  if(m_state == BATON_STATE_DONE) {
+    // the result is already waiting for EIO_AfterMethodCall
+    uv_mutex_unlock(&m_stateMutex);
+    return;
+  }
+  m_cancelled = true;
+  batonState state = m_state;
+  if(state == BATON_STATE_RUNNING && m_workerThread) {
+    JNIEnv *env = m_java->getJavaEnv();
+    jclass threadClazz = env->FindClass("java/lang/Thread");
+    jmethodID thread_interrupt = env->GetMethodID(threadClazz, "interrupt", "()V");
+    env->CallVoidMethod(m_workerThread, thread_interrupt);
+    env->DeleteLocalRef(threadClazz);
+  }
+  uv_mutex_unlock(&m_stateMutex);
+
+  stopTimeout();
+  deferCallbackWithError(message, code);
   m_callback.Dispose();
+  m_callback.Clear();
+
+  if(state == BATON_STATE_QUEUED) {
+    m_java->getScheduler()->cancel(this);
+    delete this;
+  }
+}
+
+void MethodCallBaton::deferCallbackWithError(const char* message, const char* code) {
+  if(!m_callback->IsFunction()) {
+    return;
+  }
+  v8::HandleScope scope;
+  v8::Local<v8::Value> error = v8::Exception::Error(v8::String::New(message));
+  error->ToObject()->Set(v8::String::New("code"), v8::String::New(code));
+  m_java->deferCallback(m_callback, error, v8::Undefined());
+}
+
+void MethodCallBaton::startTimeout() {
+  if(m_callOptions == NULL || m_callOptions->getTimeout() <= 0) {
+    return;
+  }
+  m_timeoutTimer = new uv_timer_t();
+  m_timeoutTimer->data = this;
+  uv_timer_init(uv_default_loop(), m_timeoutTimer);
+  uv_timer_start(m_timeoutTimer, onTimeout, (int64_t)m_callOptions->getTimeout(), 0);
 }
 
-void MethodCallBaton::run() {
-  uv_work_t* req = new uv_work_t();
-  req->data = this;
-  uv_queue_work(uv_default_loop(), req, MethodCallBaton::EIO_MethodCall, MethodCallBaton::EIO_AfterMethodCall);
+void onTimeoutTimerClose(uv_handle_t* handle) {
+  delete (uv_timer_t*)handle;
+}
+
+void MethodCallBaton::stopTimeout() {
+  if(m_timeoutTimer == NULL) {
+    return;
+  }
+  uv_timer_stop(m_timeoutTimer);
+  m_timeoutTimer->data = NULL;
+  uv_close((uv_handle_t*)m_timeoutTimer, onTimeoutTimerClose);
+  m_timeoutTimer = NULL;
+}
+
+/*static*/ void MethodCallBaton::onTimeout(uv_timer_t* handle, int status) {
+  MethodCallBaton* self = static_cast<MethodCallBaton*>(handle->data);
+  if(self == NULL) {
+    return;
+  }
+  std::ostringstream errStr;
+  errStr << "Call timed out after " << self->m_callOptions->getTimeout() << "ms";
+  self->cancel(errStr.str().c_str(), "ETIMEDOUT");
+}
+
+/*
+ * Hands the baton to the Java instance's scheduler. Returns false if the caller should back off,
+ * either because the queue is over its limit or because the call was rejected. A rejected baton
+ * has been deleted, and its callback gets an EQUEUEFULL error on the next turn of the event loop.
+ */
+bool MethodCallBaton::run() {
+  schedulerSubmitResult submitResult = m_java->getScheduler()->submit(this, m_priority);
+  if(submitResult == SUBMIT_REJECTED) {
+    deferCallbackWithError("Async call queue is full", "EQUEUEFULL");
+    delete this;
+    return false;
+  }
+  startTimeout();
+  return submitResult == SUBMIT_OK;
+}
+
+void MethodCallBaton::queueWork() {
+  m_state = BATON_STATE_DISPATCHED;
+  m_req.data = this;
+  uv_queue_work(uv_default_loop(), &m_req, MethodCallBaton::EIO_MethodCall, MethodCallBaton::EIO_AfterMethodCall);
 }
 
 v8::Handle<v8::Value> MethodCallBaton::runSync() {
   JNIEnv *env = m_java->getJavaEnv();
-  execute(env);
-  return resultsToV8(env);
+  uint64_t phaseStart = statsNow(m_stats);
+  PUSH_LOCAL_JAVA_FRAME_SIZED(LOCAL_FRAME_SIZE_SMALL);
+  if(prepare(env)) {
+    execute(env);
+  }
+  phaseStart = statsRecordPhase(m_stats, STATS_PHASE_EXECUTE, phaseStart);
+  statsRecordCall(m_stats, m_error != NULL || !m_failure.empty());
+  convertResults(env);
+  POP_LOCAL_JAVA_FRAME();
+  v8::Handle<v8::Value> result = resultsToV8(env);
+  discardResults(env);
+  statsRecordPhase(m_stats, STATS_PHASE_RESULTS, phaseStart);
+  return result;
 }
 
 /*static*/ void MethodCallBaton::EIO_MethodCall(uv_work_t* req) {
   MethodCallBaton* self = static_cast<MethodCallBaton*>(req->data);
   JNIEnv *env = javaAttachCurrentThread(self->m_java->getJvm());
-  self->execute(env);
+  if(traceEnabled()) {
+    traceSetThreadName("threadpool");
+  }
+
+  // only calls that can be cancelled need to know which java thread they run on
+  jobject workerThread = NULL;
+  if(self->m_callOptions) {
+    jclass threadClazz = env->FindClass("java/lang/Thread");
+    jmethodID thread_currentThread = env->GetStaticMethodID(threadClazz, "currentThread", "()Ljava/lang/Thread;");
+    workerThread = env->CallStaticObjectMethod(threadClazz, thread_currentThread);
+    env->DeleteLocalRef(threadClazz);
+  }
+
+  uv_mutex_lock(&self->m_stateMutex);
+  if(self->m_cancelled) {
+    uv_mutex_unlock(&self->m_stateMutex);
+    javaDetachCurrentThread(self->m_java->getJvm());
+    return;
+  }
+  self->m_state = BATON_STATE_RUNNING;
+  if(workerThread) {
+    self->m_workerThread = refStatsNewGlobalRef(env, workerThread, REF_SITE_BATON);
+  }
+  uv_mutex_unlock(&self->m_stateMutex);
+
+  uint64_t phaseStart = statsRecordPhase(self->m_stats, STATS_PHASE_QUEUE, self->m_queuedTime);
+  PUSH_LOCAL_JAVA_FRAME_SIZED(LOCAL_FRAME_SIZE_SMALL);
+  if(self->m_nativeArgs) {
+    bool prepared = self->prepare(env);
+    phaseStart = statsRecordPhase(self->m_stats, STATS_PHASE_RESOLVE, phaseStart);
+    if(prepared) {
+      self->execute(env);
+    }
+  } else {
+    self->execute(env);
+  }
+  phaseStart = statsRecordPhase(self->m_stats, STATS_PHASE_EXECUTE, phaseStart);
+  self->convertResults(env);
+  if(self->m_stats) {
+    uint64_t now = uv_hrtime();
+    self->m_convertNs = now - phaseStart;
+    traceComplete("call", "convert", self->m_stats->key.c_str(), phaseStart, now);
+  }
+  POP_LOCAL_JAVA_FRAME();
+
+  uv_mutex_lock(&self->m_stateMutex);
+  self->m_state = BATON_STATE_DONE;
+  if(self->m_workerThread) {
+    refStatsDeleteGlobalRef(env, self->m_workerThread, REF_SITE_BATON);
+    self->m_workerThread = NULL;
+  }
+  uv_mutex_unlock(&self->m_stateMutex);
+
   javaDetachCurrentThread(self->m_java->getJvm());
 }
 
 /*static*/ void MethodCallBaton::EIO_AfterMethodCall(uv_work_t* req) {
   MethodCallBaton* self = static_cast<MethodCallBaton*>(req->data);
   JNIEnv *env = self->m_java->getJavaEnv();
-  self->after(env);
-  delete req;
+  if(self->m_cancelled) {
+    statsRecordCall(self->m_stats, true);
+    self->discardResults(env);
+  } else {
+    self->stopTimeout();
+    self->after(env);
+  }
+  self->m_java->getScheduler()->completed(self);
   delete self;
 }
 
 void MethodCallBaton::after(JNIEnv *env) {
+  statsRecordCall(m_stats, m_error != NULL || !m_failure.empty());
   if(m_callback->IsFunction()) {
+    uint64_t phaseStart = statsNow(m_stats);
     v8::Handle<v8::Value> result = resultsToV8(env);
+    if(m_stats) {
+      uint64_t now = uv_hrtime();
+      statsRecordDuration(m_stats, STATS_PHASE_RESULTS, m_convertNs + (now - phaseStart));
+      traceComplete("call", "results", m_stats->key.c_str(), phaseStart, now);
+    }
     v8::Handle<v8::Value> argv[2];
     if(result->IsNativeError()) {
       argv[0] = result;
@@ -62,8 +395,34 @@ void MethodCallBaton::after(JNIEnv *env) {
     v8::Function::Cast(*m_callback)->Call(v8::Context::GetCurrent()->Global(), 2, argv);
   }
 
+  discardResults(env);
+}
+
+/*
+ * Deep conversion of collections is done here, on the worker thread for async calls, so that only
+ * building the v8 values is left for the v8 thread.
+ */
+void MethodCallBaton::convertResults(JNIEnv *env) {
+  if(m_error || m_result == NULL || !m_conversionOptions.collections) {
+    return;
+  }
+  PUSH_LOCAL_JAVA_FRAME_SIZED(javaToNativeFrameSize(m_conversionOptions));
+  m_nativeResult = javaToNative(env, m_result, m_conversionOptions, 0);
+  POP_LOCAL_JAVA_FRAME();
+}
+
+void MethodCallBaton::discardResults(JNIEnv *env) {
+  if(m_nativeResult) {
+    deleteNativeValue(env, m_nativeResult);
+    m_nativeResult = NULL;
+  }
+  if(m_error) {
+    refStatsDeleteGlobalRef(env, m_error, REF_SITE_BATON);
+    m_error = NULL;
+  }
   if(m_result) {
-    env->DeleteGlobalRef(m_result);
+    refStatsDeleteGlobalRef(env, m_result, REF_SITE_BATON);
+    m_result = NULL;
   }
 }
 
@@ -72,10 +431,22 @@ v8::Handle<v8::Value> MethodCallBaton::resultsToV8(JNIEnv *env) {
 
   if(m_error) {
     v8::Handle<v8::Value> err = javaExceptionToV8(env, m_error, m_errorString);
-    env->DeleteGlobalRef(m_error);
+    refStatsDeleteGlobalRef(env, m_error, REF_SITE_BATON);
+    m_error = NULL;
     return scope.Close(err);
   }
 
+  if(!m_failure.empty()) {
+    return scope.Close(javaExceptionToV8(env, m_failure));
+  }
+
+  if(m_nativeResult) {
+    v8::Handle<v8::Value> result = nativeToV8(m_java, env, m_nativeResult, m_conversionOptions);
+    deleteNativeValue(env, m_nativeResult);
+    m_nativeResult = NULL;
+    return scope.Close(result);
+  }
+
   return scope.Close(javaToV8(m_java, env, m_result));
 }
 
@@ -88,13 +459,13 @@ void NewInstanceBaton::execute(JNIEnv *env) {
   jobject result = env->CallObjectMethod(m_method, constructor_newInstance, m_args);
   jthrowable err = env->ExceptionOccurred();
   if(err) {
-    m_error = (jthrowable)env->NewGlobalRef(err);
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
     m_errorString = "Error creating class";
     env->ExceptionClear();
     return;
   }
 
-  m_result = env->NewGlobalRef(result);
+  m_result = refStatsNewGlobalRef(env, result, REF_SITE_BATON);
 }
 
 void StaticMethodCallBaton::execute(JNIEnv *env) {
@@ -113,13 +484,13 @@ void StaticMethodCallBaton::execute(JNIEnv *env) {
 
   jthrowable err = env->ExceptionOccurred();
   if(err) {
-    m_error = (jthrowable)env->NewGlobalRef(err);
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
     m_errorString = "Error running static method";
     env->ExceptionClear();
     return;
   }
 
-  m_result = env->NewGlobalRef(result);
+  m_result = refStatsNewGlobalRef(env, result, REF_SITE_BATON);
 }
 
 void InstanceMethodCallBaton::execute(JNIEnv *env) {
@@ -140,44 +511,73 @@ void InstanceMethodCallBaton::execute(JNIEnv *env) {
 
   jthrowable err = env->ExceptionOccurred();
   if(err) {
-    m_error = (jthrowable)env->NewGlobalRef(err);
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
     m_errorString = "Error running instance method";
     env->ExceptionClear();
     return;
   }
 
-  m_result = env->NewGlobalRef(result);
+  m_result = refStatsNewGlobalRef(env, result, REF_SITE_BATON);
   env->DeleteLocalRef(result);
 }
 
+jobject NewInstanceBaton::resolveMethod(JNIEnv *env) {
+  jobject method = javaFindConstructor(env, m_clazz, (jobjectArray)m_args);
+  if(method == NULL) {
+    m_failure = "Could not find constructor for class " + m_className;
+  }
+  return method;
+}
+
+jobject StaticMethodCallBaton::resolveMethod(JNIEnv *env) {
+  jobject method = javaFindMethod(env, m_clazz, m_methodName, (jobjectArray)m_args);
+  if(method == NULL) {
+    m_failure = "Could not find method \"" + m_methodName + "\"";
+  }
+  return method;
+}
+
+jobject InstanceMethodCallBaton::resolveMethod(JNIEnv *env) {
+  jobject method = javaFindMethod(env, m_javaObject->getClass(), m_methodName, (jobjectArray)m_args);
+  if(method == NULL) {
+    m_failure = "Could not find method " + m_methodName;
+  }
+  return method;
+}
+
 NewInstanceBaton::NewInstanceBaton(
   Java* java,
-  jclass clazz,
   jobject method,
   jarray args,
   v8::Handle<v8::Value>& callback) : MethodCallBaton(java, method, args, callback) {
-  JNIEnv *env = m_java->getJavaEnv();
-  m_clazz = (jclass)env->NewGlobalRef(clazz);
 }
 
 NewInstanceBaton::~NewInstanceBaton() {
-  JNIEnv *env = m_java->getJavaEnv();
-  env->DeleteGlobalRef(m_clazz);
 }
 
 StaticMethodCallBaton::StaticMethodCallBaton(
   Java* java,
-  jclass clazz,
   jobject method,
   jarray args,
   v8::Handle<v8::Value>& callback) : MethodCallBaton(java, method, args, callback) {
-  JNIEnv *env = m_java->getJavaEnv();
-  m_clazz = (jclass)env->NewGlobalRef(clazz);
 }
 
 StaticMethodCallBaton::~StaticMethodCallBaton() {
-  JNIEnv *env = m_java->getJavaEnv();
-  env->DeleteGlobalRef(m_clazz);
+}
+
+void StaticMethodCallBaton::setMemoKey(const std::string& className, const std::string& methodName, const std::string& memoKey) {
+  m_className = className;
+  m_methodName = methodName;
+  m_memoKey = memoKey;
+}
+
+v8::Handle<v8::Value> StaticMethodCallBaton::resultsToV8(JNIEnv *env) {
+  v8::HandleScope scope;
+  v8::Handle<v8::Value> result = MethodCallBaton::resultsToV8(env);
+  if(!m_memoKey.empty() && !result->IsNativeError()) {
+    m_java->getMemoCache()->put(m_className, m_methodName, m_memoKey, result);
+  }
+  return scope.Close(result);
 }
 
 InstanceMethodCallBaton::InstanceMethodCallBaton(
@@ -193,3 +593,644 @@ InstanceMethodCallBaton::InstanceMethodCallBaton(
 InstanceMethodCallBaton::~InstanceMethodCallBaton() {
   m_javaObject->Unref();
 }
+
+StreamReadBaton::StreamReadBaton(
+  Java* java,
+  JavaObject* obj,
+  streamKind kind,
+  jint maxCount,
+  v8::Handle<v8::Value>& callback) : MethodCallBaton(java, NULL, NULL, callback) {
+  m_javaObject = obj;
+  m_javaObject->Ref();
+  m_kind = kind;
+  m_maxCount = maxCount;
+  m_eof = false;
+}
+
+StreamReadBaton::~StreamReadBaton() {
+  m_javaObject->Unref();
+}
+
+void StreamReadBaton::execute(JNIEnv *env) {
+  jobject obj = m_javaObject->getObject();
+  switch(m_kind) {
+    case STREAM_KIND_INPUT_STREAM: readInputStream(env, obj); break;
+    case STREAM_KIND_READER: readReader(env, obj); break;
+    case STREAM_KIND_ITERATOR: readIterator(env, obj); break;
+  }
+
+  jthrowable err = env->ExceptionOccurred();
+  if(err) {
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+    m_errorString = "Error reading stream";
+    env->ExceptionClear();
+    env->DeleteLocalRef(err);
+  }
+}
+
+/*
+ * Keeps reading while the stream says more data is available without blocking, so a chunk is
+ * filled in one pass instead of one read per JNI call from javascript.
+ */
+void StreamReadBaton::readInputStream(JNIEnv *env, jobject stream) {
+  JavaConversionIds* ids = &javaConversionIds;
+  jbyteArray buffer = env->NewByteArray(m_maxCount);
+  jint total = 0;
+  while(total < m_maxCount) {
+    jint count = env->CallIntMethod(stream, ids->inputStream_read, buffer, total, m_maxCount - total);
+    if(env->ExceptionCheck()) {
+      break;
+    }
+    if(count < 0) {
+      m_eof = true;
+      break;
+    }
+    total += count;
+    if(env->CallIntMethod(stream, ids->inputStream_available) <= 0 || env->ExceptionCheck()) {
+      break;
+    }
+  }
+  if(total > 0 && !env->ExceptionCheck()) {
+    m_bytes.resize(total);
+    env->GetByteArrayRegion(buffer, 0, total, (jbyte*)&m_bytes[0]);
+  }
+  env->DeleteLocalRef(buffer);
+}
+
+void StreamReadBaton::readReader(JNIEnv *env, jobject reader) {
+  JavaConversionIds* ids = &javaConversionIds;
+  jcharArray buffer = env->NewCharArray(m_maxCount);
+  jint total = 0;
+  while(total < m_maxCount) {
+    jint count = env->CallIntMethod(reader, ids->reader_read, buffer, total, m_maxCount - total);
+    if(env->ExceptionCheck()) {
+      break;
+    }
+    if(count < 0) {
+      m_eof = true;
+      break;
+    }
+    total += count;
+    if(!env->CallBooleanMethod(reader, ids->reader_ready) || env->ExceptionCheck()) {
+      break;
+    }
+  }
+  if(total > 0 && !env->ExceptionCheck()) {
+    m_chars.resize(total);
+    env->GetCharArrayRegion(buffer, 0, total, (jchar*)&m_chars[0]);
+  }
+  env->DeleteLocalRef(buffer);
+}
+
+void StreamReadBaton::readIterator(JNIEnv *env, jobject iterator) {
+  JavaConversionIds* ids = &javaConversionIds;
+  ConversionOptions options = m_conversionOptions;
+  if(!options.collections) {
+    // only strings and boxed primitives are converted ahead, everything else is wrapped as usual
+    options.maxDepth = 0;
+  }
+  NativeValue* items = new NativeValue();
+  items->type = NATIVE_ARRAY;
+  items->objectValue = NULL;
+  for(jint i=0; i<m_maxCount; i++) {
+    jboolean hasNext = env->CallBooleanMethod(iterator, ids->iterator_hasNext);
+    if(env->ExceptionCheck()) {
+      break;
+    }
+    if(!hasNext) {
+      m_eof = true;
+      break;
+    }
+    jobject item = env->CallObjectMethod(iterator, ids->iterator_next);
+    if(env->ExceptionCheck()) {
+      break;
+    }
+    PUSH_LOCAL_JAVA_FRAME_SIZED(javaToNativeFrameSize(options));
+    NativeValue* converted = javaToNative(env, item, options, 0);
+    POP_LOCAL_JAVA_FRAME();
+    env->DeleteLocalRef(item);
+    if(converted->type == NATIVE_ERROR) {
+      // the items read so far are dropped along with the failed one
+      deleteNativeValue(env, items);
+      m_nativeResult = converted;
+      return;
+    }
+    items->items.push_back(converted);
+  }
+
+  if(items->items.size() == 0 && m_eof) {
+    deleteNativeValue(env, items);
+    return;
+  }
+  m_nativeResult = items;
+}
+
+v8::Handle<v8::Value> StreamReadBaton::resultsToV8(JNIEnv *env) {
+  v8::HandleScope scope;
+
+  if(m_error || m_kind == STREAM_KIND_ITERATOR) {
+    return scope.Close(MethodCallBaton::resultsToV8(env));
+  }
+
+  if(m_kind == STREAM_KIND_READER) {
+    if(m_chars.size() == 0) {
+      return v8::Null();
+    }
+    return scope.Close(v8::String::New(&m_chars[0], m_chars.size()));
+  }
+
+  if(m_bytes.size() == 0) {
+    return v8::Null();
+  }
+  return scope.Close(bytesToV8Buffer(&m_bytes[0], m_bytes.size()));
+}
+
+StreamWriteBaton::StreamWriteBaton(
+  Java* java,
+  JavaObject* obj,
+  v8::Handle<v8::Value>& callback) : MethodCallBaton(java, NULL, NULL, callback) {
+  m_javaObject = obj;
+  m_javaObject->Ref();
+}
+
+StreamWriteBaton::~StreamWriteBaton() {
+  m_javaObject->Unref();
+}
+
+void StreamWriteBaton::append(const char* data, size_t length) {
+  m_bytes.insert(m_bytes.end(), data, data + length);
+}
+
+void StreamWriteBaton::execute(JNIEnv *env) {
+  if(m_bytes.size() == 0) {
+    return;
+  }
+
+  jint length = (jint)m_bytes.size();
+  jbyteArray buffer = env->NewByteArray(length);
+  if(buffer == NULL) {
+    m_error = (jthrowable)refStatsNewGlobalRef(env, env->ExceptionOccurred(), REF_SITE_BATON);
+    m_errorString = "Could not allocate write buffer";
+    env->ExceptionClear();
+    return;
+  }
+  env->SetByteArrayRegion(buffer, 0, length, (jbyte*)&m_bytes[0]);
+  env->CallVoidMethod(m_javaObject->getObject(), javaConversionIds.outputStream_write, buffer, 0, length);
+  env->DeleteLocalRef(buffer);
+
+  jthrowable err = env->ExceptionOccurred();
+  if(err) {
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+    m_errorString = "Error writing stream";
+    env->ExceptionClear();
+    env->DeleteLocalRef(err);
+  }
+}
+
+PipelineBaton::PipelineBaton(Java* java, v8::Handle<v8::Value>& callback) : MethodCallBaton(java, NULL, NULL, callback) {
+}
+
+PipelineBaton::~PipelineBaton() {
+  JNIEnv *env = m_java->getJavaEnv();
+  for(std::vector<PipelineStep>::iterator it = m_steps.begin(); it != m_steps.end(); it++) {
+    refStatsDeleteGlobalRef(env, it->clazz, REF_SITE_BATON);
+    refStatsDeleteGlobalRef(env, it->target, REF_SITE_BATON);
+    deleteNativeValue(env, it->args);
+  }
+  for(std::vector<jobject>::iterator it = m_keptResults.begin(); it != m_keptResults.end(); it++) {
+    refStatsDeleteGlobalRef(env, *it, REF_SITE_BATON);
+  }
+}
+
+/*
+ * Steps come from the builder in lib/nodeJavaBridge.js as { type, className, methodName, target,
+ * targetStep, args, argRefs }. Returns false with error set, and possibly a java exception pending,
+ * if the step is malformed or its class can not be found.
+ */
+bool PipelineBaton::addStep(JNIEnv *env, v8::Local<v8::Object> stepObj, std::string& error) {
+  PipelineStep step;
+  int index = (int)m_steps.size();
+  std::ostringstream errStr;
+
+  v8::String::AsciiValue type(stepObj->Get(v8::String::New("type")));
+  v8::String::AsciiValue className(stepObj->Get(v8::String::New("className")));
+  v8::String::AsciiValue methodName(stepObj->Get(v8::String::New("methodName")));
+  step.className = *className;
+  step.methodName = *methodName;
+  step.clazz = NULL;
+  step.target = NULL;
+  step.targetStep = -1;
+  step.args = NULL;
+  if(strcmp(*type, "static") == 0) {
+    step.type = PIPELINE_STEP_STATIC;
+  } else if(strcmp(*type, "new") == 0) {
+    step.type = PIPELINE_STEP_NEW;
+    step.methodName = "<init>";
+  } else if(strcmp(*type, "method") == 0) {
+    step.type = PIPELINE_STEP_METHOD;
+  } else {
+    errStr << "Step " << index << " has an unknown type " << *type;
+    error = errStr.str();
+    return false;
+  }
+
+  if(step.type == PIPELINE_STEP_METHOD) {
+    v8::Local<v8::Value> target = stepObj->Get(v8::String::New("target"));
+    v8::Local<v8::Value> targetStep = stepObj->Get(v8::String::New("targetStep"));
+    if(JavaObject::HasInstance(target)) {
+      JavaObject* javaObject = node::ObjectWrap::Unwrap<JavaObject>(target->ToObject());
+      step.target = refStatsNewGlobalRef(env, javaObject->getObject(), REF_SITE_BATON);
+    } else if(targetStep->IsNumber() && targetStep->Int32Value() >= 0 && targetStep->Int32Value() < index) {
+      step.targetStep = targetStep->Int32Value();
+    } else {
+      errStr << "Step " << index << " must be called on a java object or an earlier step";
+      error = errStr.str();
+      return false;
+    }
+  } else {
+    jclass clazz = m_java->getClassCache()->find(env, step.className);
+    if(clazz == NULL) {
+      errStr << "Could not find class " << step.className;
+      error = errStr.str();
+      return false;
+    }
+    step.clazz = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_BATON);
+  }
+
+  v8::Local<v8::Value> argRefs = stepObj->Get(v8::String::New("argRefs"));
+  if(argRefs->IsArray()) {
+    v8::Local<v8::Array> argRefsArray = v8::Local<v8::Array>(v8::Array::Cast(*argRefs));
+    for(uint32_t i=0; i<argRefsArray->Length(); i++) {
+      step.argRefs.push_back(argRefsArray->Get(i)->Int32Value());
+    }
+  }
+
+  // the args array is snapshotted like the arguments of an async call, step refs in it are nulls
+  v8::Local<v8::Value> args = stepObj->Get(v8::String::New("args"));
+  step.args = new NativeValue();
+  step.args->type = NATIVE_ARRAY;
+  step.args->objectValue = NULL;
+  V8ConversionPath conversionPath;
+  if(args->IsArray()) {
+    deleteNativeValue(env, step.args);
+    step.args = v8ValueToNative(env, args, &conversionPath);
+  }
+  m_steps.push_back(step);
+
+  // checked once the step is kept, so its refs are released with the baton
+  if(conversionPath.failed()) {
+    errStr << "Could not convert the arguments of step " << index << ", they contain themselves or are nested too deeply";
+    error = errStr.str();
+    return false;
+  }
+
+  for(size_t i=0; i+1<step.argRefs.size(); i+=2) {
+    if(step.argRefs[i] < 0 || step.argRefs[i] >= (int)step.args->items.size() || step.argRefs[i+1] < 0 || step.argRefs[i+1] >= index) {
+      errStr << "Step " << index << " refers to a step that does not come before it";
+      error = errStr.str();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PipelineBaton::keepStep(int index) {
+  if(index < 0 || index >= (int)m_steps.size()) {
+    return false;
+  }
+  m_keep.push_back(index);
+  return true;
+}
+
+/*
+ * Every step result stays alive until the pipeline is done, in case a later step refers to it, so the
+ * frame is sized for them on top of what a single step needs.
+ */
+void PipelineBaton::execute(JNIEnv *env) {
+  PUSH_LOCAL_JAVA_FRAME_SIZED(LOCAL_FRAME_SIZE_SMALL + (jint)m_steps.size());
+  std::vector<jobject> results(m_steps.size(), (jobject)NULL);
+  for(size_t i=0; i<m_steps.size(); i++) {
+    results[i] = runStep(env, i, results);
+    if(m_error || !m_failure.empty()) {
+      POP_LOCAL_JAVA_FRAME();
+      return;
+    }
+  }
+
+  if(m_keep.empty()) {
+    m_result = refStatsNewGlobalRef(env, results.back(), REF_SITE_BATON);
+  } else {
+    for(std::vector<int>::iterator it = m_keep.begin(); it != m_keep.end(); it++) {
+      m_keptResults.push_back(refStatsNewGlobalRef(env, results[*it], REF_SITE_BATON));
+    }
+  }
+  POP_LOCAL_JAVA_FRAME();
+}
+
+jobject PipelineBaton::runStep(JNIEnv *env, size_t index, std::vector<jobject>& results) {
+  PipelineStep& step = m_steps[index];
+  std::ostringstream errStr;
+  errStr << "Step " << index << " (" << (step.type == PIPELINE_STEP_METHOD ? "" : step.className + ".") << step.methodName << ")";
+  std::string stepName = errStr.str();
+
+  jobject target = step.target;
+  if(step.type == PIPELINE_STEP_METHOD && target == NULL) {
+    target = results[step.targetStep];
+    if(target == NULL) {
+      std::ostringstream failure;
+      failure << stepName << " was called on the null result of step " << step.targetStep;
+      m_failure = failure.str();
+      return NULL;
+    }
+  }
+
+  jobjectArray args = nativeToJavaArgs(env, step.args);
+  for(size_t i=0; i+1<step.argRefs.size(); i+=2) {
+    env->SetObjectArrayElement(args, step.argRefs[i], results[step.argRefs[i+1]]);
+  }
+
+  jobject method;
+  if(step.type == PIPELINE_STEP_NEW) {
+    method = javaFindConstructor(env, step.clazz, args);
+  } else if(step.type == PIPELINE_STEP_STATIC) {
+    method = javaFindMethod(env, step.clazz, step.methodName, args);
+  } else {
+    jclass clazz = env->GetObjectClass(target);
+    method = javaFindMethod(env, clazz, step.methodName, args);
+    env->DeleteLocalRef(clazz);
+  }
+  if(method == NULL) {
+    jthrowable err = env->ExceptionOccurred();
+    if(err) {
+      m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+      m_errorString = "Could not resolve " + stepName;
+      env->ExceptionClear();
+      env->DeleteLocalRef(err);
+    } else {
+      m_failure = "Could not find a method for " + stepName;
+    }
+    env->DeleteLocalRef(args);
+    return NULL;
+  }
+
+  jobject result;
+  if(step.type == PIPELINE_STEP_NEW) {
+    jclass constructorClazz = env->FindClass("java/lang/reflect/Constructor");
+    jmethodID constructor_newInstance = env->GetMethodID(constructorClazz, "newInstance", "([Ljava/lang/Object;)Ljava/lang/Object;");
+    result = env->CallObjectMethod(method, constructor_newInstance, args);
+    env->DeleteLocalRef(constructorClazz);
+  } else {
+    jclass methodClazz = env->FindClass("java/lang/reflect/Method");
+    jmethodID method_invoke = env->GetMethodID(methodClazz, "invoke", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
+    result = env->CallObjectMethod(method, method_invoke, step.type == PIPELINE_STEP_STATIC ? NULL : target, args);
+    env->DeleteLocalRef(methodClazz);
+  }
+  env->DeleteLocalRef(method);
+  env->DeleteLocalRef(args);
+
+  jthrowable err = env->ExceptionOccurred();
+  if(err) {
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+    m_errorString = "Error running " + stepName;
+    env->ExceptionClear();
+    env->DeleteLocalRef(err);
+    return NULL;
+  }
+  return result;
+}
+
+v8::Handle<v8::Value> PipelineBaton::resultsToV8(JNIEnv *env) {
+  v8::HandleScope scope;
+
+  if(m_error || !m_failure.empty() || m_keep.empty()) {
+    return scope.Close(MethodCallBaton::resultsToV8(env));
+  }
+
+  v8::Local<v8::Array> results = v8::Array::New(m_keptResults.size());
+  for(size_t i=0; i<m_keptResults.size(); i++) {
+    results->Set(i, javaToV8(m_java, env, m_keptResults[i], m_conversionOptions));
+  }
+  return scope.Close(results);
+}
+
+ParallelMapBaton::ParallelMapBaton(Java* java, jobject target, v8::Handle<v8::Value>& callback) : MethodCallBaton(java, NULL, NULL, callback) {
+  JNIEnv *env = m_java->getJavaEnv();
+  m_target = refStatsNewGlobalRef(env, target, REF_SITE_BATON);
+  m_failedItem = -1;
+}
+
+ParallelMapBaton::~ParallelMapBaton() {
+  JNIEnv *env = m_java->getJavaEnv();
+  refStatsDeleteGlobalRef(env, m_target, REF_SITE_BATON);
+  for(std::vector<NativeValue*>::iterator it = m_items.begin(); it != m_items.end(); it++) {
+    deleteNativeValue(env, *it);
+  }
+  for(std::vector<NativeValue*>::iterator it = m_results.begin(); it != m_results.end(); it++) {
+    deleteNativeValue(env, *it);
+  }
+}
+
+jobject ParallelMapBaton::resolveMethod(JNIEnv *env) {
+  jobject method = javaFindMethod(env, m_clazz, m_methodName, (jobjectArray)m_args);
+  if(method == NULL) {
+    m_failure = "Could not find method \"" + m_methodName + "\"";
+  }
+  return method;
+}
+
+/*
+ * The first item's arguments were deferred like those of a single call, so prepare has already
+ * turned them into m_args and resolved the method; the rest are converted one at a time here.
+ */
+void ParallelMapBaton::execute(JNIEnv *env) {
+  ConversionOptions options = m_conversionOptions;
+  if(!options.collections) {
+    // only strings and boxed primitives are converted ahead, everything else is wrapped as usual
+    options.maxDepth = 0;
+  }
+
+  m_results.reserve(m_items.size() + 1);
+  if(!invokeItem(env, (jobjectArray)m_args, options)) {
+    return;
+  }
+  for(size_t i=0; i<m_items.size(); i++) {
+    if(m_cancelled) {
+      return;
+    }
+    PUSH_LOCAL_JAVA_FRAME_SIZED(LOCAL_FRAME_SIZE_SMALL);
+    jobjectArray args = nativeToJavaArgs(env, m_items[i]);
+    bool ok = invokeItem(env, args, options);
+    POP_LOCAL_JAVA_FRAME();
+    if(!ok) {
+      return;
+    }
+  }
+}
+
+bool ParallelMapBaton::invokeItem(JNIEnv *env, jobjectArray args, const ConversionOptions& options) {
+  jclass methodClazz = env->FindClass("java/lang/reflect/Method");
+  jmethodID method_invoke = env->GetMethodID(methodClazz, "invoke", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
+  env->DeleteLocalRef(methodClazz);
+
+  jobject result = env->CallObjectMethod(m_method, method_invoke, m_target, args);
+  jthrowable err = env->ExceptionOccurred();
+  if(err) {
+    m_failedItem = (int)m_results.size();
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+    m_errorString = "Error running method " + m_methodName;
+    env->ExceptionClear();
+    env->DeleteLocalRef(err);
+    return false;
+  }
+
+  PUSH_LOCAL_JAVA_FRAME_SIZED(javaToNativeFrameSize(options));
+  NativeValue* converted = javaToNative(env, result, options, 0);
+  POP_LOCAL_JAVA_FRAME();
+  env->DeleteLocalRef(result);
+  if(converted->type == NATIVE_ERROR) {
+    m_failedItem = (int)m_results.size();
+    m_error = (jthrowable)refStatsNewGlobalRef(env, converted->objectValue, REF_SITE_BATON);
+    m_errorString = converted->stringValue;
+    deleteNativeValue(env, converted);
+    return false;
+  }
+  m_results.push_back(converted);
+  return true;
+}
+
+v8::Handle<v8::Value> ParallelMapBaton::resultsToV8(JNIEnv *env) {
+  v8::HandleScope scope;
+
+  if(m_error || !m_failure.empty()) {
+    v8::Handle<v8::Value> err = MethodCallBaton::resultsToV8(env);
+    if(m_failedItem >= 0) {
+      err->ToObject()->Set(v8::String::New("item"), v8::Integer::New(m_failedItem));
+    }
+    return scope.Close(err);
+  }
+
+  v8::Local<v8::Array> results = v8::Array::New(m_results.size());
+  for(size_t i=0; i<m_results.size(); i++) {
+    results->Set(i, nativeToV8(m_java, env, m_results[i], m_conversionOptions));
+    deleteNativeValue(env, m_results[i]);
+  }
+  m_results.clear();
+  return scope.Close(results);
+}
+
+PreloadClassBaton::PreloadClassBaton(
+  Java* java,
+  const std::string& className,
+  bool initialize,
+  const std::string& warmupMethodName,
+  jint iterations,
+  jarray warmupArgs,
+  v8::Handle<v8::Value>& callback) : MethodCallBaton(java, NULL, warmupArgs, callback) {
+  m_className = className;
+  m_initialize = initialize;
+  m_warmupMethodName = warmupMethodName;
+  m_iterations = iterations;
+  m_loadedClass = NULL;
+  m_loadNs = 0;
+  m_warmupNs = 0;
+}
+
+PreloadClassBaton::~PreloadClassBaton() {
+  JNIEnv *env = m_java->getJavaEnv();
+  refStatsDeleteGlobalRef(env, m_loadedClass, REF_SITE_BATON);
+}
+
+/*
+ * Class.forName with the system class loader finds the same classes FindClass does on the v8 thread,
+ * and unlike FindClass it can be told to run the static initializers.
+ */
+void PreloadClassBaton::execute(JNIEnv *env) {
+  uint64_t start = uv_hrtime();
+  jclass classClazz = env->FindClass("java/lang/Class");
+  jmethodID class_forName = env->GetStaticMethodID(classClazz, "forName", "(Ljava/lang/String;ZLjava/lang/ClassLoader;)Ljava/lang/Class;");
+  jclass classLoaderClazz = env->FindClass("java/lang/ClassLoader");
+  jmethodID classLoader_getSystemClassLoader = env->GetStaticMethodID(classLoaderClazz, "getSystemClassLoader", "()Ljava/lang/ClassLoader;");
+
+  jobject classLoader = env->CallStaticObjectMethod(classLoaderClazz, classLoader_getSystemClassLoader);
+  jstring classNameJava = env->NewStringUTF(m_className.c_str());
+  jobject clazz = env->CallStaticObjectMethod(classClazz, class_forName, classNameJava, (jboolean)m_initialize, classLoader);
+  jthrowable err = env->ExceptionOccurred();
+  if(err) {
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+    m_errorString = "Could not load class " + m_className;
+    env->ExceptionClear();
+    return;
+  }
+  m_loadedClass = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_BATON);
+  jstring loadedClassNameJava = (jstring)env->CallObjectMethod(clazz, javaConversionIds.class_getName);
+  m_loadedClassName = javaToString(env, loadedClassNameJava);
+  env->DeleteLocalRef(loadedClassNameJava);
+  JavaObject::readMembers(env, m_loadedClass, &m_methodNames, &m_fieldNames);
+  m_loadNs = uv_hrtime() - start;
+
+  if(!m_warmupMethodName.empty()) {
+    start = uv_hrtime();
+    warmup(env);
+    m_warmupNs = uv_hrtime() - start;
+  }
+}
+
+void PreloadClassBaton::warmup(JNIEnv *env) {
+  jobject method = javaFindMethod(env, m_loadedClass, m_warmupMethodName, (jobjectArray)m_args);
+  jthrowable err = env->ExceptionOccurred();
+  if(err) {
+    m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+    m_errorString = "Could not find warm-up method " + m_warmupMethodName + " on class " + m_className;
+    env->ExceptionClear();
+    return;
+  }
+  if(method == NULL) {
+    m_failure = "Could not find warm-up method " + m_warmupMethodName + " on class " + m_className;
+    return;
+  }
+  if(!m_warmupKey.empty()) {
+    m_java->getMethodCache()->put(env, m_warmupKey, method);
+  }
+
+  jclass methodClazz = env->FindClass("java/lang/reflect/Method");
+  jmethodID method_getModifiers = env->GetMethodID(methodClazz, "getModifiers", "()I");
+  jmethodID method_invoke = env->GetMethodID(methodClazz, "invoke", "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
+  if((env->CallIntMethod(method, method_getModifiers) & MODIFIER_STATIC_ONLY) == 0) {
+    m_failure = "Warm-up method " + m_warmupMethodName + " on class " + m_className + " must be static";
+    return;
+  }
+
+  // a cancelled or timed out preload stops warming up at the next iteration
+  for(jint i=0; i<m_iterations && !m_cancelled; i++) {
+    jobject result = env->CallObjectMethod(method, method_invoke, NULL, m_args);
+    err = env->ExceptionOccurred();
+    if(err) {
+      m_error = (jthrowable)refStatsNewGlobalRef(env, err, REF_SITE_BATON);
+      m_errorString = "Error running warm-up method " + m_warmupMethodName + " on class " + m_className;
+      env->ExceptionClear();
+      return;
+    }
+    if(result) {
+      env->DeleteLocalRef(result);
+    }
+  }
+}
+
+v8::Handle<v8::Value> PreloadClassBaton::resultsToV8(JNIEnv *env) {
+  v8::HandleScope scope;
+
+  if(m_loadedClass) {
+    m_java->getClassCache()->put(env, m_className, m_loadedClass);
+    JavaObject::addObjectClass(m_loadedClassName, m_methodNames, m_fieldNames);
+  }
+  if(m_error || !m_failure.empty()) {
+    return scope.Close(MethodCallBaton::resultsToV8(env));
+  }
+
+  v8::Local<v8::Object> result = v8::Object::New();
+  result->Set(v8::String::New("className"), v8::String::New(m_className.c_str()));
+  result->Set(v8::String::New("loadMs"), v8::Number::New((double)m_loadNs / 1e6));
+  result->Set(v8::String::New("warmupMs"), v8::Number::New((double)m_warmupNs / 1e6));
+  result->Set(v8::String::New("iterations"), v8::Integer::New(m_warmupMethodName.empty() ? 0 : m_iterations));
+  return scope.Close(result);
+}
@@ -3,36 +3,88 @@
 #define _methodcallbaton_h_
 
 #include "utils.h"
+#include "nativeValue.h"
+#include "bridgeStats.h"
 #include <v8.h>
 #include <node.h>
 #include <jni.h>
 #include <list>
+#include <set>
+#include <vector>
 
 class Java;
 class JavaObject;
+class CallOptions;
+
+typedef enum _batonState {
+  BATON_STATE_QUEUED     = 1,
+  BATON_STATE_DISPATCHED = 2,
+  BATON_STATE_RUNNING    = 3,
+  BATON_STATE_DONE       = 4
+} batonState;
 
 class MethodCallBaton {
 public:
   MethodCallBaton(Java* java, jobject method, jarray args, v8::Handle<v8::Value>& callback);
   virtual ~MethodCallBaton();
 
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+  static v8::Handle<v8::Object> poolStatsToV8();
+
   static void EIO_MethodCall(uv_work_t* req);
   static void EIO_AfterMethodCall(uv_work_t* req);
-  void run();
+  bool run();
   v8::Handle<v8::Value> runSync();
+  void queueWork();
+  void setCallOptions(CallOptions* callOptions);
+  void cancel(const char* message, const char* code);
+  uint64_t getQueuedTime() { return m_queuedTime; }
+  void setQueuedTime(uint64_t queuedTime) { m_queuedTime = queuedTime; }
+  void setStats(MethodStats* stats) { m_stats = stats; }
+  void deferArgs(NativeValue* args, jclass clazz, const std::string& className, const std::string& methodName);
 
 protected:
+  bool prepare(JNIEnv *env);
+  virtual jobject resolveMethod(JNIEnv *env) { return NULL; }
   virtual void execute(JNIEnv *env) = 0;
   virtual void after(JNIEnv *env);
-  v8::Handle<v8::Value> resultsToV8(JNIEnv *env);
+  virtual v8::Handle<v8::Value> resultsToV8(JNIEnv *env);
+  void deferCallbackWithError(const char* message, const char* code);
+  void discardResults(JNIEnv *env);
+  void convertResults(JNIEnv *env);
+  void startTimeout();
+  void stopTimeout();
+  static void onTimeout(uv_timer_t* handle, int status);
 
   Java* m_java;
   v8::Persistent<v8::Value> m_callback;
   jthrowable m_error;
   std::string m_errorString;
+  std::string m_failure;
   jarray m_args;
+  bool m_localArgs;
+  NativeValue* m_nativeArgs;
+  jclass m_clazz;
+  std::string m_className;
+  std::string m_methodName;
+  std::string m_methodKey;
   jobject m_result;
   jobject m_method;
+  bool m_methodBorrowed;
+  uv_work_t m_req;
+  int m_priority;
+  uint64_t m_queuedTime;
+  CallOptions* m_callOptions;
+  uv_timer_t* m_timeoutTimer;
+  uv_mutex_t m_stateMutex;
+  batonState m_state;
+  bool m_cancelled;
+  jobject m_workerThread;
+  ConversionOptions m_conversionOptions;
+  NativeValue* m_nativeResult;
+  MethodStats* m_stats;
+  uint64_t m_convertNs;
 };
 
 class InstanceMethodCallBaton : public MethodCallBaton {
@@ -41,6 +93,7 @@ public:
   virtual ~InstanceMethodCallBaton();
 
 protected:
+  virtual jobject resolveMethod(JNIEnv *env);
   virtual void execute(JNIEnv *env);
 
   JavaObject* m_javaObject;
@@ -48,24 +101,170 @@ protected:
 
 class NewInstanceBaton : public MethodCallBaton {
 public:
-  NewInstanceBaton(Java* java, jclass clazz, jobject method, jarray args, v8::Handle<v8::Value>& callback);
+  NewInstanceBaton(Java* java, jobject method, jarray args, v8::Handle<v8::Value>& callback);
   virtual ~NewInstanceBaton();
 
 protected:
+  virtual jobject resolveMethod(JNIEnv *env);
   virtual void execute(JNIEnv *env);
-
-  jclass m_clazz;
 };
 
 class StaticMethodCallBaton : public MethodCallBaton {
 public:
-  StaticMethodCallBaton(Java* java, jclass clazz, jobject method, jarray args, v8::Handle<v8::Value>& callback);
+  StaticMethodCallBaton(Java* java, jobject method, jarray args, v8::Handle<v8::Value>& callback);
   virtual ~StaticMethodCallBaton();
+  void setMemoKey(const std::string& className, const std::string& methodName, const std::string& memoKey);
 
 protected:
+  virtual jobject resolveMethod(JNIEnv *env);
   virtual void execute(JNIEnv *env);
+  virtual v8::Handle<v8::Value> resultsToV8(JNIEnv *env);
 
-  jclass m_clazz;
+  // set when the method is memoized and the call missed, the result is cached under it
+  std::string m_memoKey;
+};
+
+typedef enum _streamKind {
+  STREAM_KIND_INPUT_STREAM = 1,
+  STREAM_KIND_READER       = 2,
+  STREAM_KIND_ITERATOR     = 3
+} streamKind;
+
+/*
+ * Reads the next chunk of a java InputStream, Reader or Iterator for java.createReadStream. The
+ * result is a Buffer, a string or an array of elements, or null once the source is exhausted.
+ */
+class StreamReadBaton : public MethodCallBaton {
+public:
+  StreamReadBaton(Java* java, JavaObject* obj, streamKind kind, jint maxCount, v8::Handle<v8::Value>& callback);
+  virtual ~StreamReadBaton();
+
+protected:
+  virtual void execute(JNIEnv *env);
+  virtual v8::Handle<v8::Value> resultsToV8(JNIEnv *env);
+  void readInputStream(JNIEnv *env, jobject stream);
+  void readReader(JNIEnv *env, jobject reader);
+  void readIterator(JNIEnv *env, jobject iterator);
+
+  JavaObject* m_javaObject;
+  streamKind m_kind;
+  jint m_maxCount;
+  bool m_eof;
+  std::vector<char> m_bytes;
+  std::vector<uint16_t> m_chars;
+};
+
+/*
+ * Writes bytes copied from one or more Buffers to a java OutputStream for java.createWriteStream.
+ */
+class StreamWriteBaton : public MethodCallBaton {
+public:
+  StreamWriteBaton(Java* java, JavaObject* obj, v8::Handle<v8::Value>& callback);
+  virtual ~StreamWriteBaton();
+  void append(const char* data, size_t length);
+
+protected:
+  virtual void execute(JNIEnv *env);
+
+  JavaObject* m_javaObject;
+  std::vector<char> m_bytes;
+};
+
+typedef enum _pipelineStepType {
+  PIPELINE_STEP_STATIC = 1,
+  PIPELINE_STEP_NEW    = 2,
+  PIPELINE_STEP_METHOD = 3
+} pipelineStepType;
+
+/*
+ * One call of a pipeline. The call is made on target, or on the result of step targetStep when
+ * target is NULL. argRefs holds pairs of argument index and step index; those arguments are
+ * replaced by the result of that earlier step when the call is made.
+ */
+struct PipelineStep {
+  pipelineStepType type;
+  std::string className;
+  std::string methodName;
+  jclass clazz;
+  jobject target;
+  int targetStep;
+  NativeValue* args;
+  std::vector<int> argRefs;
+};
+
+/*
+ * Runs the calls built with java.pipeline back to back on one worker thread. Intermediate results
+ * stay local refs of the worker and are never wrapped; only the last result, or the results of the
+ * steps asked for, are returned to javascript.
+ */
+class PipelineBaton : public MethodCallBaton {
+public:
+  PipelineBaton(Java* java, v8::Handle<v8::Value>& callback);
+  virtual ~PipelineBaton();
+  bool addStep(JNIEnv *env, v8::Local<v8::Object> step, std::string& error);
+  bool keepStep(int index);
+
+protected:
+  virtual void execute(JNIEnv *env);
+  virtual v8::Handle<v8::Value> resultsToV8(JNIEnv *env);
+  jobject runStep(JNIEnv *env, size_t index, std::vector<jobject>& results);
+
+  std::vector<PipelineStep> m_steps;
+  std::vector<int> m_keep;
+  std::vector<jobject> m_keptResults;
+};
+
+/*
+ * Calls one method for every item of a chunk of java.parallelMap, on one worker thread. The method is
+ * resolved once, from the arguments of the first item, and then invoked with each item's arguments in
+ * turn. Results are converted as they are produced and handed to javascript as one array.
+ */
+class ParallelMapBaton : public MethodCallBaton {
+public:
+  ParallelMapBaton(Java* java, jobject target, v8::Handle<v8::Value>& callback);
+  virtual ~ParallelMapBaton();
+  void addItem(NativeValue* args) { m_items.push_back(args); }
+
+protected:
+  virtual jobject resolveMethod(JNIEnv *env);
+  virtual void execute(JNIEnv *env);
+  virtual v8::Handle<v8::Value> resultsToV8(JNIEnv *env);
+  bool invokeItem(JNIEnv *env, jobjectArray args, const ConversionOptions& options);
+
+  jobject m_target;
+  std::vector<NativeValue*> m_items;
+  std::vector<NativeValue*> m_results;
+  int m_failedItem;
+};
+
+/*
+ * Loads a class for java.preload. The class is loaded, and unless asked not to initialized, on the
+ * thread pool, where its member names are read as well; a warm-up method, if given, is then resolved
+ * and called there iterations times so the JIT sees it before real traffic does. Back on the v8
+ * thread the class goes into the class cache, the wrapper template for its objects is built, and the
+ * warm-up method into the method cache under warmupKey.
+ */
+class PreloadClassBaton : public MethodCallBaton {
+public:
+  PreloadClassBaton(Java* java, const std::string& className, bool initialize, const std::string& warmupMethodName, jint iterations, jarray warmupArgs, v8::Handle<v8::Value>& callback);
+  virtual ~PreloadClassBaton();
+  void setWarmupKey(const std::string& warmupKey) { m_warmupKey = warmupKey; }
+
+protected:
+  virtual void execute(JNIEnv *env);
+  virtual v8::Handle<v8::Value> resultsToV8(JNIEnv *env);
+  void warmup(JNIEnv *env);
+
+  bool m_initialize;
+  std::string m_warmupMethodName;
+  jint m_iterations;
+  jclass m_loadedClass;
+  std::string m_loadedClassName;
+  std::set<std::string> m_methodNames;
+  std::set<std::string> m_fieldNames;
+  std::string m_warmupKey;
+  uint64_t m_loadNs;
+  uint64_t m_warmupNs;
 };
 
 #endif
@@ -0,0 +1,513 @@
+#include "nativeValue.h"
+#include "utils.h"
+#include "java.h"
+#include "javaObject.h"
+#include "typedValue.h"
+#include <string.h>
+
+JavaConversionIds javaConversionIds;
+
+jclass javaFindGlobalClass(JNIEnv* env, const char* className) {
+  jclass clazz = env->FindClass(className);
+  jclass result = (jclass)refStatsNewGlobalRef(env, clazz, REF_SITE_CONVERSION);
+  env->DeleteLocalRef(clazz);
+  return result;
+}
+
+void javaInitConversionIds(JNIEnv* env) {
+  JavaConversionIds* ids = &javaConversionIds;
+
+  ids->stringClazz = javaFindGlobalClass(env, "java/lang/String");
+  ids->objectClazz = javaFindGlobalClass(env, "java/lang/Object");
+  ids->integerClazz = javaFindGlobalClass(env, "java/lang/Integer");
+  ids->integer_init = env->GetMethodID(ids->integerClazz, "<init>", "(I)V");
+  ids->integer_intValue = env->GetMethodID(ids->integerClazz, "intValue", "()I");
+  ids->longClazz = javaFindGlobalClass(env, "java/lang/Long");
+  ids->long_init = env->GetMethodID(ids->longClazz, "<init>", "(J)V");
+  ids->long_longValue = env->GetMethodID(ids->longClazz, "longValue", "()J");
+  ids->doubleClazz = javaFindGlobalClass(env, "java/lang/Double");
+  ids->double_init = env->GetMethodID(ids->doubleClazz, "<init>", "(D)V");
+  ids->double_doubleValue = env->GetMethodID(ids->doubleClazz, "doubleValue", "()D");
+  ids->floatClazz = javaFindGlobalClass(env, "java/lang/Float");
+  ids->float_init = env->GetMethodID(ids->floatClazz, "<init>", "(F)V");
+  ids->float_floatValue = env->GetMethodID(ids->floatClazz, "floatValue", "()F");
+  ids->shortClazz = javaFindGlobalClass(env, "java/lang/Short");
+  ids->short_init = env->GetMethodID(ids->shortClazz, "<init>", "(S)V");
+  ids->short_shortValue = env->GetMethodID(ids->shortClazz, "shortValue", "()S");
+  ids->characterClazz = javaFindGlobalClass(env, "java/lang/Character");
+  ids->character_init = env->GetMethodID(ids->characterClazz, "<init>", "(C)V");
+  ids->byteClazz = javaFindGlobalClass(env, "java/lang/Byte");
+  ids->byte_byteValue = env->GetMethodID(ids->byteClazz, "byteValue", "()B");
+  ids->booleanClazz = javaFindGlobalClass(env, "java/lang/Boolean");
+  ids->boolean_init = env->GetMethodID(ids->booleanClazz, "<init>", "(Z)V");
+  ids->boolean_booleanValue = env->GetMethodID(ids->booleanClazz, "booleanValue", "()Z");
+  ids->objectArrayClazz = javaFindGlobalClass(env, "[Ljava/lang/Object;");
+  ids->collectionClazz = javaFindGlobalClass(env, "java/util/Collection");
+  ids->collection_toArray = env->GetMethodID(ids->collectionClazz, "toArray", "()[Ljava/lang/Object;");
+  ids->mapClazz = javaFindGlobalClass(env, "java/util/Map");
+  ids->map_entrySet = env->GetMethodID(ids->mapClazz, "entrySet", "()Ljava/util/Set;");
+  ids->mapEntryClazz = javaFindGlobalClass(env, "java/util/Map$Entry");
+  ids->mapEntry_getKey = env->GetMethodID(ids->mapEntryClazz, "getKey", "()Ljava/lang/Object;");
+  ids->mapEntry_getValue = env->GetMethodID(ids->mapEntryClazz, "getValue", "()Ljava/lang/Object;");
+  ids->linkedHashMapClazz = javaFindGlobalClass(env, "java/util/LinkedHashMap");
+  ids->linkedHashMap_init = env->GetMethodID(ids->linkedHashMapClazz, "<init>", "(I)V");
+  ids->map_put = env->GetMethodID(ids->mapClazz, "put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+  ids->arrayListClazz = javaFindGlobalClass(env, "java/util/ArrayList");
+  ids->arrayList_init = env->GetMethodID(ids->arrayListClazz, "<init>", "(I)V");
+  ids->arrayList_initCollection = env->GetMethodID(ids->arrayListClazz, "<init>", "(Ljava/util/Collection;)V");
+  ids->collection_add = env->GetMethodID(ids->collectionClazz, "add", "(Ljava/lang/Object;)Z");
+  ids->arraysClazz = javaFindGlobalClass(env, "java/util/Arrays");
+  ids->arrays_asList = env->GetStaticMethodID(ids->arraysClazz, "asList", "([Ljava/lang/Object;)Ljava/util/List;");
+  ids->inputStreamClazz = javaFindGlobalClass(env, "java/io/InputStream");
+  ids->inputStream_read = env->GetMethodID(ids->inputStreamClazz, "read", "([BII)I");
+  ids->inputStream_available = env->GetMethodID(ids->inputStreamClazz, "available", "()I");
+  ids->readerClazz = javaFindGlobalClass(env, "java/io/Reader");
+  ids->reader_read = env->GetMethodID(ids->readerClazz, "read", "([CII)I");
+  ids->reader_ready = env->GetMethodID(ids->readerClazz, "ready", "()Z");
+  ids->outputStreamClazz = javaFindGlobalClass(env, "java/io/OutputStream");
+  ids->outputStream_write = env->GetMethodID(ids->outputStreamClazz, "write", "([BII)V");
+  ids->iteratorClazz = javaFindGlobalClass(env, "java/util/Iterator");
+  ids->iterator_hasNext = env->GetMethodID(ids->iteratorClazz, "hasNext", "()Z");
+  ids->iterator_next = env->GetMethodID(ids->iteratorClazz, "next", "()Ljava/lang/Object;");
+  ids->classClazz = javaFindGlobalClass(env, "java/lang/Class");
+  ids->class_getName = env->GetMethodID(ids->classClazz, "getName", "()Ljava/lang/String;");
+}
+
+void conversionOptionsInit(ConversionOptions* options) {
+  options->collections = false;
+  options->maxDepth = CONVERSION_DEFAULT_MAX_DEPTH;
+  options->mapsAsMap = false;
+}
+
+v8::Handle<v8::Value> conversionOptionsParse(v8::Handle<v8::Object> obj, ConversionOptions* options, bool* found) {
+  *found = false;
+
+  v8::Local<v8::Value> collections = obj->Get(v8::String::New("collections"));
+  if(!collections->IsUndefined()) {
+    options->collections = collections->BooleanValue();
+    *found = true;
+  }
+
+  v8::Local<v8::Value> depth = obj->Get(v8::String::New("depth"));
+  if(!depth->IsUndefined()) {
+    if(!depth->IsNumber() || depth->NumberValue() < 1) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("depth must be a number greater than 0")));
+    }
+    options->maxDepth = depth->Int32Value();
+    *found = true;
+  }
+
+  v8::Local<v8::Value> mapType = obj->Get(v8::String::New("mapType"));
+  if(!mapType->IsUndefined()) {
+    v8::String::AsciiValue mapTypeStr(mapType);
+    if(strcmp(*mapTypeStr, "object") == 0) {
+      options->mapsAsMap = false;
+    } else if(strcmp(*mapTypeStr, "map") == 0) {
+      options->mapsAsMap = true;
+    } else {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("mapType must be either \"object\" or \"map\"")));
+    }
+    *found = true;
+  }
+
+  return v8::Undefined();
+}
+
+/*
+ * Takes the pending exception as the result of a conversion, so the caller gets an error rather than
+ * a partly copied collection.
+ */
+static NativeValue* javaToNativeError(JNIEnv* env, NativeValue* partial, const char* message) {
+  jthrowable ex = env->ExceptionOccurred();
+  env->ExceptionClear();
+  deleteNativeValue(env, partial);
+  NativeValue* result = new NativeValue();
+  result->type = NATIVE_ERROR;
+  result->stringValue = message;
+  result->objectValue = refStatsNewGlobalRef(env, ex, REF_SITE_CONVERSION);
+  env->DeleteLocalRef(ex);
+  return result;
+}
+
+// an entry that failed to convert replaces the whole collection
+static NativeValue* javaToNativeTakeError(JNIEnv* env, NativeValue* partial, std::vector<NativeValue*>* values) {
+  NativeValue* error = values->back();
+  values->pop_back();
+  deleteNativeValue(env, partial);
+  return error;
+}
+
+static NativeValue* javaObjectArrayToNative(JNIEnv* env, jobjectArray array, NativeValue* result, const ConversionOptions& options, int depth) {
+  jsize arraySize = env->GetArrayLength(array);
+  result->type = NATIVE_ARRAY;
+  result->items.reserve(arraySize);
+  for(jsize i=0; i<arraySize; i++) {
+    jobject item = env->GetObjectArrayElement(array, i);
+    result->items.push_back(javaToNative(env, item, options, depth + 1));
+    env->DeleteLocalRef(item);
+    if(result->items.back()->type == NATIVE_ERROR) {
+      return javaToNativeTakeError(env, result, &result->items);
+    }
+  }
+  return result;
+}
+
+/*
+ * javaToNative deletes its local refs as it goes, so only the entry being copied at each level of
+ * nesting is alive at once.
+ */
+jint javaToNativeFrameSize(const ConversionOptions& options) {
+  return LOCAL_FRAME_SIZE_SMALL + 5 * (options.maxDepth + 1);
+}
+
+/*
+ * Every call into a collection is checked for an exception before the next JNI call is made, a map
+ * or collection that throws while being copied (eg. a ConcurrentModificationException) gives a
+ * NATIVE_ERROR. The local refs of an abandoned copy are left to the caller's frame.
+ */
+NativeValue* javaToNative(JNIEnv* env, jobject obj, const ConversionOptions& options, int depth) {
+  JavaConversionIds* ids = &javaConversionIds;
+  NativeValue* result = new NativeValue();
+  result->objectValue = NULL;
+
+  if(obj == NULL) {
+    result->type = NATIVE_NULL;
+  } else if(env->IsInstanceOf(obj, ids->stringClazz)) {
+    result->type = NATIVE_STRING;
+    result->stringValue = javaToString(env, (jstring)obj);
+  } else if(env->IsInstanceOf(obj, ids->integerClazz)) {
+    result->type = NATIVE_NUMBER;
+    result->numberValue = env->CallIntMethod(obj, ids->integer_intValue);
+  } else if(env->IsInstanceOf(obj, ids->longClazz)) {
+    result->type = NATIVE_NUMBER;
+    result->numberValue = (double)env->CallLongMethod(obj, ids->long_longValue);
+  } else if(env->IsInstanceOf(obj, ids->doubleClazz)) {
+    result->type = NATIVE_NUMBER;
+    result->numberValue = env->CallDoubleMethod(obj, ids->double_doubleValue);
+  } else if(env->IsInstanceOf(obj, ids->booleanClazz)) {
+    result->type = NATIVE_BOOLEAN;
+    result->boolValue = env->CallBooleanMethod(obj, ids->boolean_booleanValue);
+  } else if(env->IsInstanceOf(obj, ids->floatClazz)) {
+    result->type = NATIVE_NUMBER;
+    result->numberValue = env->CallFloatMethod(obj, ids->float_floatValue);
+  } else if(env->IsInstanceOf(obj, ids->shortClazz)) {
+    result->type = NATIVE_NUMBER;
+    result->numberValue = env->CallShortMethod(obj, ids->short_shortValue);
+  } else if(env->IsInstanceOf(obj, ids->byteClazz)) {
+    result->type = NATIVE_NUMBER;
+    result->numberValue = env->CallByteMethod(obj, ids->byte_byteValue);
+  } else if(depth < options.maxDepth && env->IsInstanceOf(obj, ids->mapClazz)) {
+    result->type = NATIVE_MAP;
+    jobject entrySet = env->CallObjectMethod(obj, ids->map_entrySet);
+    if(env->ExceptionCheck()) {
+      return javaToNativeError(env, result, "Could not get the entries of a java.util.Map");
+    }
+    jobjectArray entries = entrySet ? (jobjectArray)env->CallObjectMethod(entrySet, ids->collection_toArray) : NULL;
+    if(env->ExceptionCheck()) {
+      return javaToNativeError(env, result, "Could not get the entries of a java.util.Map");
+    }
+    jsize entryCount = entries ? env->GetArrayLength(entries) : 0;
+    result->keys.reserve(entryCount);
+    result->items.reserve(entryCount);
+    for(jsize i=0; i<entryCount; i++) {
+      jobject entry = env->GetObjectArrayElement(entries, i);
+      jobject key = env->CallObjectMethod(entry, ids->mapEntry_getKey);
+      if(env->ExceptionCheck()) {
+        return javaToNativeError(env, result, "Could not get the key of a java.util.Map entry");
+      }
+      jobject value = env->CallObjectMethod(entry, ids->mapEntry_getValue);
+      if(env->ExceptionCheck()) {
+        return javaToNativeError(env, result, "Could not get the value of a java.util.Map entry");
+      }
+      result->keys.push_back(javaToNative(env, key, options, depth + 1));
+      if(result->keys.back()->type == NATIVE_ERROR) {
+        return javaToNativeTakeError(env, result, &result->keys);
+      }
+      result->items.push_back(javaToNative(env, value, options, depth + 1));
+      if(result->items.back()->type == NATIVE_ERROR) {
+        return javaToNativeTakeError(env, result, &result->items);
+      }
+      env->DeleteLocalRef(value);
+      env->DeleteLocalRef(key);
+      env->DeleteLocalRef(entry);
+    }
+    env->DeleteLocalRef(entries);
+    env->DeleteLocalRef(entrySet);
+  } else if(depth < options.maxDepth && env->IsInstanceOf(obj, ids->collectionClazz)) {
+    jobjectArray items = (jobjectArray)env->CallObjectMethod(obj, ids->collection_toArray);
+    if(env->ExceptionCheck()) {
+      return javaToNativeError(env, result, "Could not get the items of a java.util.Collection");
+    }
+    if(items == NULL) {
+      result->type = NATIVE_ARRAY;
+      return result;
+    }
+    result = javaObjectArrayToNative(env, items, result, options, depth);
+    env->DeleteLocalRef(items);
+  } else if(depth < options.maxDepth && env->IsInstanceOf(obj, ids->objectArrayClazz)) {
+    result = javaObjectArrayToNative(env, (jobjectArray)obj, result, options, depth);
+  } else {
+    result->type = NATIVE_OBJECT;
+    result->objectValue = refStatsNewGlobalRef(env, obj, REF_SITE_CONVERSION);
+  }
+
+  if(env->ExceptionCheck()) {
+    return javaToNativeError(env, result, "Could not convert a java object");
+  }
+
+  return result;
+}
+
+v8::Handle<v8::Value> nativeToV8(Java* java, JNIEnv* env, NativeValue* value, const ConversionOptions& options) {
+  v8::HandleScope scope;
+
+  switch(value->type) {
+    case NATIVE_NULL:
+      return v8::Null();
+    case NATIVE_BOOLEAN:
+      return scope.Close(v8::Boolean::New(value->boolValue));
+    case NATIVE_NUMBER:
+    case NATIVE_INTEGER:
+      return scope.Close(v8::Number::New(value->numberValue));
+    case NATIVE_STRING:
+      return scope.Close(v8::String::New(value->stringValue.c_str(), value->stringValue.length()));
+    case NATIVE_OBJECT:
+      {
+        return scope.Close(javaToV8(java, env, value->objectValue));
+      }
+    case NATIVE_ERROR:
+      return scope.Close(javaExceptionToV8(env, (jthrowable)value->objectValue, value->stringValue));
+    case NATIVE_ARRAY:
+      {
+        v8::Local<v8::Array> result = v8::Array::New(value->items.size());
+        for(size_t i=0; i<value->items.size(); i++) {
+          result->Set(i, nativeToV8(java, env, value->items[i], options));
+        }
+        return scope.Close(result);
+      }
+    case NATIVE_MAP:
+      {
+        v8::Local<v8::Value> mapCtor = v8::Context::GetCurrent()->Global()->Get(v8::String::New("Map"));
+        if(options.mapsAsMap && mapCtor->IsFunction()) {
+          v8::Local<v8::Object> result = v8::Function::Cast(*mapCtor)->NewInstance();
+          v8::Local<v8::Function> mapSet = v8::Local<v8::Function>::Cast(result->Get(v8::String::New("set")));
+          for(size_t i=0; i<value->items.size(); i++) {
+            v8::Handle<v8::Value> argv[2];
+            argv[0] = nativeToV8(java, env, value->keys[i], options);
+            argv[1] = nativeToV8(java, env, value->items[i], options);
+            mapSet->Call(result, 2, argv);
+          }
+          return scope.Close(result);
+        }
+
+        // plain objects are used when Map is not available
+        v8::Local<v8::Object> result = v8::Object::New();
+        for(size_t i=0; i<value->items.size(); i++) {
+          result->Set(nativeToV8(java, env, value->keys[i], options), nativeToV8(java, env, value->items[i], options));
+        }
+        return scope.Close(result);
+      }
+  }
+
+  return v8::Undefined();
+}
+
+void deleteNativeValue(JNIEnv* env, NativeValue* value) {
+  if(value == NULL) {
+    return;
+  }
+  if(value->objectValue) {
+    refStatsDeleteGlobalRef(env, value->objectValue, REF_SITE_CONVERSION);
+  }
+  for(std::vector<NativeValue*>::iterator it = value->keys.begin(); it != value->keys.end(); it++) {
+    deleteNativeValue(env, *it);
+  }
+  for(std::vector<NativeValue*>::iterator it = value->items.begin(); it != value->items.end(); it++) {
+    deleteNativeValue(env, *it);
+  }
+  delete value;
+}
+
+static bool v8IsPlainObject(v8::Local<v8::Object> obj) {
+  v8::String::AsciiValue constructorName(obj->GetConstructorName());
+  return strcmp(*constructorName, "Object") == 0;
+}
+
+/*
+ * The class v8ToJava gives a wrapped java object or a typed value, or "" when only java can tell, eg.
+ * for a dynamic proxy whose wrapper class is not the class of the proxy it becomes.
+ */
+static std::string v8KnownClassName(v8::Local<v8::Value> arg) {
+  if(JavaObject::HasInstance(arg)) {
+    JavaObject* javaObject = node::ObjectWrap::Unwrap<JavaObject>(arg->ToObject());
+    return javaObject->isDynamicProxy() ? "" : javaObject->getClassName();
+  }
+  if(TypedValue::HasInstance(arg)) {
+    switch(TypedValue::getType(arg)) {
+      case 'J': return "java.lang.Long";
+      case 'F': return "java.lang.Float";
+      case 'S': return "java.lang.Short";
+      case 'C': return "java.lang.Character";
+    }
+  }
+  return "";
+}
+
+/*
+ * Snapshots a v8 value for v8ToNative with the same rules v8ToJava follows, so the java value built
+ * from it later is the one v8ToJava would have built. Strings, numbers, arrays and plain objects are
+ * copied; anything else, java objects and proxies included, is converted right away and held as a
+ * global ref since it is either cheap or needs v8 to convert. A value that contains itself marks the
+ * path failed and is snapshotted as null; the caller checks the path and discards the result.
+ */
+NativeValue* v8ValueToNative(JNIEnv* env, v8::Local<v8::Value> arg, V8ConversionPath* path) {
+  NativeValue* result = new NativeValue();
+  result->objectValue = NULL;
+
+  if(arg.IsEmpty() || arg->IsNull() || arg->IsUndefined()) {
+    result->type = NATIVE_NULL;
+  } else if(arg->IsArray()) {
+    v8::Local<v8::Array> array = v8::Array::Cast(*arg);
+    if(!path->enter(array)) {
+      result->type = NATIVE_NULL;
+      return result;
+    }
+    uint32_t arraySize = array->Length();
+    result->type = NATIVE_ARRAY;
+    result->items.reserve(arraySize);
+    for(uint32_t i=0; i<arraySize && !path->failed(); i++) {
+      result->items.push_back(v8ValueToNative(env, array->Get(i), path));
+    }
+    path->leave();
+  } else if(arg->IsString()) {
+    v8::String::AsciiValue val(arg->ToString());
+    result->type = NATIVE_STRING;
+    result->stringValue.assign(*val, val.length());
+  } else if(arg->IsInt32() || arg->IsUint32()) {
+    result->type = NATIVE_INTEGER;
+    result->numberValue = arg->ToInt32()->Value();
+  } else if(arg->IsNumber()) {
+    result->type = NATIVE_NUMBER;
+    result->numberValue = arg->ToNumber()->Value();
+  } else if(arg->IsBoolean()) {
+    result->type = NATIVE_BOOLEAN;
+    result->boolValue = arg->ToBoolean()->Value();
+  } else if(arg->IsObject() && v8IsPlainObject(v8::Object::Cast(*arg))) {
+    v8::Local<v8::Object> obj = v8::Object::Cast(*arg);
+    if(!path->enter(obj)) {
+      result->type = NATIVE_NULL;
+      return result;
+    }
+    v8::Local<v8::Array> keys = obj->GetOwnPropertyNames();
+    uint32_t keyCount = keys->Length();
+    result->type = NATIVE_MAP;
+    result->keys.reserve(keyCount);
+    result->items.reserve(keyCount);
+    for(uint32_t i=0; i<keyCount && !path->failed(); i++) {
+      v8::Local<v8::Value> key = keys->Get(i);
+      result->keys.push_back(v8ValueToNative(env, key->ToString(), path));
+      result->items.push_back(v8ValueToNative(env, obj->Get(key), path));
+    }
+    path->leave();
+  } else {
+    jobject val = v8ToJava(env, arg, path);
+    result->type = val ? NATIVE_OBJECT : NATIVE_NULL;
+    result->objectValue = refStatsNewGlobalRef(env, val, REF_SITE_CONVERSION);
+    if(val) {
+      env->DeleteLocalRef(val);
+      result->stringValue = v8KnownClassName(arg);
+    }
+  }
+
+  return result;
+}
+
+// returns NULL when the path failed, the caller throws path->getError()
+NativeValue* v8ToNative(JNIEnv* env, const v8::Arguments& args, int start, int end, V8ConversionPath* path) {
+  NativeValue* result = new NativeValue();
+  result->type = NATIVE_ARRAY;
+  result->objectValue = NULL;
+  result->items.reserve(end - start);
+  for(int i=start; i<end; i++) {
+    result->items.push_back(v8ValueToNative(env, args[i], path));
+    if(path->failed()) {
+      deleteNativeValue(env, result);
+      return NULL;
+    }
+  }
+  return result;
+}
+
+/*
+ * Arrays become Object[] where v8ToJava would build them and ArrayLists where v8ToJavaCollectionItem
+ * would, that is inside plain objects and inside other lists.
+ */
+jobject nativeToJava(JNIEnv* env, NativeValue* value, bool collectionItem) {
+  JavaConversionIds* ids = &javaConversionIds;
+
+  switch(value->type) {
+    case NATIVE_NULL:
+      return NULL;
+    case NATIVE_BOOLEAN:
+      return env->NewObject(ids->booleanClazz, ids->boolean_init, (jboolean)value->boolValue);
+    case NATIVE_INTEGER:
+      return env->NewObject(ids->integerClazz, ids->integer_init, (jint)value->numberValue);
+    case NATIVE_NUMBER:
+      return env->NewObject(ids->doubleClazz, ids->double_init, (jdouble)value->numberValue);
+    case NATIVE_STRING:
+      return env->NewStringUTF(value->stringValue.c_str());
+    case NATIVE_OBJECT:
+    case NATIVE_ERROR:
+      return env->NewLocalRef(value->objectValue);
+    case NATIVE_ARRAY:
+      if(collectionItem) {
+        jobject result = env->NewObject(ids->arrayListClazz, ids->arrayList_init, (jint)value->items.size());
+        for(size_t i=0; i<value->items.size(); i++) {
+          jobject val = nativeToJava(env, value->items[i], true);
+          env->CallBooleanMethod(result, ids->collection_add, val);
+          env->DeleteLocalRef(val);
+        }
+        return result;
+      } else {
+        jobjectArray result = env->NewObjectArray(value->items.size(), ids->objectClazz, NULL);
+        for(size_t i=0; i<value->items.size(); i++) {
+          jobject val = nativeToJava(env, value->items[i], false);
+          env->SetObjectArrayElement(result, i, val);
+          env->DeleteLocalRef(val);
+        }
+        return result;
+      }
+    case NATIVE_MAP:
+      {
+        jobject result = env->NewObject(ids->linkedHashMapClazz, ids->linkedHashMap_init, (jint)(value->keys.size() * 4 / 3 + 1));
+        for(size_t i=0; i<value->keys.size(); i++) {
+          jobject javaKey = nativeToJava(env, value->keys[i], false);
+          jobject javaValue = nativeToJava(env, value->items[i], true);
+          jobject previous = env->CallObjectMethod(result, ids->map_put, javaKey, javaValue);
+          env->DeleteLocalRef(previous);
+          env->DeleteLocalRef(javaValue);
+          env->DeleteLocalRef(javaKey);
+        }
+        return result;
+      }
+  }
+
+  return NULL;
+}
+
+jobjectArray nativeToJavaArgs(JNIEnv* env, NativeValue* args) {
+  return (jobjectArray)nativeToJava(env, args, false);
+}
+
+v8::Handle<v8::Value> javaToV8(Java* java, JNIEnv* env, jobject obj, const ConversionOptions& options) {
+  v8::HandleScope scope;
+
+  if(!options.collections) {
+    return scope.Close(javaToV8(java, env, obj));
+  }
+
+  NativeValue* nativeValue = javaToNative(env, obj, options, 0);
+  v8::Handle<v8::Value> result = nativeToV8(java, env, nativeValue, options);
+  deleteNativeValue(env, nativeValue);
+  return scope.Close(result);
+}
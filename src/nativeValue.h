@@ -0,0 +1,125 @@
+#ifndef _nativevalue_h_
+#define _nativevalue_h_
+
+#include <v8.h>
+#include <jni.h>
+#include <vector>
+#include <string>
+
+class Java;
+class V8ConversionPath;
+
+typedef enum _nativeValueType {
+  NATIVE_NULL    = 1,
+  NATIVE_BOOLEAN = 2,
+  NATIVE_NUMBER  = 3,
+  NATIVE_STRING  = 4,
+  NATIVE_OBJECT  = 5,
+  NATIVE_ARRAY   = 6,
+  NATIVE_MAP     = 7,
+  NATIVE_INTEGER = 8,
+  NATIVE_ERROR   = 9
+} nativeValueType;
+
+/*
+ * A value converted out of java but not yet into v8, or out of v8 but not yet into java. Either way
+ * the half that needs the JNI allocations can run on any attached thread, so async calls can do the
+ * expensive part of a conversion on the thread pool. Objects that are not converted are held as
+ * global refs. A conversion that throws in java gives a NATIVE_ERROR holding the exception and a
+ * message, which nativeToV8 turns into an Error. A NATIVE_OBJECT snapshotted from v8 keeps the name of
+ * its class in stringValue when it is known without asking java.
+ */
+struct NativeValue {
+  nativeValueType type;
+  bool boolValue;
+  double numberValue;
+  std::string stringValue;
+  jobject objectValue;
+  std::vector<NativeValue*> keys;
+  std::vector<NativeValue*> items;
+};
+
+struct ConversionOptions {
+  bool collections;
+  int maxDepth;
+  bool mapsAsMap;
+};
+
+/*
+ * Classes and method ids used while converting. They are looked up once on the v8 thread when the
+ * jvm is created and can then be used from any thread.
+ */
+struct JavaConversionIds {
+  jclass stringClazz;
+  jclass objectClazz;
+  jclass integerClazz;
+  jmethodID integer_init;
+  jmethodID integer_intValue;
+  jclass longClazz;
+  jmethodID long_init;
+  jmethodID long_longValue;
+  jclass doubleClazz;
+  jmethodID double_init;
+  jmethodID double_doubleValue;
+  jclass floatClazz;
+  jmethodID float_init;
+  jmethodID float_floatValue;
+  jclass shortClazz;
+  jmethodID short_init;
+  jmethodID short_shortValue;
+  jclass characterClazz;
+  jmethodID character_init;
+  jclass byteClazz;
+  jmethodID byte_byteValue;
+  jclass booleanClazz;
+  jmethodID boolean_init;
+  jmethodID boolean_booleanValue;
+  jclass objectArrayClazz;
+  jclass collectionClazz;
+  jmethodID collection_toArray;
+  jclass mapClazz;
+  jmethodID map_entrySet;
+  jclass mapEntryClazz;
+  jmethodID mapEntry_getKey;
+  jmethodID mapEntry_getValue;
+  jclass linkedHashMapClazz;
+  jmethodID linkedHashMap_init;
+  jmethodID map_put;
+  jclass arrayListClazz;
+  jmethodID arrayList_init;
+  jmethodID arrayList_initCollection;
+  jmethodID collection_add;
+  jclass arraysClazz;
+  jmethodID arrays_asList;
+  jclass inputStreamClazz;
+  jmethodID inputStream_read;
+  jmethodID inputStream_available;
+  jclass readerClazz;
+  jmethodID reader_read;
+  jmethodID reader_ready;
+  jclass outputStreamClazz;
+  jmethodID outputStream_write;
+  jclass iteratorClazz;
+  jmethodID iterator_hasNext;
+  jmethodID iterator_next;
+  jclass classClazz;
+  jmethodID class_getName;
+};
+
+#define CONVERSION_DEFAULT_MAX_DEPTH 10
+
+extern JavaConversionIds javaConversionIds;
+
+void javaInitConversionIds(JNIEnv* env);
+void conversionOptionsInit(ConversionOptions* options);
+v8::Handle<v8::Value> conversionOptionsParse(v8::Handle<v8::Object> obj, ConversionOptions* options, bool* found);
+NativeValue* javaToNative(JNIEnv* env, jobject obj, const ConversionOptions& options, int depth);
+jint javaToNativeFrameSize(const ConversionOptions& options);
+v8::Handle<v8::Value> nativeToV8(Java* java, JNIEnv* env, NativeValue* value, const ConversionOptions& options);
+void deleteNativeValue(JNIEnv* env, NativeValue* value);
+NativeValue* v8ValueToNative(JNIEnv* env, v8::Local<v8::Value> arg, V8ConversionPath* path);
+NativeValue* v8ToNative(JNIEnv* env, const v8::Arguments& args, int start, int end, V8ConversionPath* path);
+jobjectArray nativeToJavaArgs(JNIEnv* env, NativeValue* args);
+v8::Handle<v8::Value> javaToV8(Java* java, JNIEnv* env, jobject obj, const ConversionOptions& options);
+
+#endif
@@ -1,11 +1,19 @@
 
 #include "java.h"
 #include "javaObject.h"
+#include "callOptions.h"
+#include "eventRing.h"
+#include "boundMethod.h"
+#include "typedValue.h"
 
 extern "C" {
   static void init(v8::Handle<v8::Object> target) {
     Java::Init(target);
     JavaObject::Init(target);
+    CallOptions::Init(target);
+    EventRing::Init(target);
+    BoundMethod::Init(target);
+    TypedValue::Init(target);
   }
 
   NODE_MODULE(nodejavabridge_bindings, init);
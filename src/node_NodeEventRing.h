@@ -0,0 +1,21 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class node_NodeEventRing */
+
+#ifndef _Included_node_NodeEventRing
+#define _Included_node_NodeEventRing
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     node_NodeEventRing
+ * Method:    appendRecords
+ * Signature: (J[BII)Z
+ */
+JNIEXPORT jboolean JNICALL Java_node_NodeEventRing_appendRecords
+  (JNIEnv *, jobject, jlong, jbyteArray, jint, jint);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,135 @@
+#include "refStats.h"
+
+#ifdef WIN32
+  #include <windows.h>
+  #define REF_STATS_ATOMIC_ADD(PTR, VAL) InterlockedExchangeAdd64((volatile LONGLONG*)(PTR), (LONGLONG)(VAL))
+  #define REF_STATS_ATOMIC_CAS(PTR, OLDVAL, NEWVAL) (InterlockedCompareExchange64((volatile LONGLONG*)(PTR), (LONGLONG)(NEWVAL), (LONGLONG)(OLDVAL)) == (LONGLONG)(OLDVAL))
+  #define REF_STATS_THREAD_LOCAL __declspec(thread)
+#else
+  #define REF_STATS_ATOMIC_ADD(PTR, VAL) __sync_fetch_and_add((PTR), (VAL))
+  #define REF_STATS_ATOMIC_CAS(PTR, OLDVAL, NEWVAL) __sync_bool_compare_and_swap((PTR), (OLDVAL), (NEWVAL))
+  #define REF_STATS_THREAD_LOCAL __thread
+#endif
+
+static const char* refSiteNames[REF_SITE_COUNT] = { "javaObject", "baton", "proxy", "conversion", "method", "classCache", "other" };
+
+static volatile int64_t refStatsLive[REF_SITE_COUNT];
+static volatile int64_t refStatsCreated[REF_SITE_COUNT];
+static volatile int64_t refStatsPendingRelease = 0;
+
+static volatile int64_t refStatsFramesPushed = 0;
+static volatile int64_t refStatsFramesFailed = 0;
+static volatile int64_t refStatsMaxFrameCapacity = 0;
+static volatile int64_t refStatsMaxFrameDepth = 0;
+static volatile int64_t refStatsMaxReserved = 0;
+
+static REF_STATS_THREAD_LOCAL int refStatsThreadDepth = 0;
+static REF_STATS_THREAD_LOCAL int64_t refStatsThreadReserved = 0;
+static REF_STATS_THREAD_LOCAL jint refStatsThreadCapacities[REF_STATS_MAX_FRAME_DEPTH];
+
+static void refStatsRaise(volatile int64_t* highWaterMark, int64_t value) {
+  int64_t current = *highWaterMark;
+  while(value > current && !REF_STATS_ATOMIC_CAS(highWaterMark, current, value)) {
+    current = *highWaterMark;
+  }
+}
+
+jobject refStatsNewGlobalRef(JNIEnv* env, jobject obj, refSite site) {
+  if(obj == NULL) {
+    return NULL;
+  }
+  jobject ref = env->NewGlobalRef(obj);
+  if(ref != NULL) {
+    REF_STATS_ATOMIC_ADD(&refStatsLive[site], 1);
+    REF_STATS_ATOMIC_ADD(&refStatsCreated[site], 1);
+  }
+  return ref;
+}
+
+void refStatsDeleteGlobalRef(JNIEnv* env, jobject ref, refSite site) {
+  if(ref == NULL) {
+    return;
+  }
+  env->DeleteGlobalRef(ref);
+  REF_STATS_ATOMIC_ADD(&refStatsLive[site], -1);
+}
+
+void refStatsQueueRelease(refSite site) {
+  REF_STATS_ATOMIC_ADD(&refStatsLive[site], -1);
+  REF_STATS_ATOMIC_ADD(&refStatsPendingRelease, 1);
+}
+
+void refStatsReleased(size_t count) {
+  REF_STATS_ATOMIC_ADD(&refStatsPendingRelease, -(int64_t)count);
+}
+
+/*
+ * JNI does not report how many local refs a frame actually holds, so the capacity a frame asks for
+ * is what is tracked. Frames that are sized from their workload keep these numbers meaningful.
+ */
+jint javaPushLocalFrame(JNIEnv* env, jint capacity) {
+  jint result = env->PushLocalFrame(capacity);
+  if(result != 0) {
+    // nothing was pushed, so nothing will be popped; the pending OutOfMemoryError is left for the caller
+    REF_STATS_ATOMIC_ADD(&refStatsFramesFailed, 1);
+    return result;
+  }
+
+  REF_STATS_ATOMIC_ADD(&refStatsFramesPushed, 1);
+  refStatsRaise(&refStatsMaxFrameCapacity, capacity);
+  if(refStatsThreadDepth < REF_STATS_MAX_FRAME_DEPTH) {
+    refStatsThreadCapacities[refStatsThreadDepth] = capacity;
+    refStatsThreadReserved += capacity;
+    refStatsRaise(&refStatsMaxReserved, refStatsThreadReserved);
+  }
+  refStatsThreadDepth++;
+  refStatsRaise(&refStatsMaxFrameDepth, refStatsThreadDepth);
+  return result;
+}
+
+jobject javaPopLocalFrame(JNIEnv* env, jobject result) {
+  if(refStatsThreadDepth > 0) {
+    refStatsThreadDepth--;
+    if(refStatsThreadDepth < REF_STATS_MAX_FRAME_DEPTH) {
+      refStatsThreadReserved -= refStatsThreadCapacities[refStatsThreadDepth];
+    }
+  }
+  return env->PopLocalFrame(result);
+}
+
+void refStatsResetHighWaterMarks() {
+  refStatsMaxFrameCapacity = 0;
+  refStatsMaxFrameDepth = 0;
+  refStatsMaxReserved = 0;
+}
+
+v8::Handle<v8::Object> refStatsToV8() {
+  v8::HandleScope scope;
+
+  v8::Local<v8::Object> live = v8::Object::New();
+  v8::Local<v8::Object> created = v8::Object::New();
+  int64_t totalLive = 0;
+  for(int i=0; i<REF_SITE_COUNT; i++) {
+    live->Set(v8::String::New(refSiteNames[i]), v8::Number::New((double)refStatsLive[i]));
+    created->Set(v8::String::New(refSiteNames[i]), v8::Number::New((double)refStatsCreated[i]));
+    totalLive += refStatsLive[i];
+  }
+
+  v8::Local<v8::Object> globalRefs = v8::Object::New();
+  globalRefs->Set(v8::String::New("live"), live);
+  globalRefs->Set(v8::String::New("created"), created);
+  globalRefs->Set(v8::String::New("totalLive"), v8::Number::New((double)totalLive));
+  globalRefs->Set(v8::String::New("pendingRelease"), v8::Number::New((double)refStatsPendingRelease));
+
+  v8::Local<v8::Object> localFrames = v8::Object::New();
+  localFrames->Set(v8::String::New("pushed"), v8::Number::New((double)refStatsFramesPushed));
+  localFrames->Set(v8::String::New("failed"), v8::Number::New((double)refStatsFramesFailed));
+  localFrames->Set(v8::String::New("maxCapacity"), v8::Number::New((double)refStatsMaxFrameCapacity));
+  localFrames->Set(v8::String::New("maxDepth"), v8::Number::New((double)refStatsMaxFrameDepth));
+  localFrames->Set(v8::String::New("maxReserved"), v8::Number::New((double)refStatsMaxReserved));
+
+  v8::Local<v8::Object> result = v8::Object::New();
+  result->Set(v8::String::New("globalRefs"), globalRefs);
+  result->Set(v8::String::New("localFrames"), localFrames);
+  return scope.Close(result);
+}
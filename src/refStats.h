@@ -0,0 +1,39 @@
+
+#ifndef _refstats_h_
+#define _refstats_h_
+
+#include <v8.h>
+#include <jni.h>
+
+typedef enum _refSite {
+  REF_SITE_JAVA_OBJECT = 0,
+  REF_SITE_BATON       = 1,
+  REF_SITE_PROXY       = 2,
+  REF_SITE_CONVERSION  = 3,
+  REF_SITE_METHOD      = 4,
+  REF_SITE_CLASS_CACHE = 5,
+  REF_SITE_OTHER       = 6,
+  REF_SITE_COUNT       = 7
+} refSite;
+
+// deepest nesting of local frames tracked per thread, deeper frames are still counted
+#define REF_STATS_MAX_FRAME_DEPTH 64
+
+/*
+ * Process wide accounting of the JNI references the bridge holds. Global refs are counted by the
+ * site that created them; a ref handed to Java::releaseGlobalRef moves to pendingRelease until the
+ * batch that deletes it has run. Local frames are counted per push, and the deepest nesting and the
+ * most local refs reserved at once by the frames of a single thread are kept as high-water marks.
+ */
+jobject refStatsNewGlobalRef(JNIEnv* env, jobject obj, refSite site);
+void refStatsDeleteGlobalRef(JNIEnv* env, jobject ref, refSite site);
+void refStatsQueueRelease(refSite site);
+void refStatsReleased(size_t count);
+
+jint javaPushLocalFrame(JNIEnv* env, jint capacity);
+jobject javaPopLocalFrame(JNIEnv* env, jobject result);
+
+v8::Handle<v8::Object> refStatsToV8();
+void refStatsResetHighWaterMarks();
+
+#endif
@@ -0,0 +1,288 @@
+#include "syncWatchdog.h"
+#include "java.h"
+#include "javaObject.h"
+#include "utils.h"
+#include <sstream>
+
+#ifdef WIN32
+  #include <windows.h>
+  #define WATCHDOG_SLEEP_MS(MS) Sleep(MS)
+#else
+  #include <unistd.h>
+  #define WATCHDOG_SLEEP_MS(MS) usleep((MS) * 1000)
+#endif
+
+SyncWatchdog::SyncWatchdog() {
+  m_enabled = false;
+  m_thresholdNs = 0;
+  m_depth = 0;
+  m_java = NULL;
+  m_v8JavaThread = NULL;
+  m_async = NULL;
+  uv_mutex_init(&m_mutex);
+  m_running = false;
+  m_callActive = false;
+  m_callStartNs = 0;
+  m_callSequence = 0;
+  m_sampledSequence = 0;
+}
+
+SyncWatchdog::~SyncWatchdog() {
+  stop();
+  uv_mutex_destroy(&m_mutex);
+}
+
+/*
+ * options is { thresholdMs, onBlocked } to enable the watchdog or null/false to disable it.
+ */
+v8::Handle<v8::Value> SyncWatchdog::setOptions(Java* java, v8::Handle<v8::Value> options) {
+  stop();
+  if(!options->IsObject()) {
+    return v8::Undefined();
+  }
+  v8::Local<v8::Object> optionsObj = options->ToObject();
+
+  v8::Local<v8::Value> thresholdMs = optionsObj->Get(v8::String::New("thresholdMs"));
+  double thresholdMsValue = 50;
+  if(!thresholdMs->IsUndefined()) {
+    if(!thresholdMs->IsNumber() || thresholdMs->NumberValue() <= 0) {
+      return ThrowException(v8::Exception::TypeError(v8::String::New("thresholdMs must be a number greater than 0")));
+    }
+    thresholdMsValue = thresholdMs->NumberValue();
+  }
+
+  v8::Local<v8::Value> onBlocked = optionsObj->Get(v8::String::New("onBlocked"));
+  if(!onBlocked->IsUndefined() && !onBlocked->IsFunction()) {
+    return ThrowException(v8::Exception::TypeError(v8::String::New("onBlocked must be a function")));
+  }
+  if(onBlocked->IsFunction()) {
+    m_callback = v8::Persistent<v8::Function>::New(v8::Local<v8::Function>::Cast(onBlocked));
+  }
+
+  m_thresholdNs = (uint64_t)(thresholdMsValue * 1000000.0);
+  start(java);
+  return v8::Undefined();
+}
+
+void SyncWatchdog::start(Java* java) {
+  JNIEnv* env = java->getJavaEnv();
+  m_java = java;
+
+  jclass threadClazz = env->FindClass("java/lang/Thread");
+  jmethodID thread_currentThread = env->GetStaticMethodID(threadClazz, "currentThread", "()Ljava/lang/Thread;");
+  jobject v8JavaThread = env->CallStaticObjectMethod(threadClazz, thread_currentThread);
+  m_v8JavaThread = refStatsNewGlobalRef(env, v8JavaThread, REF_SITE_OTHER);
+  env->DeleteLocalRef(v8JavaThread);
+  env->DeleteLocalRef(threadClazz);
+
+  m_async = new uv_async_t();
+  m_async->data = this;
+  uv_async_init(uv_default_loop(), m_async, onAsync);
+  // reports are only delivered while something else keeps the loop running
+  uv_unref((uv_handle_t*)m_async);
+
+  m_depth = 0;
+  m_enabled = true;
+  m_running = true;
+  uv_thread_create(&m_thread, threadMain, this);
+}
+
+void onSyncWatchdogAsyncClose(uv_handle_t* handle) {
+  delete (uv_async_t*)handle;
+}
+
+void SyncWatchdog::stop() {
+  if(!m_enabled) {
+    return;
+  }
+  m_enabled = false;
+  m_running = false;
+  uv_thread_join(&m_thread);
+
+  refStatsDeleteGlobalRef(m_java->getJavaEnv(), m_v8JavaThread, REF_SITE_OTHER);
+  m_v8JavaThread = NULL;
+  m_async->data = NULL;
+  uv_close((uv_handle_t*)m_async, onSyncWatchdogAsyncClose);
+  m_async = NULL;
+  if(!m_callback.IsEmpty()) {
+    m_callback.Dispose();
+    m_callback.Clear();
+  }
+  m_pendingCallbacks.clear();
+}
+
+void SyncWatchdog::begin() {
+  if(m_depth++ > 0) {
+    return;
+  }
+  uv_mutex_lock(&m_mutex);
+  m_callActive = true;
+  m_callSequence++;
+  m_callStartNs = uv_hrtime();
+  uv_mutex_unlock(&m_mutex);
+}
+
+bool SyncWatchdog::isOverThreshold() {
+  return m_depth == 1 && uv_hrtime() - m_callStartNs > m_thresholdNs;
+}
+
+void SyncWatchdog::end(const std::string& className, const std::string& methodName) {
+  if(!m_enabled || --m_depth > 0) {
+    return;
+  }
+  uv_mutex_lock(&m_mutex);
+  m_callActive = false;
+  uint64_t elapsedNs = uv_hrtime() - m_callStartNs;
+  std::string javaStack;
+  if(m_sampledSequence == m_callSequence) {
+    javaStack = m_sampledStack;
+  }
+  uv_mutex_unlock(&m_mutex);
+
+  if(elapsedNs <= m_thresholdNs) {
+    return;
+  }
+
+  BlockedCallReport report;
+  report.className = className;
+  report.methodName = methodName;
+  report.durationMs = (double)elapsedNs / 1000000.0;
+  report.javaStack = javaStack;
+  m_reports.push_back(report);
+  if(m_reports.size() > SYNC_WATCHDOG_MAX_REPORTS) {
+    m_reports.pop_front();
+  }
+
+  // the callback runs on the next loop iteration, not inside the blocked call
+  if(!m_callback.IsEmpty()) {
+    m_pendingCallbacks.push_back(report);
+    uv_async_send(m_async);
+  }
+}
+
+v8::Handle<v8::Object> blockedCallReportToV8(const BlockedCallReport& report) {
+  v8::HandleScope scope;
+  v8::Local<v8::Object> reportObj = v8::Object::New();
+  reportObj->Set(v8::String::New("className"), v8::String::New(report.className.c_str()));
+  reportObj->Set(v8::String::New("methodName"), v8::String::New(report.methodName.c_str()));
+  reportObj->Set(v8::String::New("durationMs"), v8::Number::New(report.durationMs));
+  if(!report.javaStack.empty()) {
+    reportObj->Set(v8::String::New("javaStack"), v8::String::New(report.javaStack.c_str()));
+  }
+  return scope.Close(reportObj);
+}
+
+v8::Handle<v8::Array> SyncWatchdog::takeReports() {
+  v8::HandleScope scope;
+  v8::Local<v8::Array> result = v8::Array::New(m_reports.size());
+  int i = 0;
+  for(std::list<BlockedCallReport>::iterator it = m_reports.begin(); it != m_reports.end(); it++) {
+    result->Set(i++, blockedCallReportToV8(*it));
+  }
+  m_reports.clear();
+  return scope.Close(result);
+}
+
+/*static*/ void SyncWatchdog::onAsync(uv_async_t* handle, int status) {
+  SyncWatchdog* self = static_cast<SyncWatchdog*>(handle->data);
+  if(self == NULL) {
+    return;
+  }
+  v8::HandleScope scope;
+  std::list<BlockedCallReport> reports;
+  reports.swap(self->m_pendingCallbacks);
+  for(std::list<BlockedCallReport>::iterator it = reports.begin(); it != reports.end(); it++) {
+    if(self->m_callback.IsEmpty()) {
+      break;
+    }
+    v8::Handle<v8::Value> argv[1];
+    argv[0] = blockedCallReportToV8(*it);
+    self->m_callback->Call(v8::Context::GetCurrent()->Global(), 1, argv);
+  }
+}
+
+std::string SyncWatchdog::sampleStack(JNIEnv* env) {
+  std::ostringstream stack;
+  javaPushLocalFrame(env, SYNC_WATCHDOG_MAX_FRAMES + 8);
+  jclass threadClazz = env->FindClass("java/lang/Thread");
+  jmethodID thread_getStackTrace = env->GetMethodID(threadClazz, "getStackTrace", "()[Ljava/lang/StackTraceElement;");
+  jobjectArray frames = (jobjectArray)env->CallObjectMethod(m_v8JavaThread, thread_getStackTrace);
+  if(env->ExceptionCheck()) {
+    env->ExceptionClear();
+  } else if(frames) {
+    jsize frameCount = env->GetArrayLength(frames);
+    for(jsize i=0; i<frameCount && i<SYNC_WATCHDOG_MAX_FRAMES; i++) {
+      jobject frame = env->GetObjectArrayElement(frames, i);
+      stack << "    at " << javaObjectToString(env, frame) << "\n";
+      env->DeleteLocalRef(frame);
+    }
+    if(frameCount > SYNC_WATCHDOG_MAX_FRAMES) {
+      stack << "    ... " << (frameCount - SYNC_WATCHDOG_MAX_FRAMES) << " more\n";
+    }
+  }
+  javaPopLocalFrame(env, NULL);
+  return stack.str();
+}
+
+/*static*/ void SyncWatchdog::threadMain(void* arg) {
+  SyncWatchdog* self = static_cast<SyncWatchdog*>(arg);
+  JNIEnv* env = javaAttachCurrentThread(self->m_java->getJvm());
+
+  uint64_t pollMs = self->m_thresholdNs / 4000000;
+  if(pollMs < 1) { pollMs = 1; }
+  if(pollMs > 50) { pollMs = 50; }
+
+  while(self->m_running) {
+    WATCHDOG_SLEEP_MS(pollMs);
+
+    uv_mutex_lock(&self->m_mutex);
+    unsigned int sequence = self->m_callSequence;
+    bool needSample = self->m_callActive
+      && self->m_sampledSequence != sequence
+      && uv_hrtime() - self->m_callStartNs > self->m_thresholdNs;
+    uv_mutex_unlock(&self->m_mutex);
+
+    if(!needSample) {
+      continue;
+    }
+
+    std::string stack = self->sampleStack(env);
+    uv_mutex_lock(&self->m_mutex);
+    if(self->m_callActive && self->m_callSequence == sequence) {
+      self->m_sampledSequence = sequence;
+      self->m_sampledStack = stack;
+    }
+    uv_mutex_unlock(&self->m_mutex);
+  }
+
+  javaDetachCurrentThread(self->m_java->getJvm());
+}
+
+SyncCallGuard::SyncCallGuard(SyncWatchdog* watchdog, const std::string& className, const std::string& methodName) {
+  m_watchdog = watchdog->isEnabled() ? watchdog : NULL;
+  m_javaObject = NULL;
+  if(m_watchdog) {
+    m_className = className;
+    m_methodName = methodName;
+    m_watchdog->begin();
+  }
+}
+
+SyncCallGuard::SyncCallGuard(SyncWatchdog* watchdog, JavaObject* javaObject, const std::string& methodName) {
+  m_watchdog = watchdog->isEnabled() ? watchdog : NULL;
+  m_javaObject = javaObject;
+  if(m_watchdog) {
+    m_methodName = methodName;
+    m_watchdog->begin();
+  }
+}
+
+SyncCallGuard::~SyncCallGuard() {
+  if(m_watchdog == NULL) {
+    return;
+  }
+  if(m_javaObject && m_watchdog->isOverThreshold()) {
+    m_className = m_javaObject->getClassName();
+  }
+  m_watchdog->end(m_className, m_methodName);
+}
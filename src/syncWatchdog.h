@@ -0,0 +1,85 @@
+#ifndef _syncwatchdog_h_
+#define _syncwatchdog_h_
+
+#include <v8.h>
+#include <uv.h>
+#include <jni.h>
+#include <string>
+#include <list>
+
+class Java;
+class JavaObject;
+
+#define SYNC_WATCHDOG_MAX_REPORTS 100
+#define SYNC_WATCHDOG_MAX_FRAMES 32
+
+struct BlockedCallReport {
+  std::string className;
+  std::string methodName;
+  double durationMs;
+  std::string javaStack;
+};
+
+/*
+ * Watches synchronous calls made on the v8 thread. A monitoring thread polls the call in progress
+ * and, once it has run longer than the threshold, samples the v8 thread's java stack while the call
+ * is still blocked. Calls over the threshold are reported when they return.
+ */
+class SyncWatchdog {
+public:
+  SyncWatchdog();
+  ~SyncWatchdog();
+
+  bool isEnabled() { return m_enabled; }
+  v8::Handle<v8::Value> setOptions(Java* java, v8::Handle<v8::Value> options);
+  void begin();
+  bool isOverThreshold();
+  void end(const std::string& className, const std::string& methodName);
+  v8::Handle<v8::Array> takeReports();
+
+private:
+  void start(Java* java);
+  void stop();
+  std::string sampleStack(JNIEnv* env);
+  static void threadMain(void* arg);
+  static void onAsync(uv_async_t* handle, int status);
+
+  bool m_enabled;
+  uint64_t m_thresholdNs;
+  int m_depth;
+  Java* m_java;
+  jobject m_v8JavaThread;
+  v8::Persistent<v8::Function> m_callback;
+  uv_async_t* m_async;
+  std::list<BlockedCallReport> m_reports;
+  std::list<BlockedCallReport> m_pendingCallbacks;
+
+  // shared with the monitoring thread
+  uv_mutex_t m_mutex;
+  uv_thread_t m_thread;
+  volatile bool m_running;
+  bool m_callActive;
+  uint64_t m_callStartNs;
+  unsigned int m_callSequence;
+  unsigned int m_sampledSequence;
+  std::string m_sampledStack;
+};
+
+/*
+ * Marks a synchronous call for the watchdog for as long as it is in scope. The class name of a java
+ * object is only looked up when the call turned out to be slow.
+ */
+class SyncCallGuard {
+public:
+  SyncCallGuard(SyncWatchdog* watchdog, const std::string& className, const std::string& methodName);
+  SyncCallGuard(SyncWatchdog* watchdog, JavaObject* javaObject, const std::string& methodName);
+  ~SyncCallGuard();
+
+private:
+  SyncWatchdog* m_watchdog;
+  JavaObject* m_javaObject;
+  std::string m_className;
+  std::string m_methodName;
+};
+
+#endif
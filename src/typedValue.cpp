@@ -0,0 +1,144 @@
+#include "typedValue.h"
+#include "nativeValue.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+
+#define TYPED_VALUE_FIELD_TYPE  0
+#define TYPED_VALUE_FIELD_VALUE 1
+
+/*static*/ v8::Persistent<v8::FunctionTemplate> TypedValue::s_ct;
+
+/*static*/ void TypedValue::Init(v8::Handle<v8::Object> target) {
+  v8::HandleScope scope;
+
+  v8::Local<v8::FunctionTemplate> t = v8::FunctionTemplate::New();
+  s_ct = v8::Persistent<v8::FunctionTemplate>::New(t);
+  s_ct->InstanceTemplate()->SetInternalFieldCount(2);
+  s_ct->SetClassName(v8::String::NewSymbol("JavaTypedValue"));
+
+  NODE_SET_PROTOTYPE_METHOD(s_ct, "valueOf", valueOf);
+}
+
+// numbers beyond 2^53 are not exact in a double, larger longs have to be given as strings
+#define TYPED_VALUE_MAX_SAFE_LONG 9007199254740992.0
+
+static bool typedValueParseLong(v8::Handle<v8::Value> val, int64_t* result) {
+  if(val->IsNumber()) {
+    double number = val->NumberValue();
+    // checked before the cast, which is undefined for NaN, infinities and values out of range
+    if(!(number >= -TYPED_VALUE_MAX_SAFE_LONG && number <= TYPED_VALUE_MAX_SAFE_LONG) || floor(number) != number) {
+      return false;
+    }
+    *result = (int64_t)number;
+    return true;
+  }
+  v8::String::AsciiValue str(val);
+  char* end;
+  errno = 0;
+  *result = strtoll(*str, &end, 10);
+  return errno == 0 && str.length() > 0 && *end == '\0';
+}
+
+/*
+ * Checks the value fits the type up front, so a bad value is reported where it was made rather than
+ * by the call it is passed to.
+ */
+/*static*/ v8::Handle<v8::Value> TypedValue::New(char type, const v8::Arguments& args) {
+  v8::HandleScope scope;
+  if(args.Length() != 1) {
+    return ThrowException(v8::Exception::TypeError(v8::String::New("Expected exactly 1 argument")));
+  }
+
+  v8::Local<v8::Value> val = args[0];
+  v8::Local<v8::Value> stored;
+  switch(type) {
+    case 'J':
+      {
+        int64_t longValue;
+        if(!(val->IsNumber() || val->IsString()) || !typedValueParseLong(val, &longValue)) {
+          return ThrowException(v8::Exception::TypeError(v8::String::New("A long must be an integer from -2^53 to 2^53 or a string of digits")));
+        }
+        stored = val->IsString() ? val : v8::Local<v8::Value>(v8::Number::New((double)longValue));
+      }
+      break;
+    case 'F':
+      if(!val->IsNumber()) {
+        return ThrowException(v8::Exception::TypeError(v8::String::New("A float must be a number")));
+      }
+      stored = v8::Number::New((float)val->NumberValue());
+      break;
+    case 'S':
+      if(!val->IsInt32() || val->Int32Value() < -32768 || val->Int32Value() > 32767) {
+        return ThrowException(v8::Exception::TypeError(v8::String::New("A short must be an integer from -32768 to 32767")));
+      }
+      stored = val;
+      break;
+    case 'C':
+      if(val->IsString() && val->ToString()->Length() == 1) {
+        v8::String::Value chars(val);
+        stored = v8::Integer::New((*chars)[0]);
+      } else if(val->IsUint32() && val->Uint32Value() <= 0xffff) {
+        stored = val;
+      } else {
+        return ThrowException(v8::Exception::TypeError(v8::String::New("A char must be a string of one character or a number from 0 to 65535")));
+      }
+      break;
+    default:
+      return ThrowException(v8::Exception::TypeError(v8::String::New("Unknown primitive type")));
+  }
+
+  v8::Local<v8::Object> obj = s_ct->GetFunction()->NewInstance();
+  obj->SetInternalField(TYPED_VALUE_FIELD_TYPE, v8::Integer::New(type));
+  obj->SetInternalField(TYPED_VALUE_FIELD_VALUE, stored);
+  return scope.Close(obj);
+}
+
+/*static*/ bool TypedValue::HasInstance(v8::Handle<v8::Value> val) {
+  return val->IsObject() && s_ct->HasInstance(val);
+}
+
+/*static*/ char TypedValue::getType(v8::Handle<v8::Value> val) {
+  return (char)val->ToObject()->GetInternalField(TYPED_VALUE_FIELD_TYPE)->Int32Value();
+}
+
+/*static*/ jvalue TypedValue::toJValue(v8::Handle<v8::Value> val) {
+  v8::Local<v8::Value> stored = val->ToObject()->GetInternalField(TYPED_VALUE_FIELD_VALUE);
+  jvalue result;
+  result.j = 0;
+  switch(getType(val)) {
+    case 'J':
+      {
+        int64_t longValue = 0;
+        typedValueParseLong(stored, &longValue);
+        result.j = (jlong)longValue;
+      }
+      break;
+    case 'F': result.f = (jfloat)stored->NumberValue(); break;
+    case 'S': result.s = (jshort)stored->Int32Value(); break;
+    case 'C': result.c = (jchar)stored->Uint32Value(); break;
+  }
+  return result;
+}
+
+/*static*/ jobject TypedValue::toJava(JNIEnv* env, v8::Handle<v8::Value> val) {
+  JavaConversionIds* ids = &javaConversionIds;
+  jvalue value = toJValue(val);
+  switch(getType(val)) {
+    case 'J': return env->NewObject(ids->longClazz, ids->long_init, value.j);
+    case 'F': return env->NewObject(ids->floatClazz, ids->float_init, value.f);
+    case 'S': return env->NewObject(ids->shortClazz, ids->short_init, value.s);
+    case 'C': return env->NewObject(ids->characterClazz, ids->character_init, value.c);
+  }
+  return NULL;
+}
+
+/*
+ * Lets typed values be used as numbers in javascript, eg. in comparisons. Longs outside the range a
+ * double holds exactly lose precision here.
+ */
+/*static*/ v8::Handle<v8::Value> TypedValue::valueOf(const v8::Arguments& args) {
+  v8::HandleScope scope;
+  v8::Local<v8::Value> stored = args.This()->GetInternalField(TYPED_VALUE_FIELD_VALUE);
+  return scope.Close(v8::Number::New(stored->NumberValue()));
+}
@@ -0,0 +1,31 @@
+
+#ifndef _typedvalue_h_
+#define _typedvalue_h_
+
+#include <v8.h>
+#include <node.h>
+#include <jni.h>
+
+/*
+ * A javascript number tagged with the java primitive type it stands for, made by java.long,
+ * java.float, java.short and java.char. Creating one does not touch the JVM: the type and value are
+ * kept in internal fields and only turned into a java value when passed to a call, as the boxed type
+ * for reflective calls and as the jvalue itself for bound methods. The type is the JNI descriptor
+ * character, eg. 'J' for long. Longs given as strings keep all 64 bits.
+ */
+class TypedValue {
+public:
+  static void Init(v8::Handle<v8::Object> target);
+  static v8::Handle<v8::Value> New(char type, const v8::Arguments& args);
+  static bool HasInstance(v8::Handle<v8::Value> val);
+  static char getType(v8::Handle<v8::Value> val);
+  static jvalue toJValue(v8::Handle<v8::Value> val);
+  static jobject toJava(JNIEnv* env, v8::Handle<v8::Value> val);
+
+private:
+  static v8::Handle<v8::Value> valueOf(const v8::Arguments& args);
+
+  static v8::Persistent<v8::FunctionTemplate> s_ct;
+};
+
+#endif
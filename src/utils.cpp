@@ -3,8 +3,11 @@
 #include <string.h>
 #include <algorithm>
 #include <sstream>
+#include <node_buffer.h>
 #include "javaObject.h"
 #include "java.h"
+#include "nativeValue.h"
+#include "typedValue.h"
 
 #define MODIFIER_STATIC 9
 
@@ -16,6 +19,8 @@ void javaReflectionGetMethods(JNIEnv *env, jclass clazz, std::list<jobject>* met
 
   jobjectArray methodObjects = (jobjectArray)env->CallObjectMethod(clazz, clazz_getMethods);
   jsize methodCount = env->GetArrayLength(methodObjects);
+  // every method is handed back as a local ref, make sure the caller's frame has room for all of them
+  env->EnsureLocalCapacity(methodCount + LOCAL_FRAME_SIZE_SMALL);
   for(jsize i=0; i<methodCount; i++) {
     jobject method = env->GetObjectArrayElement(methodObjects, i);
     jint methodModifiers = env->CallIntMethod(method, method_getModifiers);
@@ -26,6 +31,8 @@ void javaReflectionGetMethods(JNIEnv *env, jclass clazz, std::list<jobject>* met
     methods->push_back(method);
   }
   env->DeleteLocalRef(methodObjects);
+  env->DeleteLocalRef(methodClazz);
+  env->DeleteLocalRef(clazzclazz);
 }
 
 void javaReflectionGetFields(JNIEnv *env, jclass clazz, std::list<jobject>* fields) {
@@ -36,6 +43,8 @@ void javaReflectionGetFields(JNIEnv *env, jclass clazz, std::list<jobject>* fiel
 
   jobjectArray fieldObjects = (jobjectArray)env->CallObjectMethod(clazz, clazz_getFields);
   jsize fieldCount = env->GetArrayLength(fieldObjects);
+  // every field is handed back as a local ref, make sure the caller's frame has room for all of them
+  env->EnsureLocalCapacity(fieldCount + LOCAL_FRAME_SIZE_SMALL);
   for(jsize i=0; i<fieldCount; i++) {
     jobject field = env->GetObjectArrayElement(fieldObjects, i);
     jint fieldModifiers = env->CallIntMethod(field, field_getModifiers);
@@ -46,6 +55,8 @@ void javaReflectionGetFields(JNIEnv *env, jclass clazz, std::list<jobject>* fiel
     fields->push_back(field);
   }
   env->DeleteLocalRef(fieldObjects);
+  env->DeleteLocalRef(fieldClazz);
+  env->DeleteLocalRef(clazzclazz);
 }
 
 std::string javaToString(JNIEnv *env, jstring str) {
@@ -158,20 +169,146 @@ jobject javaFindField(JNIEnv* env, jclass clazz, std::string& fieldName) {
   return result;
 }
 
+bool V8ConversionPath::enter(v8::Local<v8::Object> obj) {
+  if(m_failed) {
+    return false;
+  }
+  if(m_objects.size() >= V8_CONVERSION_MAX_DEPTH) {
+    std::ostringstream errStr;
+    errStr << "Could not convert to java, values are nested more than " << V8_CONVERSION_MAX_DEPTH << " levels deep";
+    m_error = errStr.str();
+    m_failed = true;
+    return false;
+  }
+  for(std::vector<v8::Local<v8::Object> >::iterator it = m_objects.begin(); it != m_objects.end(); it++) {
+    if(*it == obj) {
+      m_error = "Could not convert to java, the value contains itself";
+      m_failed = true;
+      return false;
+    }
+  }
+  m_objects.push_back(obj);
+  return true;
+}
+
+v8::Handle<v8::Value> V8ConversionPath::getError() {
+  return v8::Exception::TypeError(v8::String::New(m_error.c_str()));
+}
+
+/*
+ * Values nested in a map or list are converted the way JSON shaped data is expected in java:
+ * arrays become ArrayLists rather than Object[].
+ */
+jobject v8ToJavaCollectionItem(JNIEnv* env, v8::Local<v8::Value> arg, V8ConversionPath* path) {
+  if(arg->IsArray()) {
+    JavaConversionIds* ids = &javaConversionIds;
+    v8::Local<v8::Array> array = v8::Array::Cast(*arg);
+    if(!path->enter(array)) {
+      return NULL;
+    }
+    uint32_t arraySize = array->Length();
+    jobject result = env->NewObject(ids->arrayListClazz, ids->arrayList_init, (jint)arraySize);
+    for(uint32_t i=0; i<arraySize && !path->failed(); i++) {
+      jobject val = v8ToJavaCollectionItem(env, array->Get(i), path);
+      env->CallBooleanMethod(result, ids->collection_add, val);
+      env->DeleteLocalRef(val);
+    }
+    path->leave();
+    return result;
+  }
+  return v8ToJava(env, arg, path);
+}
+
+jobject v8ObjectToJavaMap(JNIEnv* env, v8::Local<v8::Object> obj, V8ConversionPath* path) {
+  JavaConversionIds* ids = &javaConversionIds;
+  if(!path->enter(obj)) {
+    return NULL;
+  }
+  v8::Local<v8::Array> keys = obj->GetOwnPropertyNames();
+  uint32_t keyCount = keys->Length();
+  jobject result = env->NewObject(ids->linkedHashMapClazz, ids->linkedHashMap_init, (jint)(keyCount * 4 / 3 + 1));
+  for(uint32_t i=0; i<keyCount && !path->failed(); i++) {
+    v8::Local<v8::Value> key = keys->Get(i);
+    jobject javaKey = v8ToJava(env, key->ToString(), path);
+    jobject javaValue = v8ToJavaCollectionItem(env, obj->Get(key), path);
+    jobject previous = env->CallObjectMethod(result, ids->map_put, javaKey, javaValue);
+    env->DeleteLocalRef(previous);
+    env->DeleteLocalRef(javaValue);
+    env->DeleteLocalRef(javaKey);
+  }
+  path->leave();
+  return result;
+}
+
+struct V8MapToJavaMapData {
+  JNIEnv* env;
+  jobject result;
+  V8ConversionPath* path;
+};
+
+v8::Handle<v8::Value> v8MapToJavaMapForEach(const v8::Arguments& args) {
+  V8MapToJavaMapData* data = (V8MapToJavaMapData*)v8::External::Unwrap(args.Data());
+  JNIEnv* env = data->env;
+  if(data->path->failed()) {
+    return v8::Undefined();
+  }
+  jobject javaKey = v8ToJavaCollectionItem(env, args[1], data->path);
+  jobject javaValue = v8ToJavaCollectionItem(env, args[0], data->path);
+  jobject previous = env->CallObjectMethod(data->result, javaConversionIds.map_put, javaKey, javaValue);
+  env->DeleteLocalRef(previous);
+  env->DeleteLocalRef(javaValue);
+  env->DeleteLocalRef(javaKey);
+  return v8::Undefined();
+}
+
+// javascript Map objects only expose their entries through forEach
+jobject v8MapToJavaMap(JNIEnv* env, v8::Local<v8::Object> map, v8::Local<v8::Function> forEach, V8ConversionPath* path) {
+  v8::HandleScope scope;
+  if(!path->enter(map)) {
+    return NULL;
+  }
+  V8MapToJavaMapData data;
+  data.env = env;
+  data.result = env->NewObject(javaConversionIds.linkedHashMapClazz, javaConversionIds.linkedHashMap_init, (jint)16);
+  data.path = path;
+  v8::Local<v8::FunctionTemplate> forEachCallbackTemplate = v8::FunctionTemplate::New(v8MapToJavaMapForEach, v8::External::Wrap(&data));
+  v8::Handle<v8::Value> argv[1];
+  argv[0] = forEachCallbackTemplate->GetFunction();
+  forEach->Call(map, 1, argv);
+  path->leave();
+  return data.result;
+}
+
+// for values that cannot fail to convert, such as strings and numbers
 jobject v8ToJava(JNIEnv* env, v8::Local<v8::Value> arg) {
+  V8ConversionPath path;
+  return v8ToJava(env, arg, &path);
+}
+
+/*
+ * Returns NULL and marks the path failed when the value contains itself or is nested too deeply.
+ * The caller checks path->failed() and throws path->getError().
+ */
+jobject v8ToJava(JNIEnv* env, v8::Local<v8::Value> arg, V8ConversionPath* path) {
+  JavaConversionIds* ids = &javaConversionIds;
+
   if(arg.IsEmpty() || arg->IsNull() || arg->IsUndefined()) {
     return NULL;
   }
 
   if(arg->IsArray()) {
     v8::Local<v8::Array> array = v8::Array::Cast(*arg);
+    if(!path->enter(array)) {
+      return NULL;
+    }
     uint32_t arraySize = array->Length();
-    jclass objectClazz = env->FindClass("java/lang/Object");
-    jobjectArray result = env->NewObjectArray(arraySize, objectClazz, NULL);
-    for(uint32_t i=0; i<arraySize; i++) {
-      jobject val = v8ToJava(env, array->Get(i));
+    jobjectArray result = env->NewObjectArray(arraySize, ids->objectClazz, NULL);
+    for(uint32_t i=0; i<arraySize && !path->failed(); i++) {
+      jobject val = v8ToJava(env, array->Get(i), path);
       env->SetObjectArrayElement(result, i, val);
+      env->DeleteLocalRef(val);
     }
+    path->leave();
     return result;
   }
 
@@ -182,76 +319,88 @@ jobject v8ToJava(JNIEnv* env, v8::Local<v8::Value> arg) {
 
   if(arg->IsInt32() || arg->IsUint32()) {
     jint val = arg->ToInt32()->Value();
-    jclass clazz = env->FindClass("java/lang/Integer");
-    jmethodID constructor = env->GetMethodID(clazz, "<init>", "(I)V");
-    return env->NewObject(clazz, constructor, val);
+    return env->NewObject(ids->integerClazz, ids->integer_init, val);
   }
 
   if(arg->IsNumber()) {
     jdouble val = arg->ToNumber()->Value();
-    jclass clazz = env->FindClass("java/lang/Double");
-    jmethodID constructor = env->GetMethodID(clazz, "<init>", "(D)V");
-    return env->NewObject(clazz, constructor, val);
+    return env->NewObject(ids->doubleClazz, ids->double_init, val);
   }
 
   if(arg->IsBoolean()) {
     jboolean val = arg->ToBoolean()->Value();
-    jclass clazz = env->FindClass("java/lang/Boolean");
-    jmethodID constructor = env->GetMethodID(clazz, "<init>", "(Z)V");
-    return env->NewObject(clazz, constructor, val);
+    return env->NewObject(ids->booleanClazz, ids->boolean_init, val);
+  }
+
+  if(TypedValue::HasInstance(arg)) {
+    return TypedValue::toJava(env, arg);
   }
 
   if(arg->IsObject()) {
     v8::Local<v8::Object> obj = v8::Object::Cast(*arg);
     v8::String::AsciiValue constructorName(obj->GetConstructorName());
+    if(strcmp(*constructorName, "Object") == 0) {
+      return v8ObjectToJavaMap(env, obj, path);
+    }
+    if(strcmp(*constructorName, "Map") == 0) {
+      v8::Local<v8::Value> forEach = obj->Get(v8::String::NewSymbol("forEach"));
+      if(forEach->IsFunction()) {
+        return v8MapToJavaMap(env, obj, v8::Local<v8::Function>::Cast(forEach), path);
+      }
+    }
     if(strcmp(*constructorName, "JavaObject") == 0) {
       JavaObject* javaObject = node::ObjectWrap::Unwrap<JavaObject>(obj);
       jobject jobj = javaObject->getObject();
       jclass nodeDynamicProxyClass = env->FindClass("node/NodeDynamicProxyClass");
+      bool isDynamicProxy = env->IsInstanceOf(jobj, nodeDynamicProxyClass);
 
-      if(env->IsInstanceOf(jobj, nodeDynamicProxyClass)) {
-        jfieldID ptrField = env->GetFieldID(nodeDynamicProxyClass, "ptr", "J");
-        DynamicProxyData* proxyData = (DynamicProxyData*)(long)env->GetLongField(jobj, ptrField);
-        if(!dynamicProxyDataVerify(proxyData)) {
-          return NULL;
-        }
-
-        jclass dynamicInterface = javaFindClass(env, proxyData->interfaceName);
-        if(dynamicInterface == NULL) {
-          printf("Could not find interface %s\n", proxyData->interfaceName.c_str());
-          return NULL;
-        }
-        jclass classClazz = env->FindClass("java/lang/Class");
-        jobjectArray classArray = env->NewObjectArray(1, classClazz, NULL);
-        env->SetObjectArrayElement(classArray, 0, dynamicInterface);
-
-        jmethodID class_getClassLoader = env->GetMethodID(classClazz, "getClassLoader", "()Ljava/lang/ClassLoader;");
-        jobject classLoader = env->CallObjectMethod(dynamicInterface, class_getClassLoader);
-        if(classLoader == NULL) {
-          jclass objectClazz = env->FindClass("java/lang/Object");
-          jmethodID object_getClass = env->GetMethodID(classClazz, "getClass", "()Ljava/lang/Class;");
-          jobject jobjClass = env->CallObjectMethod(jobj, object_getClass);
-          classLoader = env->CallObjectMethod(jobjClass, class_getClassLoader);
-        }
+      // callers own and delete what is returned, so never hand back the wrapper's global ref itself
+      if(!isDynamicProxy) {
+        env->DeleteLocalRef(nodeDynamicProxyClass);
+        return env->NewLocalRef(jobj);
+      }
+
+      jfieldID ptrField = env->GetFieldID(nodeDynamicProxyClass, "ptr", "J");
+      DynamicProxyData* proxyData = (DynamicProxyData*)(long)env->GetLongField(jobj, ptrField);
+      env->DeleteLocalRef(nodeDynamicProxyClass);
+      if(!dynamicProxyDataVerify(proxyData)) {
+        return NULL;
+      }
 
+      jclass dynamicInterface = javaFindClass(env, proxyData->interfaceName);
+      if(dynamicInterface == NULL) {
+        printf("Could not find interface %s\n", proxyData->interfaceName.c_str());
+        return NULL;
+      }
+      jclass classClazz = env->FindClass("java/lang/Class");
+      jobjectArray classArray = env->NewObjectArray(1, classClazz, NULL);
+      env->SetObjectArrayElement(classArray, 0, dynamicInterface);
+
+      jmethodID class_getClassLoader = env->GetMethodID(classClazz, "getClassLoader", "()Ljava/lang/ClassLoader;");
+      jobject classLoader = env->CallObjectMethod(dynamicInterface, class_getClassLoader);
+      if(classLoader == NULL) {
+        jmethodID object_getClass = env->GetMethodID(classClazz, "getClass", "()Ljava/lang/Class;");
+        jobject jobjClass = env->CallObjectMethod(jobj, object_getClass);
+        classLoader = env->CallObjectMethod(jobjClass, class_getClassLoader);
+        env->DeleteLocalRef(jobjClass);
+      }
+      env->DeleteLocalRef(classClazz);
+      env->DeleteLocalRef(dynamicInterface);
+
+      jobject result = NULL;
+      if(classLoader == NULL) {
+        printf("Could not get classloader for Proxy\n");
+      } else if(classArray == NULL) {
+        printf("Could not create class array for Proxy\n");
+      } else {
         jclass proxyClass = env->FindClass("java/lang/reflect/Proxy");
         jmethodID proxy_newProxyInstance = env->GetStaticMethodID(proxyClass, "newProxyInstance", "(Ljava/lang/ClassLoader;[Ljava/lang/Class;Ljava/lang/reflect/InvocationHandler;)Ljava/lang/Object;");
-        if(classLoader == NULL) {
-          printf("Could not get classloader for Proxy\n");
-          return NULL;
-        }
-        if(classArray == NULL) {
-          printf("Could not create class array for Proxy\n");
-          return NULL;
-        }
-        if(jobj == NULL) {
-          printf("Not a valid object to wrap\n");
-          return NULL;
-        }
-        jobj = env->CallStaticObjectMethod(proxyClass, proxy_newProxyInstance, classLoader, classArray, jobj);
+        result = env->CallStaticObjectMethod(proxyClass, proxy_newProxyInstance, classLoader, classArray, jobj);
+        env->DeleteLocalRef(proxyClass);
       }
-
-      return jobj;
+      env->DeleteLocalRef(classLoader);
+      env->DeleteLocalRef(classArray);
+      return result;
     }
   }
 
@@ -261,16 +410,18 @@ jobject v8ToJava(JNIEnv* env, v8::Local<v8::Value> arg) {
   return NULL;
 }
 
-jobjectArray v8ToJava(JNIEnv* env, const v8::Arguments& args, int start, int end) {
-  jclass clazz = env->FindClass("java/lang/Object");
-  jobjectArray results = env->NewObjectArray(end-start, clazz, NULL);
+jobjectArray v8ToJava(JNIEnv* env, const v8::Arguments& args, int start, int end, V8ConversionPath* path) {
+  jobjectArray results = env->NewObjectArray(end-start, javaConversionIds.objectClazz, NULL);
 
   for(int i=start; i<end; i++) {
-    jobject val = v8ToJava(env, args[i]);
+    jobject val = v8ToJava(env, args[i], path);
+    if(path->failed()) {
+      env->DeleteLocalRef(results);
+      return NULL;
+    }
     env->SetObjectArrayElement(results, i - start, val);
     env->DeleteLocalRef(val);
   }
-  env->DeleteLocalRef(clazz);
 
   return results;
 }
@@ -328,6 +479,7 @@ v8::Handle<v8::Value> javaArrayToV8(Java* java, JNIEnv* env, jobjectArray objArr
     jobject obj = env->GetObjectArrayElement(objArray, i);
     v8::Handle<v8::Value> item = javaToV8(java, env, obj);
     result->Set(i, item);
+    env->DeleteLocalRef(obj);
   }
 
   return scope.Close(result);
@@ -335,7 +487,8 @@ v8::Handle<v8::Value> javaArrayToV8(Java* java, JNIEnv* env, jobjectArray objArr
 
 v8::Handle<v8::Value> javaToV8(Java* java, JNIEnv* env, jobject obj) {
   v8::HandleScope scope;
-  PUSH_LOCAL_JAVA_FRAME();
+  // arrays delete each element as they go and JavaObject::New pushes its own frame
+  PUSH_LOCAL_JAVA_FRAME_SIZED(LOCAL_FRAME_SIZE_SMALL);
 
   if(obj == NULL) {
     POP_LOCAL_JAVA_FRAME_AND_RETURN(v8::Null());
@@ -420,7 +573,51 @@ jobjectArray javaObjectArrayToClasses(JNIEnv *env, jobjectArray objs) {
   return results;
 }
 
+/*
+ * Javascript arrays are passed as Object[]. When no method accepts that, the caller retries with the arrays
+ * replaced (in place) by ArrayLists so methods taking a List or Collection can be matched.
+ */
+bool javaObjectArrayArgsToLists(JNIEnv *env, jobjectArray methodArgs) {
+  JavaConversionIds* ids = &javaConversionIds;
+  bool changed = false;
+  jsize argsLength = env->GetArrayLength(methodArgs);
+  for(jsize i=0; i<argsLength; i++) {
+    jobject arg = env->GetObjectArrayElement(methodArgs, i);
+    if(arg == NULL) {
+      continue;
+    }
+    jclass argClazz = env->GetObjectClass(arg);
+    if(env->IsSameObject(argClazz, ids->objectArrayClazz)) {
+      jobject list = env->CallStaticObjectMethod(ids->arraysClazz, ids->arrays_asList, arg);
+      jobject arrayList = env->NewObject(ids->arrayListClazz, ids->arrayList_initCollection, list);
+      env->SetObjectArrayElement(methodArgs, i, arrayList);
+      env->DeleteLocalRef(arrayList);
+      env->DeleteLocalRef(list);
+      changed = true;
+    }
+    env->DeleteLocalRef(argClazz);
+    env->DeleteLocalRef(arg);
+  }
+  return changed;
+}
+
 jobject javaFindMethod(JNIEnv *env, jclass clazz, std::string& methodName, jobjectArray methodArgs) {
+  jobject method = javaFindMethodExact(env, clazz, methodName, methodArgs);
+  if(method == NULL && !env->ExceptionCheck() && javaObjectArrayArgsToLists(env, methodArgs)) {
+    method = javaFindMethodExact(env, clazz, methodName, methodArgs);
+  }
+  return method;
+}
+
+jobject javaFindConstructor(JNIEnv *env, jclass clazz, jobjectArray methodArgs) {
+  jobject method = javaFindConstructorExact(env, clazz, methodArgs);
+  if(method == NULL && !env->ExceptionCheck() && javaObjectArrayArgsToLists(env, methodArgs)) {
+    method = javaFindConstructorExact(env, clazz, methodArgs);
+  }
+  return method;
+}
+
+jobject javaFindMethodExact(JNIEnv *env, jclass clazz, std::string& methodName, jobjectArray methodArgs) {
   jclass methodUtilsClazz = env->FindClass("com/nearinfinity/org/apache/commons/lang3/reflect/MethodUtils");
   jmethodID methodUtils_getMatchingAccessibleMethod = env->GetStaticMethodID(methodUtilsClazz, "getMatchingAccessibleMethod", "(Ljava/lang/Class;Ljava/lang/String;[Ljava/lang/Class;)Ljava/lang/reflect/Method;");
   const char *methodNameCStr = methodName.c_str();
@@ -435,7 +632,7 @@ jobject javaFindMethod(JNIEnv *env, jclass clazz, std::string& methodName, jobje
   return method;
 }
 
-jobject javaFindConstructor(JNIEnv *env, jclass clazz, jobjectArray methodArgs) {
+jobject javaFindConstructorExact(JNIEnv *env, jclass clazz, jobjectArray methodArgs) {
   jclass constructorUtilsClazz = env->FindClass("com/nearinfinity/org/apache/commons/lang3/reflect/ConstructorUtils");
   jmethodID constructorUtils_getMatchingAccessibleConstructor = env->GetStaticMethodID(constructorUtilsClazz, "getMatchingAccessibleConstructor", "(Ljava/lang/Class;[Ljava/lang/Class;)Ljava/lang/reflect/Constructor;");
   jobjectArray methodArgClasses = javaObjectArrayToClasses(env, methodArgs);
@@ -458,3 +655,19 @@ int dynamicProxyDataVerify(DynamicProxyData* data) {
   printf("*** ERROR: Lost reference to the dynamic proxy. You must maintain a reference in javascript land using ref() and unref(). ***\n");
   return 0;
 }
+
+/*
+ * node::Buffer::New creates a SlowBuffer, which javascript streams do not accept as a Buffer. Wrap it
+ * with the javascript Buffer constructor the same way node's own bindings do.
+ */
+v8::Handle<v8::Value> bytesToV8Buffer(const char* data, size_t length) {
+  v8::HandleScope scope;
+  node::Buffer* slowBuffer = node::Buffer::New(data, length);
+  v8::Local<v8::Object> global = v8::Context::GetCurrent()->Global();
+  v8::Local<v8::Function> bufferConstructor = v8::Local<v8::Function>::Cast(global->Get(v8::String::NewSymbol("Buffer")));
+  v8::Handle<v8::Value> constructorArgs[3];
+  constructorArgs[0] = slowBuffer->handle_;
+  constructorArgs[1] = v8::Integer::New(length);
+  constructorArgs[2] = v8::Integer::New(0);
+  return scope.Close(bufferConstructor->NewInstance(3, constructorArgs));
+}
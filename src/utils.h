@@ -9,6 +9,8 @@
 #include <vector>
 #include <string>
 #include <uv.h>
+#include "callOptions.h"
+#include "refStats.h"
 
 class Java;
 
@@ -39,6 +41,31 @@ struct DynamicProxyData {
 
 #define LOCAL_FRAME_SIZE 500
 
+// deeper nesting than this is refused when converting v8 values to java
+#define V8_CONVERSION_MAX_DEPTH 1000
+
+/*
+ * The objects and arrays a v8 value is being converted inside of. A value that contains itself, or is
+ * nested deeper than V8_CONVERSION_MAX_DEPTH, is refused instead of recursing until the stack
+ * overflows; the conversion then stops early and getError returns the TypeError to throw.
+ */
+class V8ConversionPath {
+public:
+  V8ConversionPath() : m_failed(false) {}
+  bool enter(v8::Local<v8::Object> obj);
+  void leave() { m_objects.pop_back(); }
+  bool failed() { return m_failed; }
+  v8::Handle<v8::Value> getError();
+
+private:
+  std::vector<v8::Local<v8::Object> > m_objects;
+  bool m_failed;
+  std::string m_error;
+};
+
+// enough for converting a single value that does not recurse into a JavaObject
+#define LOCAL_FRAME_SIZE_SMALL 16
+
 #define DYNAMIC_PROXY_DATA_MARKER_START 0x12345678
 #define DYNAMIC_PROXY_DATA_MARKER_END   0x87654321
 
@@ -51,12 +78,14 @@ std::string javaObjectToString(JNIEnv *env, jobject obj);
 JNIEnv* javaAttachCurrentThread(JavaVM* jvm);
 void javaDetachCurrentThread(JavaVM* jvm);
 jvalueType javaGetType(JNIEnv *env, jclass type);
-jobjectArray v8ToJava(JNIEnv* env, const v8::Arguments& args, int start, int end);
+jobjectArray v8ToJava(JNIEnv* env, const v8::Arguments& args, int start, int end, V8ConversionPath* path);
+jobject v8ToJava(JNIEnv* env, v8::Local<v8::Value> arg, V8ConversionPath* path);
 jobject v8ToJava(JNIEnv* env, v8::Local<v8::Value> arg);
 v8::Handle<v8::Value> javaExceptionToV8(JNIEnv* env, const std::string& alternateMessage);
 v8::Handle<v8::Value> javaExceptionToV8(JNIEnv* env, jthrowable ex, const std::string& alternateMessage);
 v8::Handle<v8::Value> javaArrayToV8(Java* java, JNIEnv* env, jobjectArray objArray);
 v8::Handle<v8::Value> javaToV8(Java* java, JNIEnv* env, jobject obj);
+v8::Handle<v8::Value> bytesToV8Buffer(const char* data, size_t length);
 jobjectArray javaObjectArrayToClasses(JNIEnv *env, jobjectArray objs);
 jobject longToJavaLongObj(JNIEnv *env, long l);
 
@@ -64,6 +93,9 @@ jclass javaFindClass(JNIEnv* env, std::string& className);
 jobject javaFindField(JNIEnv* env, jclass clazz, std::string& fieldName);
 jobject javaFindMethod(JNIEnv *env, jclass clazz, std::string& methodName, jobjectArray methodArgs);
 jobject javaFindConstructor(JNIEnv *env, jclass clazz, jobjectArray methodArgs);
+jobject javaFindMethodExact(JNIEnv *env, jclass clazz, std::string& methodName, jobjectArray methodArgs);
+jobject javaFindConstructorExact(JNIEnv *env, jclass clazz, jobjectArray methodArgs);
+bool javaObjectArrayArgsToLists(JNIEnv *env, jobjectArray methodArgs);
 
 #define UNUSED_VARIABLE(var) var = var;
 
@@ -101,6 +133,13 @@ jobject javaFindConstructor(JNIEnv *env, jclass clazz, jobjectArray methodArgs);
     callbackProvided = false;                 \
   }
 
+#define ARGS_BACK_CALL_OPTIONS() \
+  CallOptions* callOptions = NULL;                                                                     \
+  if(argsEnd > argsStart && CallOptions::HasInstance(args[argsEnd-1])) {                               \
+    callOptions = node::ObjectWrap::Unwrap<CallOptions>(v8::Local<v8::Object>::Cast(args[argsEnd-1])); \
+    argsEnd--;                                                                                         \
+  }
+
 #define EXCEPTION_CALL_CALLBACK(STRBUILDER) \
   std::ostringstream errStr;                                                            \
   errStr << STRBUILDER;                                                                 \
@@ -120,13 +159,16 @@ jobject javaFindConstructor(JNIEnv *env, jclass clazz, jobjectArray methodArgs);
   }
 
 #define PUSH_LOCAL_JAVA_FRAME() \
-  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  javaPushLocalFrame(env, LOCAL_FRAME_SIZE);
+
+#define PUSH_LOCAL_JAVA_FRAME_SIZED(CAPACITY) \
+  javaPushLocalFrame(env, (CAPACITY));
 
 #define POP_LOCAL_JAVA_FRAME() \
-  env->PopLocalFrame(NULL);
+  javaPopLocalFrame(env, NULL);
 
 #define POP_LOCAL_JAVA_FRAME_AND_RETURN(r) \
-  env->PopLocalFrame(NULL); \
+  javaPopLocalFrame(env, NULL); \
   return r;
 
 #endif
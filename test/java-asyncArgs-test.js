@@ -0,0 +1,131 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Async Arguments'] = nodeunit.testCase({
+  "strings and numbers pick the same overload as sync calls": function(test) {
+    java.callStaticMethod("Test", "staticMethodOverload", "a", function(err, result) {
+      test.ok(!err);
+      test.equal(result, 1);
+      java.callStaticMethod("Test", "staticMethodOverload", 1, function(err, result) {
+        test.ok(!err);
+        test.equal(result, 2);
+        test.done();
+      });
+    });
+  },
+
+  "large strings are passed": function(test) {
+    var str = new Array(100001).join("x");
+    java.callStaticMethod("java.lang.String", "valueOf", str, function(err, result) {
+      test.ok(!err);
+      test.equal(result.length, 100000);
+      test.done();
+    });
+  },
+
+  "arrays and objects are converted like sync calls": function(test) {
+    java.callStaticMethod("java.util.Arrays", "asList", ["a", "b", "c"], function(err, list) {
+      test.ok(!err);
+      test.equal(list.sizeSync(), 3);
+      var map = java.newInstanceSync("java.util.HashMap");
+      map.putAll({ a: 1, b: [1, 2] }, function(err) {
+        test.ok(!err);
+        test.equal(map.getSync("a"), 1);
+        test.equal(map.getSync("b").getClassSync().getNameSync(), "java.util.ArrayList");
+        test.done();
+      });
+    });
+  },
+
+  "java objects are passed": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    list.add("item", function(err) {
+      test.ok(!err);
+      java.newInstance("java.util.ArrayList", list, function(err, copy) {
+        test.ok(!err);
+        test.equal(copy.sizeSync(), 1);
+        test.done();
+      });
+    });
+  },
+
+  "repeated calls reuse the resolved method": function(test) {
+    java.callStaticMethod("java.lang.Math", "abs", -1, function(err, result) {
+      test.ok(!err);
+      var before = java.getAsyncStats().methodCache;
+      java.callStaticMethod("java.lang.Math", "abs", -2, function(err, result) {
+        test.ok(!err);
+        test.equal(result, 2);
+        var after = java.getAsyncStats().methodCache;
+        test.equal(after.hits, before.hits + 1);
+        test.equal(after.size, before.size);
+        test.done();
+      });
+    });
+  },
+
+  "java object arguments reuse the resolved method": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    java.callStaticMethod("java.util.Collections", "unmodifiableList", list, function(err, result) {
+      test.ok(!err);
+      var before = java.getAsyncStats().methodCache;
+      java.callStaticMethod("java.util.Collections", "unmodifiableList", java.newInstanceSync("java.util.ArrayList"), function(err, result) {
+        test.ok(!err);
+        test.equal(result.sizeSync(), 0);
+        var after = java.getAsyncStats().methodCache;
+        test.equal(after.hits, before.hits + 1);
+        test.equal(after.size, before.size);
+        test.done();
+      });
+    });
+  },
+
+  "other argument types resolve their own overload": function(test) {
+    java.callStaticMethod("java.lang.Math", "abs", -1.5, function(err, result) {
+      test.ok(!err);
+      test.equal(result, 1.5);
+      test.done();
+    });
+  },
+
+  "batons are reused": function(test) {
+    java.callStaticMethod("java.lang.String", "valueOf", 1, function(err) {
+      test.ok(!err);
+      // the baton is returned to the pool once its callback has returned
+      setTimeout(function() {
+        var before = java.getAsyncStats().batonPool;
+        java.callStaticMethod("java.lang.String", "valueOf", 2, function(err) {
+          test.ok(!err);
+          var after = java.getAsyncStats().batonPool;
+          test.equal(after.reused, before.reused + 1);
+          test.equal(after.allocated, before.allocated);
+          test.done();
+        });
+      }, 0);
+    });
+  },
+
+  "a missing method is reported through the callback": function(test) {
+    var calledBack = false;
+    java.callStaticMethod("java.lang.String", "noSuchMethod", 1, function(err, result) {
+      calledBack = true;
+      test.ok(err);
+      test.ok(/Could not find method/.test(err.message));
+      test.done();
+    });
+    test.ok(!calledBack);
+  },
+
+  "a cyclic argument throws": function(test) {
+    var obj = { name: "bob" };
+    obj.children = [ obj ];
+    test.throws(function() {
+      java.newInstance("java.util.HashMap", obj, function(err, result) {
+        test.ok(false, "the call should not be queued");
+      });
+    }, TypeError);
+    test.done();
+  }
+});
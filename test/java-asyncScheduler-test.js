@@ -0,0 +1,81 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Async Scheduler'] = nodeunit.testCase({
+  tearDown: function(callback) {
+    java.setAsyncOptions({ maxInFlight: 0, maxQueueDepth: 0, onQueueFull: 'reject', drain: null });
+    callback();
+  },
+
+  "interactive calls overtake bulk calls": function(test) {
+    java.setAsyncOptions({ maxInFlight: 1 });
+    var order = [];
+    var bulk = java.callOptions({ priority: 'bulk' });
+    var interactive = java.callOptions({ priority: 'interactive' });
+    java.callStaticMethod("Test", "staticMethod", 1, bulk, function(err, result) {
+      test.ok(!err);
+      order.push(result);
+    });
+    java.callStaticMethod("Test", "staticMethod", 2, bulk, function(err, result) {
+      test.ok(!err);
+      order.push(result);
+      test.deepEqual(order, [2, 4, 3]);
+      test.done();
+    });
+    java.callStaticMethod("Test", "staticMethod", 3, interactive, function(err, result) {
+      test.ok(!err);
+      order.push(result);
+    });
+    var stats = java.getAsyncStats();
+    test.equal(stats.inFlight, 1);
+    test.equal(stats.queued, 2);
+    test.equal(stats.queuedByPriority.bulk, 1);
+    test.equal(stats.queuedByPriority.interactive, 1);
+  },
+
+  "queue full rejects": function(test) {
+    java.setAsyncOptions({ maxInFlight: 1, maxQueueDepth: 1, onQueueFull: 'reject' });
+    var rejectedBefore = java.getAsyncStats().rejected;
+    java.callStaticMethod("Test", "staticMethod", 1, function(err, result) {});
+    java.callStaticMethod("Test", "staticMethod", 2, function(err, result) {
+      test.ok(!err);
+      test.equal(java.getAsyncStats().rejected, rejectedBefore + 1);
+      test.done();
+    });
+    var returned = false;
+    test.strictEqual(java.callStaticMethod("Test", "staticMethod", 3, function(err, result) {
+      test.ok(returned);
+      test.ok(err);
+      test.equal(err.code, 'EQUEUEFULL');
+      test.ok(!result);
+    }), false);
+    returned = true;
+  },
+
+  "queue full applies backpressure": function(test) {
+    var drained = false;
+    java.setAsyncOptions({
+      maxInFlight: 1,
+      maxQueueDepth: 1,
+      onQueueFull: 'backpressure',
+      drain: function() { drained = true; }
+    });
+    test.notStrictEqual(java.callStaticMethod("Test", "staticMethod", 1, function(err, result) {}), false);
+    test.strictEqual(java.callStaticMethod("Test", "staticMethod", 2, function(err, result) {}), false);
+    test.strictEqual(java.callStaticMethod("Test", "staticMethod", 3, function(err, result) {
+      test.ok(!err);
+      test.equal(result, 4);
+      test.ok(drained);
+      test.done();
+    }), false);
+  },
+
+  "invalid priority": function(test) {
+    test.throws(function() {
+      java.callOptions({ priority: 'urgent' });
+    });
+    test.done();
+  }
+});
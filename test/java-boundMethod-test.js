@@ -0,0 +1,135 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Bound Method'] = nodeunit.testCase({
+  "static method with param types": function(test) {
+    var max = java.getMethod("java.lang.Math", "max", ["int", "int"]);
+    test.equal(max(3, 7), 7);
+    test.equal(max(-3, -7), -3);
+    test.done();
+  },
+
+  "static method resolved by name": function(test) {
+    var staticMethodThrows = java.getMethod("Test", "staticMethodThrows");
+    test.throws(function() {
+      staticMethodThrows(java.newInstanceSync("java.lang.Exception", "bound"));
+    }, /bound/);
+    test.done();
+  },
+
+  "overloaded method requires param types": function(test) {
+    test.throws(function() {
+      java.getMethod("Test", "staticMethod");
+    }, /overloaded/);
+    var staticMethod = java.getMethod("Test", "staticMethod", []);
+    test.equal(staticMethod(), "staticMethod called");
+    test.done();
+  },
+
+  "bridge methods do not count as overloads": function(test) {
+    var compareTo = java.getInstanceMethod("java.util.Date", "compareTo");
+    var date = java.newInstanceSync("java.util.Date");
+    test.equal(compareTo(date, date), 0);
+    var reverse = java.getInstanceMethod("java.lang.StringBuilder", "reverse");
+    test.equal(reverse(java.newInstanceSync("java.lang.StringBuilder", "abc")).toStringSync(), "cba");
+    test.done();
+  },
+
+  "primitive return types": function(test) {
+    test.equal(java.getMethod("java.lang.Long", "parseLong", ["java.lang.String"])("1234567890123"), 1234567890123);
+    test.equal(java.getMethod("java.lang.Math", "sqrt", ["double"])(16), 4);
+    test.equal(java.getMethod("java.lang.Boolean", "parseBoolean", ["java.lang.String"])("true"), true);
+    test.equal(java.getMethod("java.lang.Character", "toUpperCase", ["char"])("a"), "A");
+    test.done();
+  },
+
+  "instance method": function(test) {
+    var add = java.getInstanceMethod("java.util.ArrayList", "add", ["java.lang.Object"]);
+    var size = java.getInstanceMethod("java.util.ArrayList", "size");
+    var list = java.newInstanceSync("java.util.ArrayList");
+    test.equal(add(list, "a"), true);
+    test.equal(add(list, 5), true);
+    test.equal(size(list), 2);
+    test.equal(list.getSync(1), 5);
+    test.done();
+  },
+
+  "instance method checks the object": function(test) {
+    var size = java.getInstanceMethod("java.util.ArrayList", "size");
+    test.throws(function() {
+      size(java.newInstanceSync("java.util.HashMap"));
+    }, TypeError);
+    test.throws(function() {
+      size();
+    }, TypeError);
+    test.done();
+  },
+
+  "argument count and types are checked": function(test) {
+    var max = java.getMethod("java.lang.Math", "max", ["int", "int"]);
+    test.throws(function() { max(1); }, TypeError);
+    test.throws(function() { max("a", 1); }, TypeError);
+    test.done();
+  },
+
+  "async call": function(test) {
+    var valueOf = java.getMethod("java.lang.String", "valueOf", ["int"]);
+    valueOf(42, function(err, result) {
+      test.ok(!err);
+      test.equal(result, "42");
+      test.done();
+    });
+  },
+
+  "async instance call with object argument": function(test) {
+    var add = java.getInstanceMethod("java.util.ArrayList", "add", ["java.lang.Object"]);
+    var list = java.newInstanceSync("java.util.ArrayList");
+    add(list, "async", function(err, result) {
+      test.ok(!err);
+      test.equal(result, true);
+      test.equal(list.getSync(0), "async");
+      test.done();
+    });
+  },
+
+  "async error": function(test) {
+    var parseInt = java.getMethod("java.lang.Integer", "parseInt", ["java.lang.String"]);
+    parseInt("not a number", function(err, result) {
+      test.ok(err);
+      test.ok(!result);
+      test.done();
+    });
+  },
+
+  "unknown method": function(test) {
+    test.throws(function() {
+      java.getMethod("java.lang.Math", "notAMethod");
+    });
+    test.throws(function() {
+      java.getMethod("java.lang.Math", "max", ["notAType"]);
+    });
+    test.throws(function() {
+      java.getInstanceMethod("java.lang.Math", "max", ["int", "int"]);
+    }, /static/);
+    test.done();
+  },
+
+  "object arguments are checked against the parameter type": function(test) {
+    var unmodifiableList = java.getMethod("java.util.Collections", "unmodifiableList", ["java.util.List"]);
+    test.throws(function() {
+      unmodifiableList(java.newInstanceSync("java.util.HashMap"));
+    }, /java\.util\.List/);
+    test.equal(unmodifiableList(java.newInstanceSync("java.util.ArrayList")).sizeSync(), 0);
+    test.done();
+  },
+
+  "binding the same method again returns the same function": function(test) {
+    var max = java.getMethod("java.lang.Math", "max", ["int", "int"]);
+    test.strictEqual(java.getMethod("java.lang.Math", "max", ["int", "int"]), max);
+    test.notStrictEqual(java.getMethod("java.lang.Math", "max", ["long", "long"]), max);
+    test.strictEqual(java.getMethod("java.lang.Math", "max", "(II)I"), java.getMethod("java.lang.Math", "max", "(II)I"));
+    test.done();
+  }
+});
@@ -0,0 +1,74 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Call Cancellation'] = nodeunit.testCase({
+  tearDown: function(callback) {
+    java.setAsyncOptions({ maxInFlight: 0 });
+    callback();
+  },
+
+  "timeout interrupts a running call": function(test) {
+    var start = new Date().getTime();
+    var options = java.callOptions({ timeout: 100 });
+    java.callStaticMethod("java.lang.Thread", "sleep", 5000, options, function(err, result) {
+      test.ok(err);
+      test.equal(err.code, 'ETIMEDOUT');
+      test.ok(new Date().getTime() - start < 5000);
+      test.done();
+    });
+  },
+
+  "call finishing before its timeout": function(test) {
+    var options = java.callOptions({ timeout: 5000 });
+    java.callStaticMethod("Test", "staticMethod", 42, options, function(err, result) {
+      test.ok(!err);
+      test.equal(result, 43);
+      test.done();
+    });
+  },
+
+  "cancel drops a queued call": function(test) {
+    java.setAsyncOptions({ maxInFlight: 1 });
+    var options = java.callOptions({});
+    var cancelled = false;
+    java.callStaticMethod("java.lang.Thread", "sleep", 100, function(err, result) {
+      test.ok(!err);
+      test.ok(cancelled);
+      test.done();
+    });
+    java.callStaticMethod("Test", "staticMethod", 42, options, function(err, result) {
+      test.ok(err);
+      test.equal(err.code, 'ECANCELED');
+      test.ok(!result);
+      cancelled = true;
+    });
+    test.equal(java.getAsyncStats().queued, 1);
+    options.cancel();
+    test.equal(java.getAsyncStats().queued, 0);
+  },
+
+  "cancel calls back on a later turn and can be called again from the callback": function(test) {
+    java.setAsyncOptions({ maxInFlight: 1 });
+    var options = java.callOptions({});
+    var returned = false;
+    var errors = [];
+    java.callStaticMethod("java.lang.Thread", "sleep", 100, function(err, result) {
+      test.ok(!err);
+      test.equal(errors.length, 2);
+      test.done();
+    });
+    for (var i = 0; i < 2; i++) {
+      java.callStaticMethod("Test", "staticMethod", 42, options, function(err, result) {
+        test.ok(returned);
+        test.equal(err.code, 'ECANCELED');
+        errors.push(err);
+        options.cancel();
+      });
+    }
+    options.cancel();
+    returned = true;
+    test.equal(java.getAsyncStats().queued, 0);
+  }
+});
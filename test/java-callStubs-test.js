@@ -0,0 +1,52 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Call Stubs'] = nodeunit.testCase({
+  "static stubs": function(test) {
+    test.equal(java.stubs["java.lang.Math"].maxSync(3, 7), 7);
+    test.equal(java.stubs["java.lang.Math"].maxDoubleSync(1.5, -2), 1.5);
+    test.equal(java.stubs["java.lang.Integer"].parseIntSync("42"), 42);
+    test.equal(java.stubs["java.lang.Integer"].toStringRadixSync(255, 16), "ff");
+    test.done();
+  },
+
+  "instance stubs": function(test) {
+    var sb = java.newInstanceSync("java.lang.StringBuilder");
+    var stubs = java.stubs["java.lang.StringBuilder"];
+    stubs.appendSync(sb, "abc");
+    test.equal(stubs.lengthSync(sb), 3);
+    test.equal(stubs.charAtSync(sb, 1), "b");
+    test.equal(stubs.setLengthSync(sb, 1), undefined);
+    test.equal(sb.toStringSync(), "a");
+
+    var list = java.newInstanceSync("java.util.ArrayList");
+    test.equal(java.stubs["java.util.ArrayList"].addSync(list, "x"), true);
+    test.equal(java.stubs["java.util.ArrayList"].getSync(list, 0), "x");
+    test.equal(java.stubs["java.util.ArrayList"].sizeSync(list), 1);
+    test.done();
+  },
+
+  "bad arguments throw": function(test) {
+    test.throws(function() { java.stubs["java.lang.Math"].maxSync(3); });
+    test.throws(function() { java.stubs["java.lang.Math"].maxSync(3, "7"); }, /Argument 2 .* must be a number/);
+    test.throws(function() { java.stubs["java.lang.StringBuilder"].lengthSync(java.newInstanceSync("java.util.ArrayList")); });
+    test.done();
+  },
+
+  "object arguments are checked against the parameter class": function(test) {
+    var stubs = java.stubs["java.util.ArrayList"];
+    var list = java.newInstanceSync("java.util.ArrayList");
+    test.equal(stubs.addAllSync(list, java.newInstanceSync("java.util.ArrayList")), false);
+    test.throws(function() {
+      stubs.addAllSync(list, java.newInstanceSync("java.util.HashMap"));
+    }, /Argument 2 .* must be an instance of java\.util\.Collection/);
+    test.done();
+  },
+
+  "java exceptions are thrown": function(test) {
+    test.throws(function() { java.stubs["java.lang.Integer"].parseIntSync("x"); });
+    test.done();
+  }
+});
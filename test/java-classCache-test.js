@@ -0,0 +1,69 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Class Cache'] = nodeunit.testCase({
+  "repeated static calls hit the cache": function(test) {
+    java.callStaticMethodSync("java.lang.Integer", "valueOf", 1);
+    var before = java.getClassCacheStats();
+    for(var i=0; i<10; i++) {
+      java.callStaticMethodSync("java.lang.Integer", "valueOf", i);
+    }
+    var after = java.getClassCacheStats();
+    test.equal(after.hits, before.hits + 10);
+    test.equal(after.misses, before.misses);
+    test.done();
+  },
+
+  "constructors and static fields share the cache": function(test) {
+    java.newInstanceSync("java.util.ArrayList");
+    var before = java.getClassCacheStats();
+    java.newInstanceSync("java.util.ArrayList");
+    java.findClassSync("java.util.ArrayList");
+    java.newArray("java.util.ArrayList", []);
+    test.equal(java.getClassCacheStats().hits, before.hits + 3);
+    test.done();
+  },
+
+  "classes that fail to load are not cached": function(test) {
+    var before = java.getClassCacheStats();
+    test.throws(function() {
+      java.findClassSync("does.not.Exist");
+    });
+    var after = java.getClassCacheStats();
+    test.equal(after.size, before.size);
+    test.equal(after.misses, before.misses + 1);
+    test.done();
+  },
+
+  "evictClass drops one class": function(test) {
+    java.callStaticMethodSync("java.lang.Long", "valueOf", 1);
+    var before = java.getClassCacheStats();
+    test.equal(java.evictClass("java.lang.Long"), true);
+    test.equal(java.evictClass("java.lang.Long"), false);
+    var after = java.getClassCacheStats();
+    test.equal(after.size, before.size - 1);
+    test.equal(after.evictions, before.evictions + 1);
+    test.equal(java.callStaticMethodSync("java.lang.Long", "valueOf", 5), 5);
+    test.equal(java.getClassCacheStats().misses, after.misses + 1);
+    test.done();
+  },
+
+  "async calls survive eviction": function(test) {
+    java.callStaticMethod("java.lang.String", "valueOf", 3, function(err, result) {
+      test.ok(!err);
+      test.equal(result, "3");
+      test.done();
+    });
+    java.clearClassCache();
+  },
+
+  "clearClassCache releases the refs": function(test) {
+    java.callStaticMethodSync("java.lang.Short", "valueOf", "1");
+    java.clearClassCache();
+    test.equal(java.getClassCacheStats().size, 0);
+    test.equal(java.refStats().globalRefs.live.classCache, 0);
+    test.done();
+  }
+});
@@ -0,0 +1,55 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Collection Conversion'] = nodeunit.testCase({
+  tearDown: function(callback) {
+    java.setConversionOptions({ collections: false, depth: 10, mapType: 'object' });
+    callback();
+  },
+
+  "collections are wrapped by default": function(test) {
+    var result = java.callStaticMethodSync("java.util.Collections", "singletonList", "a");
+    test.equal(result.sizeSync(), 1);
+    test.done();
+  },
+
+  "list of maps (sync)": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    list.addSync(java.callStaticMethodSync("java.util.Collections", "singletonMap", "name", "bob"));
+    list.addSync(java.callStaticMethodSync("java.util.Collections", "singletonMap", "age", 42));
+    var options = java.callOptions({ collections: true });
+    var result = java.callStaticMethodSync("java.util.Collections", "unmodifiableList", list, options);
+    test.deepEqual(result, [ { name: "bob" }, { age: 42 } ]);
+    test.done();
+  },
+
+  "list of maps (async)": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    list.addSync("a");
+    list.addSync(java.callStaticMethodSync("java.util.Collections", "singletonList", 1.5));
+    var options = java.callOptions({ collections: true });
+    list.subList(0, 2, options, function(err, result) {
+      test.ok(!err);
+      test.deepEqual(result, [ "a", [ 1.5 ] ]);
+      test.done();
+    });
+  },
+
+  "depth limit": function(test) {
+    java.setConversionOptions({ collections: true, depth: 1 });
+    var inner = java.callStaticMethodSync("java.util.Collections", "singletonList", "b");
+    var result = java.callStaticMethodSync("java.util.Collections", "singletonList", inner);
+    test.equal(result.length, 1);
+    test.equal(result[0].getSync(0), "b");
+    test.done();
+  },
+
+  "invalid options": function(test) {
+    test.throws(function() {
+      java.setConversionOptions({ mapType: 'hash' });
+    });
+    test.done();
+  }
+});
@@ -0,0 +1,42 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Event Ring'] = nodeunit.testCase({
+  "appends are delivered in one batch": function(test) {
+    var ring = java.createEventRing({ recordSize: 4, capacity: 16 }, function(buffer, count) {
+      test.equal(count, 3);
+      test.equal(buffer.length, 12);
+      test.equal(buffer.toString(), "aaaabbbbcccc");
+      ring.close();
+      test.done();
+    });
+    test.ok(ring.javaObject.appendSync(java.newArray("byte", new Buffer("aaaa"))));
+    test.ok(ring.javaObject.appendSync(java.newArray("byte", new Buffer("bbbbcccc")), 0, 2));
+  },
+
+  "full ring drops records": function(test) {
+    var ring = java.createEventRing({ recordSize: 1, capacity: 2 }, function(buffer, count) {
+      test.equal(count, 2);
+      test.equal(ring.getStats().dropped, 1);
+      ring.close();
+      test.done();
+    });
+    test.equal(ring.javaObject.appendSync(java.newArray("byte", new Buffer("abc")), 0, 3), false);
+  },
+
+  "closed ring rejects appends": function(test) {
+    var ring = java.createEventRing({ recordSize: 1 }, function() {});
+    ring.close();
+    test.equal(ring.javaObject.appendSync(java.newArray("byte", new Buffer("a"))), false);
+    test.done();
+  },
+
+  "invalid record size": function(test) {
+    test.throws(function() {
+      java.createEventRing({ recordSize: 0 }, function() {});
+    });
+    test.done();
+  }
+});
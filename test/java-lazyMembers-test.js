@@ -0,0 +1,54 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Lazy Members'] = nodeunit.testCase({
+  "methods are shared by objects of a class": function(test) {
+    var list1 = java.newInstanceSync("java.util.ArrayList");
+    var list2 = java.newInstanceSync("java.util.ArrayList");
+    test.equal(typeof list1.addSync, "function");
+    test.strictEqual(list1.addSync, list2.addSync);
+    test.strictEqual(list1.add, list2.add);
+    test.notStrictEqual(list1.add, list1.addSync);
+    list1.addSync("a");
+    test.equal(list1.sizeSync(), 1);
+    test.equal(list2.sizeSync(), 0);
+    test.done();
+  },
+
+  "async methods": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    list.add("a", function(err, result) {
+      test.ok(!err);
+      test.equal(result, true);
+      test.done();
+    });
+  },
+
+  "members are enumerable": function(test) {
+    var obj = java.newInstanceSync("Test");
+    var keys = Object.keys(obj);
+    test.ok(keys.indexOf("getInt") >= 0);
+    test.ok(keys.indexOf("getIntSync") >= 0);
+    test.ok(keys.indexOf("nonstaticInt") >= 0);
+    test.ok("getIntSync" in obj);
+    test.ok(!("noSuchMethodSync" in obj));
+    test.equal(obj.noSuchMethodSync, undefined);
+    test.done();
+  },
+
+  "fields": function(test) {
+    var obj = java.newInstanceSync("Test");
+    test.equal(obj.nonstaticInt, 42);
+    obj.nonstaticInt = 12;
+    test.equal(obj.nonstaticInt, 12);
+    test.done();
+  },
+
+  "objects are still java objects": function(test) {
+    var obj = java.newInstanceSync("Test");
+    test.equal(java.callStaticMethodSync("java.lang.String", "valueOf", obj).indexOf("Test@"), 0);
+    test.done();
+  }
+});
@@ -0,0 +1,61 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Map Conversion'] = nodeunit.testCase({
+  "object to map": function(test) {
+    var map = java.newInstanceSync("java.util.HashMap", { name: "bob", age: 42 });
+    test.equal(map.sizeSync(), 2);
+    test.equal(map.getSync("name"), "bob");
+    test.equal(map.getSync("age"), 42);
+    test.done();
+  },
+
+  "nested arrays become lists": function(test) {
+    var map = java.newInstanceSync("java.util.HashMap", { items: [ "a", "b" ], child: { value: 1.5 } });
+    test.equal(map.getSync("items").sizeSync(), 2);
+    test.equal(map.getSync("items").getSync(1), "b");
+    test.equal(map.getSync("child").getSync("value"), 1.5);
+    test.done();
+  },
+
+  "array to collection": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList", [ "a", "b", "c" ]);
+    test.equal(list.sizeSync(), 3);
+    list.addAll([ "d" ], function(err, result) {
+      test.ok(!err);
+      test.equal(list.sizeSync(), 4);
+      test.equal(list.getSync(3), "d");
+      test.done();
+    });
+  },
+
+  "array to object array": function(test) {
+    var list = java.callStaticMethodSync("java.util.Arrays", "asList", [ "a", "b" ]);
+    test.equal(list.sizeSync(), 2);
+    test.done();
+  },
+
+  "cyclic object throws": function(test) {
+    var obj = { name: "bob" };
+    obj.self = obj;
+    test.throws(function() {
+      java.newInstanceSync("java.util.HashMap", obj);
+    }, TypeError);
+    var list = [ "a" ];
+    list.push({ items: list });
+    test.throws(function() {
+      java.callStaticMethodSync("java.util.Arrays", "asList", list);
+    }, TypeError);
+    test.done();
+  },
+
+  "shared objects are not cycles": function(test) {
+    var child = { value: 1 };
+    var map = java.newInstanceSync("java.util.HashMap", { a: child, b: child });
+    test.equal(map.getSync("a").getSync("value"), 1);
+    test.equal(map.getSync("b").getSync("value"), 1);
+    test.done();
+  }
+});
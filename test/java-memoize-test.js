@@ -0,0 +1,93 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Memoize'] = nodeunit.testCase({
+  tearDown: function(callback) {
+    java.unmemoize("java.lang.Integer", "parseInt");
+    java.unmemoize("java.lang.System", "nanoTime");
+    callback();
+  },
+
+  "repeated calls are cached": function(test) {
+    java.memoize("java.lang.Integer", "parseInt");
+    test.equal(java.callStaticMethodSync("java.lang.Integer", "parseInt", "42"), 42);
+    test.equal(java.callStaticMethodSync("java.lang.Integer", "parseInt", "42"), 42);
+    test.equal(java.callStaticMethodSync("java.lang.Integer", "parseInt", "43"), 43);
+    var stats = java.getMemoStats()["java.lang.Integer#parseInt"];
+    test.equal(stats.size, 2);
+    test.equal(stats.hits, 1);
+    test.equal(stats.misses, 2);
+    test.done();
+  },
+
+  "async calls share the cache": function(test) {
+    java.memoize("java.lang.Integer", "parseInt");
+    java.callStaticMethod("java.lang.Integer", "parseInt", "7", function(err, result) {
+      test.ok(!err);
+      test.equal(result, 7);
+      var calledBack = false;
+      java.callStaticMethod("java.lang.Integer", "parseInt", "7", function(err, result) {
+        calledBack = true;
+        test.ok(!err);
+        test.equal(result, 7);
+        test.equal(java.getMemoStats()["java.lang.Integer#parseInt"].hits, 1);
+        test.done();
+      });
+      // a cached result still calls back after the call has returned
+      test.ok(!calledBack);
+    });
+  },
+
+  "arguments of different types are different keys": function(test) {
+    java.memoize("java.lang.Integer", "parseInt");
+    test.equal(java.callStaticMethodSync("java.lang.Integer", "parseInt", "10", 16), 16);
+    test.equal(java.callStaticMethodSync("java.lang.Integer", "parseInt", "10", 2), 2);
+    test.equal(java.callStaticMethodSync("java.lang.Integer", "parseInt", "10"), 10);
+    test.equal(java.getMemoStats()["java.lang.Integer#parseInt"].hits, 0);
+    test.done();
+  },
+
+  "the least recently used result is evicted": function(test) {
+    java.memoize("java.lang.Integer", "parseInt", { maxEntries: 2 });
+    java.callStaticMethodSync("java.lang.Integer", "parseInt", "1");
+    java.callStaticMethodSync("java.lang.Integer", "parseInt", "2");
+    java.callStaticMethodSync("java.lang.Integer", "parseInt", "1");
+    java.callStaticMethodSync("java.lang.Integer", "parseInt", "3");
+    var stats = java.getMemoStats()["java.lang.Integer#parseInt"];
+    test.equal(stats.size, 2);
+    test.equal(stats.evictions, 1);
+    java.callStaticMethodSync("java.lang.Integer", "parseInt", "1");
+    test.equal(java.getMemoStats()["java.lang.Integer#parseInt"].hits, 2);
+    test.done();
+  },
+
+  "results expire after the ttl": function(test) {
+    java.memoize("java.lang.System", "nanoTime", { ttl: 20 });
+    var first = java.callStaticMethodSync("java.lang.System", "nanoTime");
+    test.equal(java.callStaticMethodSync("java.lang.System", "nanoTime"), first);
+    setTimeout(function() {
+      test.notEqual(java.callStaticMethodSync("java.lang.System", "nanoTime"), first);
+      test.equal(java.getMemoStats()["java.lang.System#nanoTime"].expirations, 1);
+      test.done();
+    }, 50);
+  },
+
+  "errors are not cached": function(test) {
+    java.memoize("java.lang.Integer", "parseInt");
+    test.throws(function() {
+      java.callStaticMethodSync("java.lang.Integer", "parseInt", "x");
+    });
+    test.equal(java.getMemoStats()["java.lang.Integer#parseInt"].size, 0);
+    test.done();
+  },
+
+  "unmemoize stops caching": function(test) {
+    java.memoize("java.lang.Integer", "parseInt");
+    test.ok(java.unmemoize("java.lang.Integer", "parseInt"));
+    test.ok(!java.unmemoize("java.lang.Integer", "parseInt"));
+    test.equal(java.getMemoStats()["java.lang.Integer#parseInt"], undefined);
+    test.done();
+  }
+});
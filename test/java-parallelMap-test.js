@@ -0,0 +1,78 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Parallel Map'] = nodeunit.testCase({
+  "results keep the order of the inputs": function(test) {
+    var inputs = [];
+    for (var i = 0; i < 50; i++) {
+      inputs.push("" + i);
+    }
+    java.parallelMap("java.lang.Integer", "parseInt", inputs, { concurrency: 3, chunkSize: 7 }, function(err, results) {
+      test.ok(!err);
+      test.equal(results.length, 50);
+      for (var i = 0; i < 50; i++) {
+        test.equal(results[i], i);
+      }
+      test.done();
+    });
+  },
+
+  "entries that are arrays are argument lists": function(test) {
+    java.parallelMap("java.lang.Integer", "parseInt", [["ff", 16], ["10", 2]], function(err, results) {
+      test.ok(!err);
+      test.deepEqual(results, [255, 2]);
+      test.done();
+    });
+  },
+
+  "instance methods are called on the target": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    list.addSync("a");
+    list.addSync("b");
+    list.addSync("c");
+    java.parallelMap(list, "get", [2, 0, 1], { chunkSize: 1 }, function(err, results) {
+      test.ok(!err);
+      test.deepEqual(results, ["c", "a", "b"]);
+      test.done();
+    });
+  },
+
+  "objects are returned wrapped": function(test) {
+    java.parallelMap("java.lang.String", "valueOf", [[true], [false]], function(err, results) {
+      test.ok(!err);
+      test.deepEqual(results, ["true", "false"]);
+      java.parallelMap("java.util.Collections", "singletonList", ["x"], function(err, results) {
+        test.ok(!err);
+        test.equal(results[0].sizeSync(), 1);
+        test.done();
+      });
+    });
+  },
+
+  "an empty input calls back with an empty array": function(test) {
+    java.parallelMap("java.lang.Integer", "parseInt", [], function(err, results) {
+      test.ok(!err);
+      test.deepEqual(results, []);
+      test.done();
+    });
+  },
+
+  "the failing entry is reported": function(test) {
+    java.parallelMap("java.lang.Integer", "parseInt", ["1", "2", "x", "4"], { chunkSize: 2 }, function(err, results) {
+      test.ok(err);
+      test.equal(err.item, 2);
+      test.ok(!results);
+      test.done();
+    });
+  },
+
+  "an unknown class is reported": function(test) {
+    java.parallelMap("com.example.Missing", "run", [1], function(err, results) {
+      test.ok(err);
+      test.ok(/Could not find class/.test(err.message));
+      test.done();
+    });
+  }
+});
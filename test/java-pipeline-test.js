@@ -0,0 +1,75 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Pipeline'] = nodeunit.testCase({
+  "steps use the results of earlier steps": function(test) {
+    var p = java.pipeline();
+    var list = p.newInstance("java.util.ArrayList");
+    p.callMethod(list, "add", "a");
+    p.callMethod(list, "add", "b");
+    var size = p.callMethod(list, "size");
+    p.run(function(err, result) {
+      test.ok(!err);
+      test.equal(result, 2);
+      test.done();
+    });
+  },
+
+  "steps can be passed as arguments": function(test) {
+    var p = java.pipeline();
+    var value = p.callStaticMethod("java.lang.String", "valueOf", 42);
+    p.callStaticMethod("java.lang.Integer", "parseInt", value);
+    p.run(function(err, result) {
+      test.ok(!err);
+      test.equal(result, 42);
+      test.done();
+    });
+  },
+
+  "the results of chosen steps are returned": function(test) {
+    var existing = java.newInstanceSync("java.util.ArrayList");
+    var p = java.pipeline();
+    p.callMethod(existing, "add", "x");
+    var copy = p.newInstance("java.util.ArrayList", existing);
+    var size = p.callMethod(copy, "size");
+    p.run([copy, size], function(err, results) {
+      test.ok(!err);
+      test.equal(results.length, 2);
+      test.equal(results[0].sizeSync(), 1);
+      test.equal(results[1], 1);
+      test.done();
+    });
+  },
+
+  "a failing step stops the pipeline": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    var p = java.pipeline();
+    p.callStaticMethod("java.lang.Integer", "parseInt", "not a number");
+    p.callMethod(list, "add", "never");
+    p.run(function(err, result) {
+      test.ok(err);
+      test.ok(/Step 0/.test(err.message));
+      test.equal(list.sizeSync(), 0);
+      test.done();
+    });
+  },
+
+  "steps of another pipeline are rejected": function(test) {
+    var p1 = java.pipeline();
+    var p2 = java.pipeline();
+    var step = p1.newInstance("java.util.ArrayList");
+    test.throws(function() {
+      p2.callMethod(step, "size");
+    });
+    test.done();
+  },
+
+  "an empty pipeline is an error": function(test) {
+    java.pipeline().run(function(err) {
+      test.ok(err);
+      test.done();
+    });
+  }
+});
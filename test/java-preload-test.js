@@ -0,0 +1,72 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Preload'] = nodeunit.testCase({
+  "preloads classes into the class cache": function(test) {
+    java.evictClass("java.util.TreeMap");
+    java.evictClass("java.util.TreeSet");
+    java.preload(["java.util.TreeMap", "java.util.TreeSet"], function(err, result) {
+      test.ok(!err);
+      test.ok(result.classes["java.util.TreeMap"]);
+      test.ok(result.classes["java.util.TreeSet"].loadMs >= 0);
+      var before = java.getClassCacheStats();
+      java.newInstanceSync("java.util.TreeMap");
+      test.equal(java.getClassCacheStats().hits, before.hits + 1);
+      test.done();
+    });
+  },
+
+  "runs the warm-up method": function(test) {
+    java.preload([
+      { className: "java.lang.Integer", warmup: "parseInt", args: ["42"], iterations: 100 }
+    ], function(err, result) {
+      test.ok(!err);
+      test.equal(result.classes["java.lang.Integer"].iterations, 100);
+      test.done();
+    });
+  },
+
+  "reports classes that fail to load": function(test) {
+    java.preload(["java.util.ArrayList", "does.not.Exist"], { concurrency: 1 }, function(err, result) {
+      test.ok(err);
+      test.equal(err.failures.length, 1);
+      test.equal(err.failures[0].className, "does.not.Exist");
+      test.ok(result.classes["java.util.ArrayList"]);
+      test.done();
+    });
+  },
+
+  "rejects instance warm-up methods": function(test) {
+    java.preload([{ className: "java.lang.String", warmup: "length" }], function(err) {
+      test.ok(err);
+      test.ok(/must be static/.test(err.failures[0].error.message));
+      test.done();
+    });
+  },
+
+  "warm-up methods are added to the method cache": function(test) {
+    java.preload([{ className: "java.lang.Integer", warmup: "toHexString", args: [255] }], function(err) {
+      test.ok(!err);
+      var hits = java.getAsyncStats().methodCache.hits;
+      java.callStaticMethod("java.lang.Integer", "toHexString", 16, function(err, result) {
+        test.ok(!err);
+        test.equal(result, "10");
+        test.equal(java.getAsyncStats().methodCache.hits, hits + 1);
+        test.done();
+      });
+    });
+  },
+
+  "an empty list calls back on a later tick": function(test) {
+    var returned = false;
+    java.preload([], function(err, result) {
+      test.ok(returned);
+      test.ok(!err);
+      test.deepEqual(result.classes, {});
+      test.done();
+    });
+    returned = true;
+  }
+});
@@ -0,0 +1,86 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Read Stream'] = nodeunit.testCase({
+  "input stream": function(test) {
+    var data = java.newArray("byte", toAsciiArray("hello world\n"));
+    var inputStream = java.newInstanceSync("java.io.ByteArrayInputStream", data);
+    var chunks = [];
+    var stream = java.createReadStream(inputStream, { chunkSize: 5 });
+    stream.on('data', function(chunk) {
+      test.ok(Buffer.isBuffer(chunk));
+      chunks.push(chunk.toString());
+    });
+    stream.on('end', function() {
+      test.deepEqual(chunks, [ "hello", " worl", "d\n" ]);
+      test.done();
+    });
+  },
+
+  "reader": function(test) {
+    var reader = java.newInstanceSync("java.io.StringReader", "hello world");
+    var result = "";
+    var stream = java.createReadStream(reader, { encoding: 'utf8' });
+    stream.on('data', function(chunk) {
+      result += chunk;
+    });
+    stream.on('end', function() {
+      test.equal(result, "hello world");
+      test.done();
+    });
+  },
+
+  "iterator": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    for(var i=0; i<5; i++) {
+      list.addSync("item" + i);
+    }
+    var batches = [];
+    var stream = java.createReadStream(list.iteratorSync(), { chunkSize: 2 });
+    stream.on('data', function(batch) {
+      batches.push(batch);
+    });
+    stream.on('end', function() {
+      test.deepEqual(batches, [ [ "item0", "item1" ], [ "item2", "item3" ], [ "item4" ] ]);
+      test.done();
+    });
+  },
+
+  "iterator items that are collections stay wrapped": function(test) {
+    var inner = java.newInstanceSync("java.util.ArrayList");
+    inner.addSync("a");
+    var list = java.newInstanceSync("java.util.ArrayList");
+    list.addSync(inner);
+    var batches = [];
+    var stream = java.createReadStream(list.iteratorSync());
+    stream.on('data', function(batch) {
+      batches.push(batch);
+    });
+    stream.on('end', function() {
+      test.equal(batches.length, 1);
+      test.ok(!Array.isArray(batches[0][0]));
+      test.equal(batches[0][0].sizeSync(), 1);
+      test.done();
+    });
+  },
+
+  "invalid object": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    var stream = java.createReadStream(list);
+    stream.on('error', function(err) {
+      test.ok(err);
+      test.done();
+    });
+    stream.resume();
+  }
+});
+
+function toAsciiArray(str) {
+  var results = [];
+  for(var i=0; i<str.length; i++) {
+    results.push(java.newByte(str.charCodeAt(i)));
+  }
+  return results;
+}
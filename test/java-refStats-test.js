@@ -0,0 +1,55 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Ref Stats'] = nodeunit.testCase({
+  "wrapped objects are counted as live": function(test) {
+    // other wrappers can be finalized at any time, so only the created count is exact
+    var before = java.refStats().globalRefs.created.javaObject;
+    var list = java.newInstanceSync("java.util.ArrayList");
+    var stats = java.refStats();
+    test.equal(stats.globalRefs.created.javaObject, before + 2);
+    test.ok(stats.globalRefs.live.javaObject >= 2);
+    test.ok(list);
+    test.done();
+  },
+
+  "sync calls do not keep baton refs": function(test) {
+    var before = java.refStats().globalRefs.live.baton;
+    for(var i=0; i<100; i++) {
+      java.callStaticMethodSync("java.lang.String", "valueOf", i);
+    }
+    test.equal(java.refStats().globalRefs.live.baton, before);
+    test.done();
+  },
+
+  "async calls release baton refs when done": function(test) {
+    var before = java.refStats().globalRefs.live.baton;
+    java.callStaticMethod("java.lang.String", "valueOf", 1, function(err, result) {
+      test.ok(!err);
+      test.equal(result, "1");
+      test.equal(java.refStats().globalRefs.live.baton, before);
+      test.done();
+    });
+  },
+
+  "large arrays are converted": function(test) {
+    var arr = java.newArray("java.lang.String", new Array(2000).join("a,").split(","));
+    var result = java.callStaticMethodSync("java.util.Arrays", "copyOf", arr, 2000);
+    test.equal(result.length, 2000);
+    test.equal(result[0], "a");
+    test.done();
+  },
+
+  "local frames are tracked": function(test) {
+    java.resetRefStats();
+    java.callStaticMethodSync("java.lang.String", "valueOf", 1);
+    var frames = java.refStats().localFrames;
+    test.ok(frames.pushed > 0);
+    test.equal(frames.failed, 0);
+    test.ok(frames.maxDepth >= 1);
+    test.ok(frames.maxReserved >= frames.maxCapacity);
+    test.done();
+  }
+});
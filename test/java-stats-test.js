@@ -0,0 +1,59 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Stats'] = nodeunit.testCase({
+  setUp: function(callback) {
+    java.resetStats();
+    java.setStatsEnabled(true);
+    callback();
+  },
+
+  tearDown: function(callback) {
+    java.setStatsEnabled(false);
+    callback();
+  },
+
+  "sync calls are counted": function(test) {
+    java.callStaticMethodSync("java.lang.String", "valueOf", 1);
+    java.callStaticMethodSync("java.lang.String", "valueOf", 2);
+    var stats = java.stats()["java.lang.String.valueOf"];
+    test.equal(stats.calls, 2);
+    test.equal(stats.errors, 0);
+    test.equal(stats.execute.count, 2);
+    test.equal(stats.args.count, 2);
+    test.equal(stats.resolve.count, 2);
+    test.equal(stats.queue.count, 0);
+    test.done();
+  },
+
+  "async calls record queue wait": function(test) {
+    var list = java.newInstanceSync("java.util.ArrayList");
+    list.add("a", function(err) {
+      test.ok(!err);
+      var stats = java.stats()["java.util.ArrayList.add"];
+      test.equal(stats.calls, 1);
+      test.equal(stats.queue.count, 1);
+      test.ok(stats.execute.histogram.length > 0);
+      test.done();
+    });
+  },
+
+  "errors are counted": function(test) {
+    test.throws(function() {
+      java.callStaticMethodSync("java.lang.Integer", "parseInt", "not a number");
+    });
+    test.equal(java.stats()["java.lang.Integer.parseInt"].errors, 1);
+    test.done();
+  },
+
+  "disabled stats record nothing": function(test) {
+    java.setStatsEnabled(false);
+    java.callStaticMethodSync("java.lang.String", "valueOf", 3);
+    // resetStats zeroes the entries of methods already called, it does not remove them
+    var stats = java.stats()["java.lang.String.valueOf"];
+    test.ok(!stats || stats.calls === 0);
+    test.done();
+  }
+});
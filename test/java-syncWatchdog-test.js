@@ -0,0 +1,53 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Sync Watchdog'] = nodeunit.testCase({
+  tearDown: function(callback) {
+    java.setSyncWatchdog(null);
+    java.getBlockedSyncCalls();
+    callback();
+  },
+
+  "slow sync call is reported with a java stack": function(test) {
+    java.setSyncWatchdog({ thresholdMs: 50 });
+    java.callStaticMethodSync("java.lang.Thread", "sleep", 300);
+    var reports = java.getBlockedSyncCalls();
+    test.equal(reports.length, 1);
+    test.equal(reports[0].className, "java.lang.Thread");
+    test.equal(reports[0].methodName, "sleep");
+    test.ok(reports[0].durationMs >= 250);
+    test.ok(reports[0].javaStack.indexOf("java.lang.Thread.sleep") >= 0);
+    test.equal(java.getBlockedSyncCalls().length, 0);
+    test.done();
+  },
+
+  "fast sync calls are not reported": function(test) {
+    java.setSyncWatchdog({ thresholdMs: 1000 });
+    java.callStaticMethodSync("java.lang.String", "valueOf", 1);
+    test.equal(java.getBlockedSyncCalls().length, 0);
+    test.done();
+  },
+
+  "onBlocked is called after the call returns": function(test) {
+    var returned = false;
+    java.setSyncWatchdog({
+      thresholdMs: 20,
+      onBlocked: function(report) {
+        test.ok(returned);
+        test.equal(report.methodName, "sleep");
+        test.done();
+      }
+    });
+    java.callStaticMethodSync("java.lang.Thread", "sleep", 100);
+    returned = true;
+  },
+
+  "invalid threshold": function(test) {
+    test.throws(function() {
+      java.setSyncWatchdog({ thresholdMs: -1 });
+    });
+    test.done();
+  }
+});
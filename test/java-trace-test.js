@@ -0,0 +1,39 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Trace'] = nodeunit.testCase({
+  "trace contains call phases": function(test) {
+    java.startTracing();
+    var list = java.newInstanceSync("java.util.ArrayList");
+    list.add("a", function(err) {
+      test.ok(!err);
+      var trace = JSON.parse(java.stopTracing());
+      var names = trace.traceEvents.map(function(event) { return event.name; });
+      test.ok(names.indexOf("execute") >= 0);
+      test.ok(names.indexOf("queue") >= 0);
+      test.ok(names.indexOf("results") >= 0);
+      var threads = {};
+      trace.traceEvents.forEach(function(event) {
+        if(event.name == "queue") {
+          test.equal(event.args.detail, "java.util.ArrayList.add");
+        }
+        threads[event.tid] = true;
+      });
+      test.ok(Object.keys(threads).length >= 2);
+      test.done();
+    });
+  },
+
+  "nothing is recorded after stopping": function(test) {
+    java.startTracing();
+    java.stopTracing();
+    java.callStaticMethodSync("java.lang.String", "valueOf", 1);
+    java.startTracing();
+    var trace = JSON.parse(java.stopTracing());
+    var events = trace.traceEvents.filter(function(event) { return event.ph == "X"; });
+    test.equal(events.length, 0);
+    test.done();
+  }
+});
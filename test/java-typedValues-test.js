@@ -0,0 +1,96 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Typed Values'] = nodeunit.testCase({
+  "long": function(test) {
+    test.equal(java.callStaticMethodSync("java.lang.Long", "toString", java.long("9007199254740993")), "9007199254740993");
+    test.equal(java.callStaticMethodSync("java.lang.Long", "toString", java.long(42)), "42");
+    test.equal(java.long(42).valueOf(), 42);
+    test.done();
+  },
+
+  "float, short and char": function(test) {
+    test.equal(java.callStaticMethodSync("java.lang.Float", "toString", java.float(1.5)), "1.5");
+    test.equal(java.callStaticMethodSync("java.lang.Short", "toString", java.short(12)), "12");
+    test.equal(java.callStaticMethodSync("java.lang.Character", "isDigit", java.char("7")), true);
+    test.equal(java.callStaticMethodSync("java.lang.Character", "toString", java.char(65)), "A");
+    test.done();
+  },
+
+  "values that do not fit are rejected": function(test) {
+    test.throws(function() { java.short(40000); });
+    test.throws(function() { java.char("ab"); });
+    test.throws(function() { java.long("12x"); });
+    test.throws(function() { java.float("1"); });
+    test.throws(function() { java.long(NaN); });
+    test.throws(function() { java.long(Infinity); });
+    test.throws(function() { java.long(1e20); });
+    test.throws(function() { java.long(1.5); });
+    test.done();
+  },
+
+  "typed values are passed to async calls": function(test) {
+    java.callStaticMethod("java.lang.Long", "toString", java.long("-9007199254740993"), function(err, result) {
+      test.ok(!err);
+      test.equal(result, "-9007199254740993");
+      test.done();
+    });
+  },
+
+  "bound methods take typed values": function(test) {
+    var max = java.getMethod("java.lang.Math", "max", ["long", "long"]);
+    test.equal(max(java.long(3), java.short(7)), 7);
+    test.done();
+  },
+
+  "getMethod with a signature": function(test) {
+    var max = java.getMethod("java.lang.Math", "max", "(DD)D");
+    test.equal(max(1.5, 2.5), 2.5);
+    test.throws(function() {
+      java.getMethod("java.lang.Math", "max", "(DD");
+    }, /Invalid method signature/);
+    test.throws(function() {
+      java.getMethod("java.lang.Math", "max", "(Z)Z");
+    }, /Could not find/);
+    test.done();
+  },
+
+  "signature bound object parameters are checked": function(test) {
+    var unmodifiableList = java.getMethod("java.util.Collections", "unmodifiableList", "(Ljava/util/List;)Ljava/util/List;");
+    test.equal(unmodifiableList(java.newInstanceSync("java.util.ArrayList")).sizeSync(), 0);
+    test.throws(function() {
+      unmodifiableList(java.newInstanceSync("java.util.HashMap"));
+    }, /java\.util\.List/);
+    test.done();
+  },
+
+  "a signature that does not bind calls back after returning": function(test) {
+    var calledBack = false;
+    java.callStaticMethod("java.lang.Math", "max", 3, 7, java.callOptions({ signature: "(Z)Z" }), function(err, result) {
+      calledBack = true;
+      test.ok(err);
+      test.done();
+    });
+    test.ok(!calledBack);
+  },
+
+  "signature call option": function(test) {
+    var options = java.callOptions({ signature: "(JJ)J" });
+    test.equal(java.callStaticMethodSync("java.lang.Math", "max", 3, 7, options), 7);
+    var list = java.newInstanceSync("java.util.ArrayList");
+    var addOptions = java.callOptions({ signature: "(Ljava/lang/Object;)Z" });
+    test.equal(list.addSync("item", addOptions), true);
+    list.add("item2", addOptions, function(err, result) {
+      test.ok(!err);
+      test.equal(result, true);
+      test.equal(list.sizeSync(), 2);
+      java.callStaticMethod("java.lang.Math", "max", 3, 7, options, function(err, result) {
+        test.ok(!err);
+        test.equal(result, 7);
+        test.done();
+      });
+    });
+  }
+});
@@ -0,0 +1,35 @@
+var java = require("../testHelpers").java;
+
+var nodeunit = require("nodeunit");
+var util = require("util");
+
+exports['Java - Write Stream'] = nodeunit.testCase({
+  "write buffers": function(test) {
+    var outputStream = java.newInstanceSync("java.io.ByteArrayOutputStream");
+    var stream = java.createWriteStream(outputStream);
+    stream.write(new Buffer("hello "));
+    stream.write("world");
+    stream.end(new Buffer("\n"));
+    stream.on('close', function() {
+      test.equal(outputStream.toStringSync(), "hello world\n");
+      test.done();
+    });
+  },
+
+  "java errors become stream errors": function(test) {
+    var outputStream = java.newInstanceSync("java.io.PipedOutputStream");
+    var stream = java.createWriteStream(outputStream, { close: false });
+    stream.on('error', function(err) {
+      test.ok(err);
+      test.done();
+    });
+    stream.write(new Buffer("not connected"));
+  },
+
+  "new byte array from buffer": function(test) {
+    var data = java.newArray("byte", new Buffer("abc"));
+    var str = java.newInstanceSync("java.lang.String", data);
+    test.equal(str.toStringSync(), "abc");
+    test.done();
+  }
+});
@@ -0,0 +1,238 @@
+#!/usr/bin/env node
+'use strict';
+
+// Generates src/callStubs.cpp, the table of call stubs exposed as java.stubs (see src/callStub.h).
+//
+// usage: node tools/generate-stubs.js [spec.json] [output.cpp]
+//
+// The spec lists the methods to generate stubs for by class:
+//
+//   {
+//     "classpath": ["lib/widgets.jar"],
+//     "classes": {
+//       "java.lang.Math": ["static max(II)I"],
+//       "com.nearinfinty.Widget": ["resize", { "method": "name", "signature": "()Ljava/lang/String;", "as": "getName" }]
+//     }
+//   }
+//
+// A method is given as "[static ]name(signature)", as an object { method, signature, static, as }, or
+// by name alone. Methods given by name alone are looked up in the compiled class with javap, which
+// must then be on the path, and must not be overloaded. "as" renames the javascript function, which
+// is needed to stub more than one overload of a method.
+
+var fs = require('fs');
+var path = require('path');
+var childProcess = require('child_process');
+
+var root = path.resolve(__dirname, '..');
+var specPath = process.argv[2] || path.join(__dirname, 'stubs.json');
+var outputPath = process.argv[3] || path.join(root, 'src', 'callStubs.cpp');
+
+var PRIMITIVE_TYPES = {
+  Z: 'jboolean',
+  B: 'jbyte',
+  C: 'jchar',
+  S: 'jshort',
+  I: 'jint',
+  J: 'jlong',
+  F: 'jfloat',
+  D: 'jdouble'
+};
+
+function fail(message) {
+  console.error('generate-stubs: ' + message);
+  process.exit(1);
+}
+
+// Splits a JNI signature into the C++ types of its parameters and of its result.
+function parseSignature(signature) {
+  var match = /^\(([^)]*)\)(.+)$/.exec(signature);
+  if (!match) {
+    return null;
+  }
+
+  function readType(str, pos) {
+    var start = pos;
+    while (str[pos] === '[') {
+      pos++;
+    }
+    var c = str[pos];
+    var isArray = pos > start;
+    if (c === 'L') {
+      var end = str.indexOf(';', pos);
+      if (end < 0) {
+        return null;
+      }
+      var name = str.substring(pos, end + 1);
+      return { type: (!isArray && name === 'Ljava/lang/String;') ? 'StubString' : 'jobject', next: end + 1 };
+    }
+    if (!PRIMITIVE_TYPES[c]) {
+      return null;
+    }
+    return { type: isArray ? 'jobject' : PRIMITIVE_TYPES[c], next: pos + 1 };
+  }
+
+  var params = [];
+  var pos = 0;
+  while (pos < match[1].length) {
+    var param = readType(match[1], pos);
+    if (!param) {
+      return null;
+    }
+    params.push(param.type);
+    pos = param.next;
+  }
+
+  var returnType;
+  if (match[2] === 'V') {
+    returnType = 'void';
+  } else {
+    var result = readType(match[2], 0);
+    if (!result || result.next !== match[2].length) {
+      return null;
+    }
+    returnType = result.type;
+  }
+  return { params: params, returnType: returnType };
+}
+
+// Reads the public methods of a compiled class with javap -s. Newer JDKs print "descriptor:", older
+// ones "Signature:", on the line after each declaration.
+function javapMethods(className, classpath) {
+  var args = ['-s', '-public'];
+  if (classpath.length > 0) {
+    args.push('-classpath', classpath.join(path.delimiter));
+  }
+  args.push(className);
+  var output;
+  try {
+    output = childProcess.execFileSync('javap', args, { encoding: 'utf8' });
+  } catch (e) {
+    fail('could not run javap for ' + className + ': ' + e.message);
+  }
+
+  var methods = [];
+  var lines = output.split(/\r?\n/);
+  for (var i = 0; i < lines.length - 1; i++) {
+    var decl = /^\s*(.*?)\b([\w$]+)\([^)]*\)[^;]*;\s*$/.exec(lines[i]);
+    var descriptor = /^\s*(?:descriptor|Signature):\s*(\S+)\s*$/.exec(lines[i + 1]);
+    if (!decl || !descriptor || descriptor[1][0] !== '(') {
+      continue;
+    }
+    // constructors are declared with the qualified class name, which the name pattern stops short of
+    if (/[\w$]\.$/.test(decl[1])) {
+      continue;
+    }
+    methods.push({ name: decl[2], signature: descriptor[1], isStatic: /\bstatic\b/.test(decl[1]) });
+  }
+  return methods;
+}
+
+function resolveEntry(className, entry, classpath, javapCache) {
+  if (typeof entry === 'string') {
+    var match = /^\s*(static\s+)?([\w$]+)(\(.*)?$/.exec(entry);
+    if (!match) {
+      fail('could not read "' + entry + '" of ' + className);
+    }
+    entry = { method: match[2], signature: match[3], 'static': !!match[1] };
+  }
+  if (!entry.method) {
+    fail('a method of ' + className + ' has no name');
+  }
+
+  var stub = {
+    className: className,
+    methodName: entry.method,
+    signature: entry.signature,
+    isStatic: !!entry['static'],
+    jsName: entry.as || entry.method
+  };
+  if (!stub.signature) {
+    javapCache[className] = javapCache[className] || javapMethods(className, classpath);
+    var candidates = javapCache[className].filter(function (method) {
+      return method.name === entry.method;
+    });
+    if (candidates.length === 0) {
+      fail('could not find a public method ' + className + '.' + entry.method);
+    }
+    if (candidates.length > 1) {
+      fail(className + '.' + entry.method + ' is overloaded, give one of these signatures: ' + candidates.map(function (method) {
+        return method.signature;
+      }).join(', '));
+    }
+    stub.signature = candidates[0].signature;
+    stub.isStatic = candidates[0].isStatic;
+  }
+
+  stub.types = parseSignature(stub.signature);
+  if (!stub.types) {
+    fail('invalid signature ' + stub.signature + ' for ' + className + '.' + entry.method);
+  }
+  return stub;
+}
+
+function cppString(str) {
+  return '"' + str.replace(/\\/g, '\\\\').replace(/"/g, '\\"') + '"';
+}
+
+function stubCallback(stub) {
+  var args = 'StubArgsEnd';
+  for (var i = stub.types.params.length - 1; i >= 0; i--) {
+    args = 'StubArgs<' + stub.types.params[i] + ', ' + args + ' >';
+  }
+  return '&' + (stub.isStatic ? 'StaticStub' : 'InstanceStub') + '<' + stub.types.returnType + ', ' + args + ' >::call';
+}
+
+function generate(spec) {
+  var classpath = spec.classpath || [];
+  var javapCache = {};
+  var stubs = [];
+  Object.keys(spec.classes || {}).forEach(function (className) {
+    var jsNames = {};
+    spec.classes[className].forEach(function (entry) {
+      var stub = resolveEntry(className, entry, classpath, javapCache);
+      if (jsNames[stub.jsName]) {
+        fail(className + '.' + stub.jsName + ' is stubbed twice, use "as" to rename one of them');
+      }
+      jsNames[stub.jsName] = true;
+      stubs.push(stub);
+    });
+  });
+
+  var lines = [];
+  lines.push('// Generated by tools/generate-stubs.js from ' + path.relative(root, specPath).replace(/\\/g, '/') + ', do not edit.');
+  lines.push('');
+  lines.push('#include "callStub.h"');
+  lines.push('');
+  if (stubs.length === 0) {
+    lines.push('CallStubInfo callStubTable[1] = { { NULL, NULL, NULL, NULL, false, NULL, NULL, NULL, NULL, NULL } };');
+    lines.push('size_t callStubCount = 0;');
+  } else {
+    lines.push('CallStubInfo callStubTable[] = {');
+    stubs.forEach(function (stub, i) {
+      lines.push('  { ' + [
+        cppString(stub.className),
+        cppString(stub.methodName),
+        cppString(stub.signature),
+        cppString(stub.jsName),
+        stub.isStatic ? 'true' : 'false',
+        stubCallback(stub),
+        'NULL', 'NULL', 'NULL', 'NULL'
+      ].join(', ') + ' }' + (i < stubs.length - 1 ? ',' : ''));
+    });
+    lines.push('};');
+    lines.push('');
+    lines.push('size_t callStubCount = sizeof(callStubTable) / sizeof(callStubTable[0]);');
+  }
+  lines.push('');
+  return lines.join('\n');
+}
+
+var spec;
+try {
+  spec = JSON.parse(fs.readFileSync(specPath, 'utf8'));
+} catch (e) {
+  fail('could not read ' + specPath + ': ' + e.message);
+}
+fs.writeFileSync(outputPath, generate(spec));
+console.log('generate-stubs: wrote ' + path.relative(process.cwd(), outputPath));